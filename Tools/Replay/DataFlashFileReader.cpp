@@ -1,5 +1,7 @@
 #include "DataFlashFileReader.h"
+#include "LogIndex.h"
 #include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Logger/AP_Logger_Compress.h>
 
 #include <fcntl.h>
 #include <string.h>
@@ -10,6 +12,10 @@
 #include <time.h>
 #include <cinttypes>
 
+#if AP_REPLAY_MMAP_ENABLED
+#include <sys/mman.h>
+#endif
+
 #ifndef PRIu64
 #define PRIu64 "llu"
 #endif
@@ -20,14 +26,42 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if AP_REPLAY_MMAP_ENABLED
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (map_decompressed) {
+        free(map);
+        map = nullptr;
+    }
+#endif
+    if (map != nullptr) {
+        munmap(map, map_size);
+    }
+#endif
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
+#if AP_REPLAY_MMAP_ENABLED
+    if (open_log_mmap(logfile)) {
+        return true;
+    }
+#endif
     fd = AP::FS().open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
     }
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed logs can only be decoded into a mapping
+    uint32_t magic;
+    if (AP::FS().read(fd, &magic, sizeof(magic)) == int32_t(sizeof(magic)) &&
+        magic == LOG_COMPRESSED_BLOCK_MAGIC) {
+        ::printf("Unable to read compressed log %s\n", logfile);
+        AP::FS().close(fd);
+        fd = -1;
+        return false;
+    }
+    AP::FS().lseek(fd, 0, SEEK_SET);
+#endif
     // Get the file size for percentage calculation
     struct stat st;
     if (AP::FS().stat(logfile, &st) == 0) {
@@ -43,6 +77,69 @@ ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
     return ret;
 }
 
+bool AP_LoggerFileReader::seek(uint64_t offset)
+{
+#if AP_REPLAY_MMAP_ENABLED
+    if (map != nullptr) {
+        if (offset > map_size) {
+            return false;
+        }
+        map_ofs = offset;
+        // madvise() needs a page aligned address
+        map_prefetched = offset & ~uint64_t(LOGREADER_MMAP_PREFETCH_SIZE-1);
+        bytes_read = offset;
+        prefetch_mmap();
+        return true;
+    }
+#endif
+    if (offset > INT32_MAX) {
+        // AP_Filesystem can't seek past 2GB
+        return false;
+    }
+    if (AP::FS().lseek(fd, offset, SEEK_SET) != int32_t(offset)) {
+        return false;
+    }
+    bytes_read = offset;
+    return true;
+}
+
+bool AP_LoggerFileReader::seek_to_time(const char *logfile, uint64_t start_us, bool use_index_cache)
+{
+#if AP_REPLAY_MMAP_ENABLED && AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (map_decompressed) {
+        // the index holds offsets into the file as stored
+        ::printf("Seeking is not supported for compressed logs, starting at the beginning\n");
+        return seek(0);
+    }
+#endif
+    LogIndex index;
+    if (!index.load_or_build(logfile, use_index_cache)) {
+        ::printf("Failed to index %s\n", logfile);
+        return false;
+    }
+    uint64_t checkpoint_us;
+    const uint64_t target = index.offset_for_time(start_us, checkpoint_us);
+    if (target == 0) {
+        return seek(0);
+    }
+
+    // process FMT, PARM, the replay messages which are only written
+    // on change and the latest messages of the frequent types, so the
+    // DAL state is complete at the checkpoint
+    for (uint32_t i=0; i<index.num_sparse(); i++) {
+        const uint64_t ofs = index.sparse_offset(i);
+        if (ofs >= target) {
+            break;
+        }
+        if (!seek(ofs) || !update()) {
+            return false;
+        }
+    }
+
+    ::printf("Starting replay at TimeUS=%" PRIu64 " offset=%" PRIu64 "\n", checkpoint_us, target);
+    return seek(target);
+}
+
 void AP_LoggerFileReader::format_type(uint16_t type, char dest[5])
 {
     const struct log_Format &f = formats[type];
@@ -57,8 +154,185 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
     memcpy(dest, packet_counts, sizeof(packet_counts));
 }
 
+#if AP_REPLAY_MMAP_ENABLED
+/*
+  map the whole log into memory. The mapping is private and writable
+  so handlers which modify the message bytes get a copy-on-write page
+  rather than a fault, but in the normal case no data is copied.
+ */
+bool AP_LoggerFileReader::open_log_mmap(const char *logfile)
+{
+    const int mfd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(mfd, &st) != 0 || st.st_size == 0) {
+        ::close(mfd);
+        return false;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, mfd, 0);
+    // the mapping holds its own reference to the file
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    map = (uint8_t *)p;
+    map_size = st.st_size;
+    map_ofs = 0;
+    map_prefetched = 0;
+    file_size = map_size;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    uint32_t magic;
+    if (map_size >= sizeof(magic)) {
+        memcpy(&magic, map, sizeof(magic));
+        if (magic == LOG_COMPRESSED_BLOCK_MAGIC) {
+            if (!decompress_map()) {
+                ::printf("Failed to decompress log\n");
+                munmap(map, map_size);
+                map = nullptr;
+                return false;
+            }
+            return true;
+        }
+    }
+#endif
+    madvise(map, map_size, MADV_SEQUENTIAL);
+    prefetch_mmap();
+    return true;
+}
+
+/*
+  keep the kernel reading ahead of the parser, and drop the pages we
+  have finished with so multi-GB logs don't fill the page cache
+ */
+void AP_LoggerFileReader::prefetch_mmap()
+{
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (map_decompressed) {
+        // already in memory
+        return;
+    }
+#endif
+    if (map_prefetched >= map_size ||
+        map_prefetched > map_ofs + LOGREADER_MMAP_PREFETCH_SIZE/2) {
+        return;
+    }
+    const uint64_t len = MIN(uint64_t(LOGREADER_MMAP_PREFETCH_SIZE), map_size - map_prefetched);
+    madvise(map + map_prefetched, len, MADV_WILLNEED);
+    map_prefetched += len;
+
+    // release everything more than one prefetch window behind us
+    if (map_ofs > LOGREADER_MMAP_PREFETCH_SIZE) {
+        const uint64_t done = (map_ofs - LOGREADER_MMAP_PREFETCH_SIZE) & ~uint64_t(LOGREADER_MMAP_PREFETCH_SIZE-1);
+        if (done > 0) {
+            madvise(map, done, MADV_DONTNEED);
+        }
+    }
+}
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  decode a compressed log into memory and parse that in place of the
+  mapping. Decoding stops at a truncated or corrupt block, so a log
+  cut short by a crash replays up to the last complete block
+ */
+bool AP_LoggerFileReader::decompress_map()
+{
+    // find the decoded size
+    log_compressed_block hdr;
+    uint64_t raw_size = 0;
+    uint64_t ofs = 0;
+    while (map_size - ofs >= sizeof(hdr)) {
+        memcpy(&hdr, &map[ofs], sizeof(hdr));
+        if (hdr.magic != LOG_COMPRESSED_BLOCK_MAGIC ||
+            hdr.data_len > map_size - ofs - sizeof(hdr)) {
+            break;
+        }
+        raw_size += hdr.raw_len;
+        ofs += sizeof(hdr) + hdr.data_len;
+    }
+    uint8_t *raw = (uint8_t *)malloc(MAX(raw_size, uint64_t(1)));
+    if (raw == nullptr) {
+        return false;
+    }
+
+    uint64_t raw_ofs = 0;
+    ofs = 0;
+    while (raw_ofs < raw_size) {
+        memcpy(&hdr, &map[ofs], sizeof(hdr));
+        const int32_t n = AP_Logger_Compress::decode_block(hdr, &map[ofs+sizeof(hdr)], &raw[raw_ofs], hdr.raw_len);
+        if (n < 0) {
+            ::printf("Corrupt compressed block at offset %" PRIu64 "\n", ofs);
+            break;
+        }
+        raw_ofs += n;
+        ofs += sizeof(hdr) + hdr.data_len;
+    }
+    ::printf("Decompressed log: %" PRIu64 " bytes from %" PRIu64 "\n", raw_ofs, map_size);
+
+    munmap(map, map_size);
+    map = raw;
+    map_size = raw_ofs;
+    file_size = map_size;
+    map_decompressed = true;
+    return true;
+}
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+bool AP_LoggerFileReader::update_mmap()
+{
+    if (map_size - map_ofs < 3) {
+        return false;
+    }
+    uint8_t *msg = &map[map_ofs];
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+        printf("bad log header\n");
+        return false;
+    }
+    const uint8_t type = msg[2];
+    packet_counts[type]++;
+
+    if (type == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        if (map_size - map_ofs < sizeof(f)) {
+            return false;
+        }
+        memcpy(&f, msg, sizeof(f));
+        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        map_ofs += sizeof(f);
+        bytes_read += sizeof(f);
+        message_count++;
+        prefetch_mmap();
+        return handle_log_format_msg(f);
+    }
+
+    const struct log_Format &f = formats[type];
+    if (f.length == 0) {
+        // can't just throw these away as the format specifies the
+        // number of bytes in the message
+        ::printf("No format defined for type (%d)\n", type);
+        exit(1);
+    }
+    if (map_size - map_ofs < f.length) {
+        return false;
+    }
+    map_ofs += f.length;
+    bytes_read += f.length;
+    message_count++;
+    prefetch_mmap();
+    return handle_msg(f, msg);
+}
+#endif  // AP_REPLAY_MMAP_ENABLED
+
 bool AP_LoggerFileReader::update()
 {
+#if AP_REPLAY_MMAP_ENABLED
+    if (map != nullptr) {
+        return update_mmap();
+    }
+#endif
+
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
         return false;
@@ -4,6 +4,13 @@
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+#ifndef AP_REPLAY_MMAP_ENABLED
+#define AP_REPLAY_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// amount of the mapped log to ask the kernel to read ahead of the parser
+#define LOGREADER_MMAP_PREFETCH_SIZE (4U*1024U*1024U)
+
 class AP_LoggerFileReader
 {
 public:
@@ -14,6 +21,14 @@ public:
     bool open_log(const char *logfile);
     bool update();
 
+    // move to a message boundary at offset in the log
+    bool seek(uint64_t offset);
+
+    // use the log index to skip to a checkpoint at or before
+    // start_us, first processing the messages which are only
+    // written when they change
+    bool seek_to_time(const char *logfile, uint64_t start_us, bool use_index_cache);
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
@@ -29,6 +44,26 @@ protected:
 private:
     ssize_t read_input(void *buf, size_t count);
 
+#if AP_REPLAY_MMAP_ENABLED
+    bool open_log_mmap(const char *logfile);
+    bool update_mmap();
+    void prefetch_mmap();
+
+    // log file mapped into memory; messages are handed to the
+    // handlers as pointers into this mapping
+    uint8_t *map = nullptr;
+    uint64_t map_size = 0;
+    uint64_t map_ofs = 0;
+    uint64_t map_prefetched = 0;
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed logs are decoded into a heap buffer which replaces
+    // the mapping
+    bool decompress_map();
+    bool map_decompressed = false;
+#endif
+#endif
+
     uint64_t bytes_read = 0;
     uint64_t file_size = 0; // Total size of the log file
     uint32_t message_count = 0;
@@ -0,0 +1,341 @@
+#include "LogIndex.h"
+
+#include <AP_Filesystem/AP_Filesystem.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define LOGINDEX_READ_BUFFER_SIZE 65536U
+
+LogIndex::~LogIndex()
+{
+    reset();
+}
+
+void LogIndex::reset()
+{
+    delete[] _checkpoints;
+    _checkpoints = nullptr;
+    _num_checkpoints = 0;
+    _max_checkpoints = 0;
+    delete[] _sparse;
+    _sparse = nullptr;
+    _num_sparse = 0;
+    memset(_type_count, 0, sizeof(_type_count));
+}
+
+bool LogIndex::load_or_build(const char *logfile, bool use_cache)
+{
+    struct stat st;
+    if (AP::FS().stat(logfile, &st) != 0) {
+        return false;
+    }
+    _log_size = st.st_size;
+    _log_mtime = st.st_mtime;
+
+    char *idxname = nullptr;
+    if (asprintf(&idxname, "%s.idx", logfile) == -1) {
+        return false;
+    }
+
+    bool ret = use_cache && load(idxname);
+    if (!ret) {
+        ::printf("Building index for %s\n", logfile);
+        ret = build(logfile);
+        if (ret && use_cache && !save(idxname)) {
+            ::printf("Failed to save index %s\n", idxname);
+        }
+    }
+    if (ret) {
+        ::printf("Index: %u checkpoints, %u sparse messages\n",
+                 unsigned(_num_checkpoints), unsigned(_num_sparse));
+    }
+    free(idxname);
+    return ret;
+}
+
+bool LogIndex::add_checkpoint(uint64_t time_us, uint64_t offset)
+{
+    if (_num_checkpoints == _max_checkpoints) {
+        const uint32_t new_max = MAX(_max_checkpoints*2, 1024U);
+        Checkpoint *c = NEW_NOTHROW Checkpoint[new_max];
+        if (c == nullptr) {
+            return false;
+        }
+        if (_checkpoints != nullptr) {
+            memcpy(c, _checkpoints, _num_checkpoints*sizeof(Checkpoint));
+            delete[] _checkpoints;
+        }
+        _checkpoints = c;
+        _max_checkpoints = new_max;
+    }
+    _checkpoints[_num_checkpoints].time_us = time_us;
+    _checkpoints[_num_checkpoints].offset = offset;
+    _num_checkpoints++;
+    return true;
+}
+
+// sort comparison for file offsets
+int LogIndex::compare_offsets(const void *a, const void *b)
+{
+    const uint64_t oa = *(const uint64_t *)a;
+    const uint64_t ob = *(const uint64_t *)b;
+    return oa < ob ? -1 : (oa > ob ? 1 : 0);
+}
+
+// index every message of the rare types and the thinned messages of the rest
+bool LogIndex::keep_candidate(uint8_t type, bool thinned) const
+{
+    const bool rare = type == LOG_FORMAT_MSG || _type_count[type] <= LOGINDEX_MAX_SPARSE_PER_TYPE;
+    return rare != thinned;
+}
+
+/*
+  scan the log message headers to build the index. Only the FMT and
+  RFRH message bodies are decoded
+ */
+bool LogIndex::build(const char *logfile)
+{
+    reset();
+
+    auto &fs = AP::FS();
+    const int fd = fs.open(logfile, O_RDONLY, true);
+    if (fd == -1) {
+        return false;
+    }
+
+    uint8_t *buf = NEW_NOTHROW uint8_t[LOGINDEX_READ_BUFFER_SIZE];
+
+    // candidate sparse messages. Every message of a type is a
+    // candidate until the type turns out to be frequent, and the last
+    // few before each checkpoint are thinned candidates. Only one set
+    // is kept for each type at the end
+    struct Candidate {
+        uint64_t offset;
+        uint8_t type;
+        bool thinned;
+    };
+    uint32_t max_candidates = 4096;
+    uint32_t num_candidates = 0;
+    Candidate *candidates = NEW_NOTHROW Candidate[max_candidates];
+
+    // the last messages of each type since the last checkpoint
+    uint64_t (*recent)[LOGINDEX_SPARSE_PER_INTERVAL] = NEW_NOTHROW uint64_t[256][LOGINDEX_SPARSE_PER_INTERVAL];
+    uint32_t num_recent[256] {};
+
+    auto add_candidate = [&](uint64_t offset, uint8_t type, bool thinned) {
+        if (num_candidates == max_candidates) {
+            Candidate *c = NEW_NOTHROW Candidate[max_candidates*2];
+            if (c == nullptr) {
+                return false;
+            }
+            memcpy(c, candidates, num_candidates*sizeof(Candidate));
+            delete[] candidates;
+            candidates = c;
+            max_candidates *= 2;
+        }
+        candidates[num_candidates].offset = offset;
+        candidates[num_candidates].type = type;
+        candidates[num_candidates].thinned = thinned;
+        num_candidates++;
+        return true;
+    };
+
+    uint8_t lengths[256] {};
+    lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+    int16_t rfrh_type = -1;
+    uint64_t last_checkpoint_us = 0;
+
+    uint64_t buf_offset = 0;  // file offset of buf[0]
+    uint32_t buf_len = 0;
+    uint32_t ofs = 0;
+    bool eof = false;
+    bool ok = buf != nullptr && candidates != nullptr && recent != nullptr;
+
+    while (ok) {
+        if (!eof && buf_len - ofs < 256) {
+            // refill, keeping any partial message
+            memmove(buf, &buf[ofs], buf_len - ofs);
+            buf_offset += ofs;
+            buf_len -= ofs;
+            ofs = 0;
+            const int32_t n = fs.read(fd, &buf[buf_len], LOGINDEX_READ_BUFFER_SIZE - buf_len);
+            if (n <= 0) {
+                eof = true;
+            } else {
+                buf_len += n;
+            }
+        }
+        if (buf_len - ofs < 3) {
+            break;
+        }
+        const uint8_t *msg = &buf[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            // the reader stops at a corrupt header too
+            break;
+        }
+        const uint8_t type = msg[2];
+        const uint8_t len = lengths[type];
+        if (len == 0 || buf_len - ofs < len) {
+            break;
+        }
+
+        if (type == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            memcpy(&f, msg, sizeof(f));
+            lengths[f.type] = f.length;
+            if (strncmp(f.name, "RFRH", 4) == 0) {
+                rfrh_type = f.type;
+            }
+        } else if (type == rfrh_type) {
+            uint64_t time_us;
+            memcpy(&time_us, &msg[3], sizeof(time_us));
+            if (_num_checkpoints == 0 ||
+                time_us >= last_checkpoint_us + LOGINDEX_CHECKPOINT_INTERVAL_US) {
+                ok = add_checkpoint(time_us, buf_offset + ofs);
+                last_checkpoint_us = time_us;
+                // keep the last messages of each type before the checkpoint
+                for (uint16_t t=0; t<256 && ok; t++) {
+                    const uint32_t n = num_recent[t];
+                    for (uint32_t i=n > LOGINDEX_SPARSE_PER_INTERVAL ? n - LOGINDEX_SPARSE_PER_INTERVAL : 0; i<n && ok; i++) {
+                        ok = add_candidate(recent[t][i % LOGINDEX_SPARSE_PER_INTERVAL], t, true);
+                    }
+                    num_recent[t] = 0;
+                }
+                if (!ok) {
+                    break;
+                }
+            }
+        }
+
+        _type_count[type]++;
+        if (type == LOG_FORMAT_MSG || _type_count[type] <= LOGINDEX_MAX_SPARSE_PER_TYPE) {
+            if (!add_candidate(buf_offset + ofs, type, false)) {
+                ok = false;
+                break;
+            }
+        }
+        recent[type][num_recent[type] % LOGINDEX_SPARSE_PER_INTERVAL] = buf_offset + ofs;
+        num_recent[type]++;
+
+        ofs += len;
+    }
+    fs.close(fd);
+    delete[] buf;
+    delete[] recent;
+
+    if (ok) {
+        for (uint32_t i=0; i<num_candidates; i++) {
+            if (keep_candidate(candidates[i].type, candidates[i].thinned)) {
+                _num_sparse++;
+            }
+        }
+        _sparse = NEW_NOTHROW uint64_t[MAX(_num_sparse, 1U)];
+        ok = _sparse != nullptr;
+    }
+    if (ok) {
+        uint32_t n = 0;
+        for (uint32_t i=0; i<num_candidates; i++) {
+            if (keep_candidate(candidates[i].type, candidates[i].thinned)) {
+                _sparse[n++] = candidates[i].offset;
+            }
+        }
+        // thinned messages are added at the following checkpoint, after
+        // later messages of the rare types
+        qsort(_sparse, _num_sparse, sizeof(uint64_t), compare_offsets);
+    }
+    delete[] candidates;
+
+    if (!ok) {
+        reset();
+    }
+    return ok;
+}
+
+bool LogIndex::load(const char *idxname)
+{
+    auto &fs = AP::FS();
+    const int fd = fs.open(idxname, O_RDONLY, true);
+    if (fd == -1) {
+        return false;
+    }
+
+    reset();
+
+    FileHeader hdr;
+    bool ok = fs.read(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+        hdr.magic == MAGIC &&
+        hdr.version == VERSION &&
+        hdr.log_size == _log_size &&
+        hdr.log_mtime == _log_mtime;
+
+    if (ok) {
+        _checkpoints = NEW_NOTHROW Checkpoint[MAX(hdr.num_checkpoints, 1U)];
+        _sparse = NEW_NOTHROW uint64_t[MAX(hdr.num_sparse, 1U)];
+        ok = _checkpoints != nullptr && _sparse != nullptr;
+    }
+    if (ok) {
+        _num_checkpoints = _max_checkpoints = hdr.num_checkpoints;
+        _num_sparse = hdr.num_sparse;
+        const uint32_t cp_len = _num_checkpoints*sizeof(Checkpoint);
+        const uint32_t sp_len = _num_sparse*sizeof(uint64_t);
+        ok = fs.read(fd, _type_count, sizeof(_type_count)) == sizeof(_type_count) &&
+            fs.read(fd, _checkpoints, cp_len) == int32_t(cp_len) &&
+            fs.read(fd, _sparse, sp_len) == int32_t(sp_len);
+    }
+    fs.close(fd);
+
+    if (!ok) {
+        reset();
+    }
+    return ok;
+}
+
+bool LogIndex::save(const char *idxname) const
+{
+    auto &fs = AP::FS();
+    const int fd = fs.open(idxname, O_WRONLY|O_CREAT|O_TRUNC, true);
+    if (fd == -1) {
+        return false;
+    }
+
+    const FileHeader hdr {
+        MAGIC,
+        VERSION,
+        _log_size,
+        _log_mtime,
+        _num_checkpoints,
+        _num_sparse,
+    };
+    const uint32_t cp_len = _num_checkpoints*sizeof(Checkpoint);
+    const uint32_t sp_len = _num_sparse*sizeof(uint64_t);
+    const bool ok = fs.write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+        fs.write(fd, _type_count, sizeof(_type_count)) == sizeof(_type_count) &&
+        fs.write(fd, _checkpoints, cp_len) == int32_t(cp_len) &&
+        fs.write(fd, _sparse, sp_len) == int32_t(sp_len);
+    fs.close(fd);
+    return ok;
+}
+
+uint64_t LogIndex::offset_for_time(uint64_t time_us, uint64_t &checkpoint_us) const
+{
+    checkpoint_us = 0;
+    if (_num_checkpoints == 0 || _checkpoints[0].time_us > time_us) {
+        return 0;
+    }
+    // bisect for the last checkpoint at or before time_us
+    uint32_t lo = 0;
+    uint32_t hi = _num_checkpoints;
+    while (hi - lo > 1) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (_checkpoints[mid].time_us <= time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    checkpoint_us = _checkpoints[lo].time_us;
+    return _checkpoints[lo].offset;
+}
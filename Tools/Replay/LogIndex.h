@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+  sparse index of a DataFlash log, allowing Replay to start part way
+  through a log.
+
+  The index holds a checkpoint (TimeUS and file offset of an RFRH
+  replay frame header) every LOGINDEX_CHECKPOINT_INTERVAL_US, plus the
+  offsets of every message of the "rare" message types. Rare types are
+  things like FMT, PARM and the replay header messages which AP_DAL
+  only writes when they change; they must all be processed before
+  jumping to a checkpoint so the DAL state is complete.
+
+  Frequent types are thinned by time rather than dropped: the last
+  LOGINDEX_SPARSE_PER_INTERVAL messages of each of them before every
+  checkpoint are indexed, so the latest state of each is processed
+  before jumping to the checkpoint however long the log is.
+
+  The index is cached next to the log as <logfile>.idx and rebuilt if
+  the log size or modification time changes.
+ */
+
+#include "DataFlashFileReader.h"
+
+#define LOGINDEX_CHECKPOINT_INTERVAL_US 1000000ULL
+
+// message types with more than this many instances are thinned to
+// the last few before each checkpoint (FMT messages are always indexed)
+#define LOGINDEX_MAX_SPARSE_PER_TYPE 2000U
+
+// messages of a thinned type indexed before each checkpoint, enough to
+// cover each instance of the multi-instance sensor messages
+#define LOGINDEX_SPARSE_PER_INTERVAL 4U
+
+class LogIndex
+{
+public:
+    LogIndex() {}
+    ~LogIndex();
+
+    CLASS_NO_COPY(LogIndex);
+
+    // load the cached index for logfile, building and saving it if
+    // it is missing or stale
+    bool load_or_build(const char *logfile, bool use_cache);
+
+    // return the offset of the last checkpoint at or before time_us,
+    // and the time of that checkpoint
+    uint64_t offset_for_time(uint64_t time_us, uint64_t &checkpoint_us) const;
+
+    // offsets of rare messages, in file order
+    uint32_t num_sparse() const { return _num_sparse; }
+    uint64_t sparse_offset(uint32_t i) const { return _sparse[i]; }
+
+    // number of messages of a type in the log
+    uint32_t count_for_type(uint8_t type) const { return _type_count[type]; }
+
+    uint32_t num_checkpoints() const { return _num_checkpoints; }
+
+private:
+    struct PACKED Checkpoint {
+        uint64_t time_us;
+        uint64_t offset;
+    };
+
+    struct PACKED FileHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint64_t log_size;
+        int64_t log_mtime;
+        uint32_t num_checkpoints;
+        uint32_t num_sparse;
+    };
+
+    static const uint32_t MAGIC = 0x58444952; // "RIDX"
+    static const uint16_t VERSION = 2;
+
+    bool build(const char *logfile);
+    bool load(const char *idxname);
+    bool save(const char *idxname) const;
+    void reset();
+
+    bool add_checkpoint(uint64_t time_us, uint64_t offset);
+    bool keep_candidate(uint8_t type, bool thinned) const;
+    static int compare_offsets(const void *a, const void *b);
+
+    uint64_t _log_size = 0;
+    int64_t _log_mtime = 0;
+
+    Checkpoint *_checkpoints = nullptr;
+    uint32_t _num_checkpoints = 0;
+    uint32_t _max_checkpoints = 0;
+
+    uint64_t *_sparse = nullptr;
+    uint32_t _num_sparse = 0;
+
+    uint32_t _type_count[256] {};
+};
@@ -55,6 +55,10 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	memset(name, '\0', 5);
 	memcpy(name, f.name, 4);
 
+    if (streq(name, "RFRH")) {
+        rfrh_type = f.type;
+    }
+
     if (msgparser[f.type] != NULL) {
         return true;
     }
@@ -134,6 +138,14 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 }
 
 bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
+    if (replay_end_us != 0 && f.type == rfrh_type) {
+        uint64_t time_us;
+        memcpy(&time_us, &msg[3], sizeof(time_us));
+        if (time_us > replay_end_us) {
+            return false;
+        }
+    }
+
     // emit the output as we receive it:
     AP::logger().WriteBlock(msg, f.length);
 
@@ -20,6 +20,9 @@ public:
 
     static bool in_list(const char *type, const char *list[]);
 
+    // stop replaying at the first replay frame after end_us
+    void set_end_time(uint64_t end_us) { replay_end_us = end_us; }
+
 protected:
 
 private:
@@ -30,6 +33,10 @@ private:
     struct LogStructure *_log_structure;
     uint8_t _log_structure_count;
 
+    // message type of the RFRH replay frame header
+    int16_t rfrh_type = -1;
+    uint64_t replay_end_us = 0;
+
     class LR_MsgHandler *msgparser[LOGREADER_MAX_FORMATS] {};
 };
 
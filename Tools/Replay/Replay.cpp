@@ -126,11 +126,19 @@ void Replay::usage(void)
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
     ::printf("\t--progress  show a progress bar during replay\n");
+    ::printf("\t--start-time SECONDS  start replay at this log time, using the log index\n");
+    ::printf("\t--end-time SECONDS  stop replay at this log time\n");
+    ::printf("\t--warmup SECONDS  start this long before --start-time to let the EKF converge (default 30)\n");
+    ::printf("\t--no-index-cache  don't load or save the log index next to the log\n");
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    START_TIME,
+    END_TIME,
+    WARMUP,
+    NO_INDEX_CACHE,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -143,6 +151,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
         {"progress",        false,  0, 'P'},
+        {"start-time",      true,   0, param_key::START_TIME},
+        {"end-time",        true,   0, param_key::END_TIME},
+        {"warmup",          true,   0, param_key::WARMUP},
+        {"no-index-cache",  false,  0, param_key::NO_INDEX_CACHE},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -182,6 +194,22 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             show_progress = true;
             break;
 
+        case param_key::START_TIME:
+            start_time_s = atof(gopt.optarg);
+            break;
+
+        case param_key::END_TIME:
+            end_time_s = atof(gopt.optarg);
+            break;
+
+        case param_key::WARMUP:
+            warmup_s = atof(gopt.optarg);
+            break;
+
+        case param_key::NO_INDEX_CACHE:
+            use_index_cache = false;
+            break;
+
         case 'h':
         default:
             usage();
@@ -289,6 +317,19 @@ void Replay::setup()
         exit(1);
     }
 
+    if (start_time_s > 0) {
+        // there is no EKF state snapshot, so start early enough
+        // for the filter to converge before the window of interest
+        const float seek_s = MAX(start_time_s - warmup_s, 0.0f);
+        if (!reader.seek_to_time(filename, uint64_t(double(seek_s) * 1.0e6), use_index_cache)) {
+            ::printf("Failed to seek to %.1fs\n", seek_s);
+            exit(1);
+        }
+    }
+    if (end_time_s > 0) {
+        reader.set_end_time(uint64_t(double(end_time_s) * 1.0e6));
+    }
+
     if (replay_force_ekf2) {
         write_EKF_formats();
     }
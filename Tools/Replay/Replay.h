@@ -103,6 +103,12 @@ private:
     bool show_progress = false;  // Flag to determine if progress bar should be shown
     uint32_t last_progress_update = 0; // Last time progress was displayed
 
+    // optional time window to replay, in seconds of log TimeUS
+    float start_time_s = -1;
+    float end_time_s = -1;
+    float warmup_s = 30;
+    bool use_index_cache = true;
+
     void _parse_command_line(uint8_t argc, char * const argv[]);
 
     void set_user_parameters(void);
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+
+# flake8: noqa
+
+'''
+run Replay over a batch of logs in parallel and summarise the EKF3 results
+
+Replay keeps its vehicle, DAL, AHRS and logger state in process-wide
+singletons, so each log is replayed in its own Replay process with its
+own working directory. A pool of worker processes keeps all cores busy.
+'''
+
+import glob
+import multiprocessing
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def find_logs(paths):
+    '''expand a list of files and directories into a list of .bin logs'''
+    ret = []
+    for p in paths:
+        if os.path.isdir(p):
+            for ext in ['*.bin', '*.BIN']:
+                ret.extend(glob.glob(os.path.join(p, '**', ext), recursive=True))
+        else:
+            ret.append(p)
+    return sorted(set(ret))
+
+
+def find_output_log(workdir):
+    '''return the path of the log Replay wrote in workdir'''
+    logdir = os.path.join(workdir, 'logs')
+    try:
+        lastlog = open(os.path.join(logdir, 'LASTLOG.TXT')).read().strip()
+    except OSError:
+        return None
+    path = os.path.join(logdir, '%08u.BIN' % int(lastlog))
+    if not os.path.exists(path):
+        return None
+    return path
+
+
+class InnovStats(object):
+    '''running statistics for one test ratio'''
+    def __init__(self):
+        self.count = 0
+        self.total = 0.0
+        self.max = 0.0
+        self.rejected = 0
+
+    def add(self, v):
+        self.count += 1
+        self.total += v
+        self.max = max(self.max, v)
+        if v > 1.0:
+            self.rejected += 1
+
+    def mean(self):
+        if self.count == 0:
+            return 0.0
+        return self.total / self.count
+
+
+def analyse_output(logfile, divergence_ratio):
+    '''gather EKF3 innovation test ratio statistics from a Replay output log'''
+    from pymavlink import DFReader
+    stats = {}
+    for f in ['SV', 'SP', 'SH', 'SM']:
+        stats[f] = InnovStats()
+    faults = 0
+    diverged = False
+    dfreader = DFReader.DFReader_binary(logfile, zero_time_base=True)
+    while True:
+        m = dfreader.recv_match(type='XKF4')
+        if m is None:
+            break
+        if m.C < 100:
+            # only look at cores replayed by this build
+            continue
+        for f in stats.keys():
+            v = getattr(m, f)
+            stats[f].add(v)
+            if v > divergence_ratio:
+                diverged = True
+        if m.FS != 0:
+            faults += 1
+    return stats, faults, diverged
+
+
+def replay_one(job):
+    '''replay a single log in a private working directory'''
+    (logfile, replay, replay_args, divergence_ratio, keep) = job
+    workdir = tempfile.mkdtemp(prefix='replay-')
+    ret = {
+        'log': logfile,
+        'ok': False,
+        'wall_time': 0.0,
+        'error': None,
+        'stats': None,
+        'faults': 0,
+        'diverged': False,
+    }
+    cmd = [replay] + replay_args + [os.path.abspath(logfile)]
+    tstart = time.time()
+    try:
+        p = subprocess.run(cmd, cwd=workdir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        ret['wall_time'] = time.time() - tstart
+        if p.returncode != 0:
+            ret['error'] = "Replay exited with %d" % p.returncode
+            return ret
+        output = find_output_log(workdir)
+        if output is None:
+            ret['error'] = "no output log"
+            return ret
+        (ret['stats'], ret['faults'], ret['diverged']) = analyse_output(output, divergence_ratio)
+        ret['ok'] = True
+        if keep is not None:
+            dest = os.path.join(keep, os.path.basename(logfile) + '.replay.bin')
+            shutil.copy(output, dest)
+    except Exception as ex:
+        ret['error'] = str(ex)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+    return ret
+
+
+def print_summary(results, csv=None):
+    '''print a summary table of the batch results'''
+    fields = ['SV', 'SP', 'SH', 'SM']
+    header = "%-40s %8s" % ("Log", "Time(s)")
+    for f in fields:
+        header += " %7s %7s" % (f + "avg", f + "max")
+    header += " %6s %4s" % ("Faults", "Div")
+    print(header)
+    for r in results:
+        name = os.path.basename(r['log'])
+        if not r['ok']:
+            print("%-40s %8.1f ERROR: %s" % (name, r['wall_time'], r['error']))
+            continue
+        line = "%-40s %8.1f" % (name, r['wall_time'])
+        for f in fields:
+            line += " %7.3f %7.3f" % (r['stats'][f].mean(), r['stats'][f].max)
+        line += " %6u %4s" % (r['faults'], "YES" if r['diverged'] else "no")
+        print(line)
+
+    if csv is None:
+        return
+    with open(csv, 'w') as f:
+        f.write("log,ok,wall_time,%s,faults,diverged\n" %
+                ",".join(["%s_mean,%s_max,%s_rejected" % (x, x, x) for x in fields]))
+        for r in results:
+            if not r['ok']:
+                f.write("%s,0,%.3f,%s,0,0\n" % (r['log'], r['wall_time'], ",".join(["0,0,0"]*len(fields))))
+                continue
+            cols = []
+            for x in fields:
+                s = r['stats'][x]
+                cols.append("%f,%f,%u" % (s.mean(), s.max, s.rejected))
+            f.write("%s,1,%.3f,%s,%u,%u\n" % (r['log'], r['wall_time'], ",".join(cols),
+                                              r['faults'], 1 if r['diverged'] else 0))
+
+
+if __name__ == '__main__':
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--replay", default="build/sitl/tool/Replay", help="path to Replay binary")
+    parser.add_argument("-j", "--jobs", type=int, default=multiprocessing.cpu_count(), help="number of parallel Replay processes")
+    parser.add_argument("--parm", action='append', default=[], help="set parameter NAME=VALUE for every replay")
+    parser.add_argument("--param-file", default=None, help="load parameters from a file for every replay")
+    parser.add_argument("--force-ekf3", action='store_true', help="force enable EKF3")
+    parser.add_argument("--divergence-ratio", type=float, default=10.0, help="test ratio above which a log is flagged as diverged")
+    parser.add_argument("--csv", default=None, help="write summary as CSV to this file")
+    parser.add_argument("--keep-logs", default=None, help="copy Replay output logs to this directory")
+    parser.add_argument("logs", metavar="LOG", nargs="+", help="log files or directories of logs")
+    args = parser.parse_args()
+
+    replay = os.path.abspath(args.replay)
+    if not os.path.exists(replay):
+        print("Replay binary not found: %s" % replay)
+        sys.exit(1)
+
+    replay_args = []
+    for p in args.parm:
+        replay_args.append("--parm=%s" % p)
+    if args.param_file is not None:
+        replay_args.append("--param-file=%s" % os.path.abspath(args.param_file))
+    if args.force_ekf3:
+        replay_args.append("--force-ekf3")
+
+    keep = None
+    if args.keep_logs is not None:
+        keep = os.path.abspath(args.keep_logs)
+        os.makedirs(keep, exist_ok=True)
+
+    logs = find_logs(args.logs)
+    if len(logs) == 0:
+        print("No logs to process")
+        sys.exit(1)
+    print("Replaying %u logs with %u jobs" % (len(logs), args.jobs))
+
+    jobs = [(log, replay, replay_args, args.divergence_ratio, keep) for log in logs]
+    tstart = time.time()
+    pool = multiprocessing.Pool(processes=args.jobs)
+    results = []
+    for r in pool.imap_unordered(replay_one, jobs):
+        results.append(r)
+        print("[%u/%u] %s %.1fs%s" % (len(results), len(logs), r['log'], r['wall_time'],
+                                      "" if r['ok'] else " ERROR: %s" % r['error']))
+    pool.close()
+    pool.join()
+
+    results.sort(key=lambda r: r['log'])
+    print_summary(results, args.csv)
+
+    failed = len([r for r in results if not r['ok'] or r['diverged']])
+    print("Replayed %u logs in %.1fs, %u failed or diverged" % (len(results), time.time() - tstart, failed))
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,234 @@
+#include <AP_gtest.h>
+
+#include "../LogIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define TEST_RFRH_MSG 200
+#define TEST_IMU_MSG 201
+#define TEST_PARM_MSG 202
+
+// replay frames every 100ms for 10s, each followed by enough IMU
+// messages to make IMU a frequent type
+static const uint16_t NUM_FRAMES = 100;
+static const uint8_t IMU_PER_FRAME = 25;
+static const uint8_t NUM_PARMS = 5;
+// IMU messages indexed before the checkpoints after the first
+static const uint32_t NUM_THINNED = (NUM_FRAMES / 10 - 1) * LOGINDEX_SPARSE_PER_INTERVAL;
+
+static uint64_t frame_time_us(uint16_t frame)
+{
+    return 1000 + frame * 100000ULL;
+}
+
+class LogIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        strcpy(path, "/tmp/test_log_indexXXXXXX");
+        fd = mkstemp(path);
+        ASSERT_NE(fd, -1);
+
+        write_format(LOG_FORMAT_MSG, sizeof(log_Format), "FMT");
+        write_format(TEST_RFRH_MSG, 3+8, "RFRH");
+        write_format(TEST_IMU_MSG, 3+8, "IMU");
+        write_format(TEST_PARM_MSG, 3+8, "PARM");
+        for (uint8_t i = 0; i < NUM_PARMS; i++) {
+            parm_offset[i] = offset;
+            write_msg(TEST_PARM_MSG, i);
+        }
+        for (uint16_t frame = 0; frame < NUM_FRAMES; frame++) {
+            frame_offset[frame] = offset;
+            write_msg(TEST_RFRH_MSG, frame_time_us(frame));
+            for (uint8_t i = 0; i < IMU_PER_FRAME; i++) {
+                write_msg(TEST_IMU_MSG, frame_time_us(frame) + i);
+            }
+        }
+        close(fd);
+    }
+
+    void TearDown() override
+    {
+        unlink(path);
+        char idxname[sizeof(path) + 4];
+        snprintf(idxname, sizeof(idxname), "%s.idx", path);
+        unlink(idxname);
+    }
+
+    void write_format(uint8_t type, uint8_t length, const char *name)
+    {
+        log_Format f {};
+        f.head1 = HEAD_BYTE1;
+        f.head2 = HEAD_BYTE2;
+        f.msgid = LOG_FORMAT_MSG;
+        f.type = type;
+        f.length = length;
+        strncpy(f.name, name, sizeof(f.name));
+        strncpy(f.format, "Q", sizeof(f.format));
+        strncpy(f.labels, "TimeUS", sizeof(f.labels));
+        write_bytes(&f, sizeof(f));
+    }
+
+    void write_msg(uint8_t type, uint64_t value)
+    {
+        uint8_t msg[3+8] { HEAD_BYTE1, HEAD_BYTE2, type };
+        memcpy(&msg[3], &value, sizeof(value));
+        write_bytes(msg, sizeof(msg));
+    }
+
+    void write_bytes(const void *data, size_t len)
+    {
+        ASSERT_EQ(write(fd, data, len), ssize_t(len));
+        offset += len;
+    }
+
+    // read the time of the replay frame at a log offset
+    uint64_t frame_time_at(uint64_t ofs)
+    {
+        FILE *f = fopen(path, "rb");
+        uint8_t msg[3+8] {};
+        if (f == nullptr) {
+            return 0;
+        }
+        fseek(f, ofs, SEEK_SET);
+        const size_t n = fread(msg, 1, sizeof(msg), f);
+        fclose(f);
+        if (n != sizeof(msg) || msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2 || msg[2] != TEST_RFRH_MSG) {
+            return 0;
+        }
+        uint64_t time_us;
+        memcpy(&time_us, &msg[3], sizeof(time_us));
+        return time_us;
+    }
+
+    // offset of the i'th IMU message after a replay frame header
+    uint64_t imu_offset(uint16_t frame, uint8_t i) const
+    {
+        return frame_offset[frame] + (1 + i) * (3+8);
+    }
+
+    static bool in_index(const LogIndex &index, uint64_t ofs)
+    {
+        for (uint32_t i = 0; i < index.num_sparse(); i++) {
+            if (index.sparse_offset(i) == ofs) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    char path[32];
+    int fd = -1;
+    uint64_t offset = 0;
+    uint64_t frame_offset[NUM_FRAMES];
+    uint64_t parm_offset[NUM_PARMS];
+};
+
+TEST_F(LogIndexTest, Build)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.load_or_build(path, false));
+
+    // a checkpoint every second
+    EXPECT_EQ(index.num_checkpoints(), 10U);
+    EXPECT_EQ(index.count_for_type(TEST_RFRH_MSG), NUM_FRAMES);
+    EXPECT_EQ(index.count_for_type(TEST_IMU_MSG), uint32_t(NUM_FRAMES * IMU_PER_FRAME));
+    EXPECT_EQ(index.count_for_type(TEST_PARM_MSG), NUM_PARMS);
+
+    // FMT, PARM and RFRH are rare, IMU is frequent and thinned to the
+    // last few before each checkpoint after the first
+    EXPECT_EQ(index.num_sparse(), 4U + NUM_PARMS + NUM_FRAMES + NUM_THINNED);
+    for (uint8_t i = 0; i < NUM_PARMS; i++) {
+        EXPECT_EQ(index.sparse_offset(4 + i), parm_offset[i]);
+    }
+
+    // in file order
+    for (uint32_t i = 1; i < index.num_sparse(); i++) {
+        EXPECT_LT(index.sparse_offset(i - 1), index.sparse_offset(i));
+    }
+}
+
+// the latest messages of a frequent type are indexed before every
+// checkpoint so seeking anywhere in a long log starts with their state
+TEST_F(LogIndexTest, Thinned)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.load_or_build(path, false));
+
+    for (uint16_t frame = 10; frame < NUM_FRAMES; frame += 10) {
+        // the IMU messages at the end of the frame before the checkpoint
+        for (uint8_t i = IMU_PER_FRAME - LOGINDEX_SPARSE_PER_INTERVAL; i < IMU_PER_FRAME; i++) {
+            EXPECT_TRUE(in_index(index, imu_offset(frame - 1, i))) << "frame " << frame << " imu " << unsigned(i);
+        }
+        EXPECT_FALSE(in_index(index, imu_offset(frame - 1, IMU_PER_FRAME - LOGINDEX_SPARSE_PER_INTERVAL - 1)));
+        EXPECT_FALSE(in_index(index, imu_offset(frame - 2, IMU_PER_FRAME - 1)));
+    }
+}
+
+TEST_F(LogIndexTest, Seek)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.load_or_build(path, false));
+
+    uint64_t checkpoint_us;
+
+    // before the first checkpoint replays from the start
+    EXPECT_EQ(index.offset_for_time(500, checkpoint_us), 0U);
+    EXPECT_EQ(checkpoint_us, 0U);
+
+    // exactly on a checkpoint
+    EXPECT_EQ(index.offset_for_time(frame_time_us(30), checkpoint_us), frame_offset[30]);
+    EXPECT_EQ(checkpoint_us, frame_time_us(30));
+
+    // between checkpoints uses the one before
+    uint64_t ofs = index.offset_for_time(frame_time_us(57), checkpoint_us);
+    EXPECT_EQ(ofs, frame_offset[50]);
+    EXPECT_EQ(checkpoint_us, frame_time_us(50));
+    EXPECT_EQ(frame_time_at(ofs), frame_time_us(50));
+
+    // past the end uses the last checkpoint
+    ofs = index.offset_for_time(60000000, checkpoint_us);
+    EXPECT_EQ(ofs, frame_offset[90]);
+    EXPECT_EQ(frame_time_at(ofs), frame_time_us(90));
+}
+
+// a time window maps to the checkpoints either side of it
+TEST_F(LogIndexTest, TimeWindow)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.load_or_build(path, false));
+
+    uint64_t start_us, end_us;
+    const uint64_t start_ofs = index.offset_for_time(frame_time_us(23), start_us);
+    const uint64_t end_ofs = index.offset_for_time(frame_time_us(48), end_us);
+    EXPECT_EQ(start_us, frame_time_us(20));
+    EXPECT_EQ(end_us, frame_time_us(40));
+    EXPECT_LT(start_ofs, end_ofs);
+    EXPECT_EQ(end_ofs - start_ofs, frame_offset[40] - frame_offset[20]);
+}
+
+// a saved index gives the same answers when loaded again
+TEST_F(LogIndexTest, Cache)
+{
+    uint64_t built_ofs, built_us;
+    {
+        LogIndex index;
+        ASSERT_TRUE(index.load_or_build(path, true));
+        built_ofs = index.offset_for_time(frame_time_us(75), built_us);
+    }
+
+    LogIndex index;
+    ASSERT_TRUE(index.load_or_build(path, true));
+    uint64_t loaded_us;
+    EXPECT_EQ(index.offset_for_time(frame_time_us(75), loaded_us), built_ofs);
+    EXPECT_EQ(loaded_us, built_us);
+    EXPECT_EQ(index.num_checkpoints(), 10U);
+    EXPECT_EQ(index.num_sparse(), 4U + NUM_PARMS + NUM_FRAMES + NUM_THINNED);
+}
+
+AP_GTEST_MAIN()
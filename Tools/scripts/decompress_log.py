@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+
+'''
+convert a log written with LOG_FILE_COMPRESS=1 back to a normal log
+
+./Tools/scripts/decompress_log.py 00000012.BIN 00000012-raw.BIN
+
+A compressed log is a sequence of blocks, each a 16 byte header
+(magic "APLZ", decoded length, data length, type) followed by the
+data, which is either stored or compressed in the LZ4 block format.
+A log closed cleanly ends with an END block holding its decoded size.
+Logs which are not compressed are copied unchanged.
+
+AP_FLAKE8_CLEAN
+'''
+
+import struct
+import sys
+from argparse import ArgumentParser
+
+BLOCK_MAGIC = 0x5A4C5041
+BLOCK_HEADER = struct.Struct('<IIIB3x')
+BLOCK_STORED = 0
+BLOCK_LZ4 = 1
+BLOCK_END = 2
+
+
+def lz4_decompress(data, raw_len):
+    '''decode an LZ4 block'''
+    out = bytearray()
+    ip = 0
+    while ip < len(data):
+        token = data[ip]
+        ip += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            while True:
+                b = data[ip]
+                ip += 1
+                lit_len += b
+                if b != 255:
+                    break
+        out += data[ip:ip+lit_len]
+        ip += lit_len
+        if ip >= len(data):
+            break
+        offset = data[ip] | (data[ip+1] << 8)
+        ip += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad match offset")
+        match_len = token & 0x0F
+        if match_len == 15:
+            while True:
+                b = data[ip]
+                ip += 1
+                match_len += b
+                if b != 255:
+                    break
+        match_len += 4
+        start = len(out) - offset
+        if match_len <= offset:
+            out += out[start:start+match_len]
+        else:
+            # overlapping match repeats the last offset bytes
+            for i in range(match_len):
+                out.append(out[start+i])
+    if len(out) != raw_len:
+        raise ValueError("bad block length")
+    return out
+
+
+def decompress(data):
+    '''decode a compressed log, stopping at a truncated or corrupt block'''
+    out = bytearray()
+    ofs = 0
+    while len(data) - ofs >= BLOCK_HEADER.size:
+        (magic, raw_len, data_len, block_type) = BLOCK_HEADER.unpack_from(data, ofs)
+        if magic != BLOCK_MAGIC or data_len > len(data) - ofs - BLOCK_HEADER.size:
+            print("Truncated log at offset %u" % ofs)
+            break
+        block = data[ofs+BLOCK_HEADER.size:ofs+BLOCK_HEADER.size+data_len]
+        try:
+            if block_type == BLOCK_STORED:
+                out += block
+            elif block_type == BLOCK_LZ4:
+                out += lz4_decompress(block, raw_len)
+            elif block_type == BLOCK_END:
+                if struct.unpack('<I', block)[0] != len(out):
+                    raise ValueError("decoded size doesn't match END block")
+            else:
+                raise ValueError("unknown block type %u" % block_type)
+        except (ValueError, IndexError) as e:
+            print("Corrupt block at offset %u: %s" % (ofs, e))
+            break
+        ofs += BLOCK_HEADER.size + data_len
+    return out
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("infile")
+    parser.add_argument("outfile")
+    args = parser.parse_args()
+
+    with open(args.infile, 'rb') as f:
+        data = f.read()
+    if len(data) >= 4 and struct.unpack_from('<I', data)[0] == BLOCK_MAGIC:
+        out = decompress(data)
+        print("Decompressed %u bytes to %u" % (len(data), len(out)))
+    else:
+        print("%s is not compressed" % args.infile)
+        out = data
+    with open(args.outfile, 'wb') as f:
+        f.write(out)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
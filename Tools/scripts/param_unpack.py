@@ -18,15 +18,39 @@ data = open(args.file,'rb').read()
 last_name = ""
 
 magic = 0x671b
+magic_defaults = 0x671c
+magic_compressed = 0x671d
 
 # header of 6 bytes
 magic2,num_params,total_params = struct.unpack("<HHH", data[0:6])
-if magic != magic2:
+if magic2 not in [magic, magic_defaults, magic_compressed]:
     print("Bad magic 0x%x expected 0x%x" % (magic2, magic))
     sys.exit(1)
 
 data = data[6:]
 
+if magic2 == magic_compressed:
+    # snapshot header then chunks, each stored or LZ4 compressed
+    import os
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    from decompress_log import lz4_decompress
+    snap_id,since,raw_len = struct.unpack("<III", data[0:12])
+    print("Snapshot %08x since %08x" % (snap_id, since))
+    data = data[12:]
+    raw = bytearray()
+    while len(data) >= 4:
+        chunk_raw_len,chunk_data_len = struct.unpack("<HH", data[0:4])
+        chunk = data[4:4+chunk_data_len]
+        data = data[4+chunk_data_len:]
+        if chunk_data_len < chunk_raw_len:
+            raw += lz4_decompress(chunk, chunk_raw_len)
+        else:
+            raw += chunk
+    if len(raw) != raw_len:
+        print("Bad snapshot length %u expected %u" % (len(raw), raw_len))
+        sys.exit(1)
+    data = bytes(raw)
+
 # mapping of data type to type length and format
 data_types = {
     1: (1, 'b'),
@@ -70,7 +94,13 @@ while True:
     data = data[2+name_len+type_len:]
     v, = struct.unpack("<" + type_format, vdata)
     count += 1
-    print("%-16s %f" % (name, float(v)))
+    if flags & 1:
+        # default value follows the value
+        d, = struct.unpack("<" + type_format, data[0:type_len])
+        data = data[type_len:]
+        print("%-16s %f (default %f)" % (name, float(v), float(d)))
+    else:
+        print("%-16s %f" % (name, float(v)))
 
 if count != num_params or count > total_params:
     print("Error: Got %u params expected %u/%u" % (count, num_params, total_params))
@@ -76,6 +76,21 @@ void AP_OADijkstra::Write_Visgraph_point(const uint8_t version, const uint8_t po
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
+
+void AP_OADijkstra::Write_OADijkstra_timing() const
+{
+    const struct log_OADijkstraTiming pkt{
+        LOG_PACKET_HEADER_INIT(LOG_OA_DIJKSTRA_TIMING_MSG),
+        time_us     : AP_HAL::micros64(),
+        version     : _log_visgraph_version,
+        num_points  : uint8_t(total_numpoints()),
+        num_edges   : _fence_visgraph.num_items(),
+        kept        : _visgraph_items_kept,
+        visgraph_us : _visgraph_update_us,
+        path_us     : _path_calc_us,
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+}
 #endif
 
 #if AP_AVOIDANCE_ENABLED
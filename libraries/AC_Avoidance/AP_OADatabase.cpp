@@ -40,6 +40,12 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_INDEX_CELL_SIZE
+    #define AP_OADATABASE_INDEX_CELL_SIZE 5.0f  // width in meters of the spatial index's grid cells
+#endif
+#define AP_OADATABASE_INDEX_BUCKETS_MAX 1024    // maximum number of buckets in the spatial index
+#define AP_OADATABASE_INDEX_NONE        UINT16_MAX  // end of a spatial index bucket's list
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -135,6 +141,11 @@ void AP_OADatabase::init()
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _index.head;
+        delete[] _index.next;
+        _index.head = nullptr;
+        _index.next = nullptr;
+        _index.num_buckets = 0;
         return;
     }
 }
@@ -222,6 +233,77 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+
+    index_init();
+}
+
+// allocate the spatial index, on failure objects are found by checking them all
+void AP_OADatabase::index_init()
+{
+    if (_database.items == nullptr) {
+        return;
+    }
+
+    // roughly one bucket per object
+    uint16_t num_buckets = 16;
+    while ((num_buckets < _database.size) && (num_buckets < AP_OADATABASE_INDEX_BUCKETS_MAX)) {
+        num_buckets *= 2;
+    }
+    _index.head = NEW_NOTHROW uint16_t[num_buckets];
+    _index.next = NEW_NOTHROW uint16_t[_database.size];
+    if ((_index.head == nullptr) || (_index.next == nullptr)) {
+        delete[] _index.head;
+        delete[] _index.next;
+        _index.head = nullptr;
+        _index.next = nullptr;
+        return;
+    }
+    for (uint16_t i=0; i<num_buckets; i++) {
+        _index.head[i] = AP_OADATABASE_INDEX_NONE;
+    }
+    _index.num_buckets = num_buckets;
+}
+
+// returns the grid cell holding a horizontal position (in meters)
+int32_t AP_OADatabase::index_cell(float pos) const
+{
+    return (int32_t)floorf(pos * (1.0f / AP_OADATABASE_INDEX_CELL_SIZE));
+}
+
+// returns the spatial index bucket holding a grid cell
+uint16_t AP_OADatabase::index_bucket(int32_t cell_x, int32_t cell_y) const
+{
+    return (((uint32_t)cell_x * 73856093U) ^ ((uint32_t)cell_y * 19349663U)) & (_index.num_buckets - 1);
+}
+
+// add database object to the spatial index
+void AP_OADatabase::index_add(const uint16_t index)
+{
+    const OA_DbItem &item = _database.items[index];
+    _index.max_radius = MAX(_index.max_radius, item.radius);
+    if (_index.num_buckets == 0) {
+        return;
+    }
+    const uint16_t bucket = index_bucket(index_cell(item.pos.x), index_cell(item.pos.y));
+    _index.next[index] = _index.head[bucket];
+    _index.head[bucket] = index;
+}
+
+// remove database object from the spatial index
+void AP_OADatabase::index_remove(const uint16_t index)
+{
+    if (_index.num_buckets == 0) {
+        return;
+    }
+    const OA_DbItem &item = _database.items[index];
+    uint16_t *link = &_index.head[index_bucket(index_cell(item.pos.x), index_cell(item.pos.y))];
+    while (*link != AP_OADATABASE_INDEX_NONE) {
+        if (*link == index) {
+            *link = _index.next[index];
+            return;
+        }
+        link = &_index.next[*link];
+    }
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -304,20 +386,61 @@ bool AP_OADatabase::process_queue()
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
         // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
+        uint16_t i;
+        if (database_item_find(item, i)) {
+            // refresh may move the object
+            index_remove(i);
+            database_item_refresh(_database.items[i], item);
+            index_add(i);
+            if ((int32_t)(_database.items[i].timestamp_ms - _database.oldest_timestamp_ms) < 0) {
+                _database.oldest_timestamp_ms = _database.items[i].timestamp_ms;
+            }
+        } else {
+            database_item_add(item);
+        }
+    }
+    return (_queue.items->available() > 0);
+}
+
+// return index of the lowest numbered database item which matches item
+// returns false if no item matches
+bool AP_OADatabase::database_item_find(const OA_DbItem &item, uint16_t &index) const
+{
+    // proximity objects match nearby objects so only the buckets around the item need to be checked
+    const float radius = MAX(item.radius, _index.max_radius);
+    const int32_t x0 = index_cell(item.pos.x - radius);
+    const int32_t x1 = index_cell(item.pos.x + radius);
+    const int32_t y0 = index_cell(item.pos.y - radius);
+    const int32_t y1 = index_cell(item.pos.y + radius);
+    const bool use_index = (item.source == OA_DbItem::Source::proximity) &&
+                           (_index.num_buckets > 0) &&
+                           ((uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1) <= _index.num_buckets);
+
+    if (!use_index) {
         for (uint16_t i=0; i<_database.count; i++) {
             if (item_match(_database.items[i], item)) {
-                database_item_refresh(_database.items[i], item);
-                found = true;
-                break;
+                index = i;
+                return true;
             }
         }
+        return false;
+    }
 
-        if (!found) {
-            database_item_add(item);
+    uint16_t lowest = AP_OADATABASE_INDEX_NONE;
+    for (int32_t x=x0; x<=x1; x++) {
+        for (int32_t y=y0; y<=y1; y++) {
+            for (uint16_t i=_index.head[index_bucket(x, y)]; i!=AP_OADATABASE_INDEX_NONE; i=_index.next[i]) {
+                if ((i < lowest) && item_match(_database.items[i], item)) {
+                    lowest = i;
+                }
+            }
         }
     }
-    return (_queue.items->available() > 0);
+    if (lowest == AP_OADATABASE_INDEX_NONE) {
+        return false;
+    }
+    index = lowest;
+    return true;
 }
 
 void AP_OADatabase::database_item_add(const OA_DbItem &item)
@@ -327,6 +450,10 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    index_add(_database.count);
+    if ((_database.count == 0) || ((int32_t)(item.timestamp_ms - _database.oldest_timestamp_ms) < 0)) {
+        _database.oldest_timestamp_ms = item.timestamp_ms;
+    }
     _database.count++;
 }
 
@@ -337,6 +464,8 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    index_remove(index);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
@@ -348,8 +477,10 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
 
     if (index != _database.count) {
         // copy last object in array over expired object
+        index_remove(_database.count);
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        index_add(index);
     }
 }
 
@@ -385,16 +516,101 @@ void AP_OADatabase::database_items_remove_all_expired()
 
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
+
+    // nothing can have expired until the oldest object has
+    if ((_database.count == 0) || (now_ms - _database.oldest_timestamp_ms <= expiry_ms)) {
+        return;
+    }
+
+    // remove expired objects and find the oldest and largest of those left
     uint16_t index = 0;
+    _database.oldest_timestamp_ms = now_ms;
+    _index.max_radius = 0;
     while (index < _database.count) {
-        if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
+        const OA_DbItem &item = _database.items[index];
+        if (now_ms - item.timestamp_ms > expiry_ms) {
             database_item_remove(index);
         } else {
+            if ((int32_t)(item.timestamp_ms - _database.oldest_timestamp_ms) < 0) {
+                _database.oldest_timestamp_ms = item.timestamp_ms;
+            }
+            _index.max_radius = MAX(_index.max_radius, item.radius);
             index++;
         }
     }
 }
 
+// update smallest margin with the margins of the objects in a bucket of the spatial index
+void AP_OADatabase::index_bucket_min_margin(uint16_t bucket, const Vector3f &start, const Vector3f &end, float &smallest_margin) const
+{
+    for (uint16_t i=_index.head[bucket]; i!=AP_OADATABASE_INDEX_NONE; i=_index.next[i]) {
+        const OA_DbItem &item = _database.items[i];
+        const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+        smallest_margin = MIN(smallest_margin, m);
+    }
+}
+
+// calculate the smallest margin between the line segment from start to end and any object in the database
+// margin is the distance from the segment to the object's position minus the object's radius
+// start and end are offsets in meters from the EKF origin
+// returns false if the database is empty
+bool AP_OADatabase::get_min_margin(const Vector3f &start, const Vector3f &end, float &margin) const
+{
+    if (!healthy() || (_database.count == 0)) {
+        return false;
+    }
+
+    // grid cells touching the segment's horizontal extent
+    const int32_t x0 = index_cell(MIN(start.x, end.x));
+    const int32_t x1 = index_cell(MAX(start.x, end.x));
+    const int32_t y0 = index_cell(MIN(start.y, end.y));
+    const int32_t y1 = index_cell(MAX(start.y, end.y));
+
+    // search rings of cells outwards from the segment until no object outside them can have a smaller margin
+    // objects outside k rings are more than k cells away horizontally
+    // cells the segment passes close to are searched first so that distant cells can usually be skipped
+    const Vector2f start_xy = start.xy();
+    const Vector2f end_xy = end.xy();
+    const float cell_half_diagonal = AP_OADATABASE_INDEX_CELL_SIZE * 0.7072f;
+    float smallest_margin = FLT_MAX;
+    for (int32_t k=0; _index.num_buckets > 0; k++) {
+        const uint64_t num_cells = (uint64_t)(x1 - x0 + 1 + 2*k) * (uint64_t)(y1 - y0 + 1 + 2*k);
+        if (num_cells > _index.num_buckets) {
+            // checking every object is quicker
+            break;
+        }
+        for (uint8_t pass=(k == 0) ? 0 : 1; pass<2; pass++) {
+            for (int32_t x=x0-k; x<=x1+k; x++) {
+                // inside the ring only the top and bottom cells are new
+                const bool edge = (k == 0) || (x == x0-k) || (x == x1+k);
+                for (int32_t y=y0-k; y<=y1+k; y+= edge ? 1 : (y1-y0+2*k)) {
+                    // skip cell if none of its objects can have a smaller margin
+                    const Vector2f cell_center((x + 0.5f) * AP_OADATABASE_INDEX_CELL_SIZE, (y + 0.5f) * AP_OADATABASE_INDEX_CELL_SIZE);
+                    const float cell_dist = Vector2f::closest_distance_between_line_and_point(start_xy, end_xy, cell_center) - cell_half_diagonal;
+                    if (((k == 0) && ((pass == 0) != (cell_dist <= 0))) || (cell_dist - _index.max_radius >= smallest_margin)) {
+                        continue;
+                    }
+                    index_bucket_min_margin(index_bucket(x, y), start, end, smallest_margin);
+                }
+            }
+        }
+        if (smallest_margin <= (k * AP_OADATABASE_INDEX_CELL_SIZE) - _index.max_radius) {
+            margin = smallest_margin;
+            return true;
+        }
+    }
+
+    // check each object's distance from segment
+    smallest_margin = FLT_MAX;
+    for (uint16_t i=0; i<_database.count; i++) {
+        const OA_DbItem &item = _database.items[i];
+        const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+        smallest_margin = MIN(smallest_margin, m);
+    }
+    margin = smallest_margin;
+    return true;
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
@@ -61,6 +61,12 @@ public:
     // get number of items in the database
     uint16_t database_count() const { return _database.count; }
 
+    // calculate the smallest margin between the line segment from start to end and any object in the database
+    // margin is the distance from the segment to the object's position minus the object's radius
+    // start and end are offsets in meters from the EKF origin
+    // returns false if the database is empty
+    bool get_min_margin(const Vector3f &start, const Vector3f &end, float &margin) const;
+
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
@@ -81,6 +87,20 @@ private:
     void database_item_remove(const uint16_t index);
     void database_items_remove_all_expired();
 
+    // return index of the lowest numbered database item which matches item
+    // returns false if no item matches
+    bool database_item_find(const OA_DbItem &item, uint16_t &index) const;
+
+    // spatial index management
+    void index_init();
+    void index_add(const uint16_t index);
+    void index_remove(const uint16_t index);
+    uint16_t index_bucket(int32_t cell_x, int32_t cell_y) const;
+    int32_t index_cell(float pos) const;
+
+    // update smallest margin with the margins of the objects in a bucket of the spatial index
+    void index_bucket_min_margin(uint16_t bucket, const Vector3f &start, const Vector3f &end, float &smallest_margin) const;
+
     // get bitmask of gcs channels item should be sent to based on its importance
     // returns 0xFF (send to all channels) if should be sent or 0 if it should not be sent
     uint8_t get_send_to_gcs_flags(const OA_DbItemImportance importance) const;
@@ -117,8 +137,18 @@ private:
         OA_DbItem       *items;                             // array of objects in the database
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        uint32_t        oldest_timestamp_ms;                // no object is older than this (used to skip checking for expired objects)
     } _database;
 
+    // spatial hash of database objects by horizontal position so objects near a point or path can be found without checking them all
+    // objects in a bucket are a linked list starting at head[bucket] and continuing through next[index]
+    struct {
+        uint16_t        *head;                              // first object in each bucket
+        uint16_t        *next;                              // next object in the same bucket, one per database object
+        uint16_t        num_buckets;                        // number of buckets (a power of two), zero if index could not be allocated
+        float           max_radius;                         // no object has a larger radius than this (in meters)
+    } _index;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
@@ -26,18 +26,24 @@
 
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Math/crc.h>
 #include <GCS_MAVLink/GCS.h>
 
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
 #define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
+#define OA_DIJKSTRA_HEAP_NOTSET_POS                     UINT16_MAX  // heap position used to indicate a node is not in the heap
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _visgraph_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_item_hash(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_item_hash_new(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _heap(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
 {
@@ -161,6 +167,8 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     // calculate shortest path from current_loc to destination
     if (!_shortest_path_ok) {
         _shortest_path_ok = calc_shortest_path(current_loc, destination, _error_id);
+        Write_OADijkstra_timing();
+        _visgraph_update_us = 0;
         if (!_shortest_path_ok) {
             dest_to_next_dest_clear = _dest_to_next_dest_clear = false;
             report_error(_error_id);
@@ -611,6 +619,34 @@ bool AP_OADijkstra::get_point(uint16_t index, Vector2f &point) const
 
 // returns true if line segment intersects polygon or circular fence
 bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    for (uint16_t i = 0; i < num_fence_items(); i++) {
+        if (intersects_fence_item(i, seg_start, seg_end)) {
+            return true;
+        }
+    }
+
+    // if we got this far then no intersection
+    return false;
+}
+
+// returns number of fence items (inclusion polygons, exclusion polygons, inclusion circles and exclusion circles)
+uint16_t AP_OADijkstra::num_fence_items() const
+{
+    // return immediately if fence is not enabled
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return 0;
+    }
+    return fence->polyfence().get_inclusion_polygon_count() +
+           fence->polyfence().get_exclusion_polygon_count() +
+           fence->polyfence().get_inclusion_circle_count() +
+           fence->polyfence().get_exclusion_circle_count();
+}
+
+// returns true if line segment intersects a single fence item
+// items are numbered across inclusion polygons, exclusion polygons, inclusion circles and exclusion circles in that order
+bool AP_OADijkstra::intersects_fence_item(uint16_t item_idx, const Vector2f &seg_start, const Vector2f &seg_end) const
 {
     // return immediately if fence is not enabled
     const AC_Fence *fence = AC_Fence::get_singleton();
@@ -618,34 +654,28 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
         return false;
     }
 
-    // determine if segment crosses any of the inclusion polygons
+    // determine if segment crosses an inclusion polygon
     uint16_t num_points = 0;
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
-        }
+    if (item_idx < fence->polyfence().get_inclusion_polygon_count()) {
+        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(item_idx, num_points);
+        Vector2f intersection;
+        return (boundary != nullptr) && Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection);
     }
+    item_idx -= fence->polyfence().get_inclusion_polygon_count();
 
-    // determine if segment crosses any of the exclusion polygons
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
-        }
+    // determine if segment crosses an exclusion polygon
+    if (item_idx < fence->polyfence().get_exclusion_polygon_count()) {
+        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(item_idx, num_points);
+        Vector2f intersection;
+        return (boundary != nullptr) && Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection);
     }
+    item_idx -= fence->polyfence().get_exclusion_polygon_count();
 
-    // determine if segment crosses any of the inclusion circles
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
+    // determine if segment crosses an inclusion circle
+    if (item_idx < fence->polyfence().get_inclusion_circle_count()) {
         Vector2f center_pos_cm;
         float radius;
-        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+        if (fence->polyfence().get_inclusion_circle(item_idx, center_pos_cm, radius)) {
             // intersects circle if either start or end is further from the center than the radius
             const float radius_cm_sq = sq(radius * 100.0f) ;
             if ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) {
@@ -655,13 +685,15 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
                 return true;
             }
         }
+        return false;
     }
+    item_idx -= fence->polyfence().get_inclusion_circle_count();
 
-    // determine if segment crosses any of the exclusion circles
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_circle_count(); i++) {
+    // determine if segment crosses an exclusion circle
+    if (item_idx < fence->polyfence().get_exclusion_circle_count()) {
         Vector2f center_pos_cm;
         float radius;
-        if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+        if (fence->polyfence().get_exclusion_circle(item_idx, center_pos_cm, radius)) {
             // calculate distance between circle's center and segment
             const float dist_cm = Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm);
 
@@ -672,13 +704,56 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
         }
     }
 
-    // if we got this far then no intersection
     return false;
 }
 
+// returns a hash of a fence item's shape, used to find the items which changed since the visibility graph was created
+uint32_t AP_OADijkstra::fence_item_hash(uint16_t item_idx) const
+{
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return 0;
+    }
+
+    // the item's type is hashed first so identical shapes of different types differ
+    uint8_t type = 0;
+    uint16_t num_points = 0;
+    const Vector2f* boundary = nullptr;
+    Vector2f center_pos_cm;
+    float radius = 0;
+    if (item_idx < fence->polyfence().get_inclusion_polygon_count()) {
+        boundary = fence->polyfence().get_inclusion_polygon(item_idx, num_points);
+    } else if ((item_idx -= fence->polyfence().get_inclusion_polygon_count()) < fence->polyfence().get_exclusion_polygon_count()) {
+        type = 1;
+        boundary = fence->polyfence().get_exclusion_polygon(item_idx, num_points);
+    } else if ((item_idx -= fence->polyfence().get_exclusion_polygon_count()) < fence->polyfence().get_inclusion_circle_count()) {
+        type = 2;
+        if (!fence->polyfence().get_inclusion_circle(item_idx, center_pos_cm, radius)) {
+            return 0;
+        }
+    } else {
+        type = 3;
+        item_idx -= fence->polyfence().get_inclusion_circle_count();
+        if (!fence->polyfence().get_exclusion_circle(item_idx, center_pos_cm, radius)) {
+            return 0;
+        }
+    }
+
+    uint32_t crc = crc_crc32(0, &type, sizeof(type));
+    if (type < 2) {
+        if (boundary == nullptr) {
+            return 0;
+        }
+        return crc_crc32(crc, (const uint8_t *)boundary, num_points * sizeof(Vector2f));
+    }
+    crc = crc_crc32(crc, (const uint8_t *)&center_pos_cm, sizeof(center_pos_cm));
+    return crc_crc32(crc, (const uint8_t *)&radius, sizeof(radius));
+}
+
 // create visibility graph for all fence (with margin) points
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
+// visibility is only re-checked between points which may be affected by fence items that have changed since the previous graph
 bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
 {
     // exit immediately if fence is not enabled
@@ -689,19 +764,66 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
     }
 
     // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    const uint16_t num_points = total_numpoints();
+    if (num_points >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
+    const uint32_t start_us = AP_HAL::micros();
+
+    // hash each fence item so changes since the previous graph can be found
+    const uint16_t num_items = num_fence_items();
+    if (!_fence_item_hash_new.expand_to_hold(num_items)) {
+        reset_fence_visgraph();
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    for (uint16_t i = 0; i < num_items; i++) {
+        _fence_item_hash_new[i] = fence_item_hash(i);
+    }
 
-    // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
+    // keep the parts of the previous graph which are still valid
+    uint32_t unchanged_points[256/32] {};
+    bool items_removed = false;
+    if (!keep_fence_visgraph_items(num_items, unchanged_points, items_removed)) {
+        _fence_visgraph.clear();
+        memset(unchanged_points, 0, sizeof(unchanged_points));
+        items_removed = false;
+    }
+    _visgraph_items_kept = _fence_visgraph.num_items();
+
+    // removing a fence item may make unchanged points visible to each other
+    // so record which of them are already known to be visible
+    uint32_t *visible = nullptr;
+    if (items_removed) {
+        visible = NEW_NOTHROW uint32_t[(num_points * num_points + 31) / 32]{};
+        if (visible == nullptr) {
+            // check all points instead
+            _fence_visgraph.clear();
+            _visgraph_items_kept = 0;
+            memset(unchanged_points, 0, sizeof(unchanged_points));
+        } else {
+            for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+                const uint32_t bit = _fence_visgraph[i].id1.id_num * num_points + _fence_visgraph[i].id2.id_num;
+                visible[bit / 32] |= 1U << (bit % 32);
+            }
+        }
+    }
+
+    // calculate distance between pairs of points which may have changed visibility
+    for (uint8_t i = 0; i + 1 < num_points; i++) {
         Vector2f start_seg;
         if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
+            const bool i_unchanged = (unchanged_points[i / 32] & (1U << (i % 32))) != 0;
+            for (uint8_t j = i + 1; j < num_points; j++) {
+                if (i_unchanged && (unchanged_points[j / 32] & (1U << (j % 32)))) {
+                    // visibility between unchanged points can only change if a fence item was removed
+                    const uint32_t bit = i * num_points + j;
+                    if ((visible == nullptr) || (visible[bit / 32] & (1U << (bit % 32)))) {
+                        continue;
+                    }
+                }
                 Vector2f end_seg;
                 if (get_point(j, end_seg)) {
                     // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
@@ -710,6 +832,8 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
                                                       {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
                                                       (start_seg - end_seg).length())) {
                             // failure to add a point can only be caused by out-of-memory
+                            delete[] visible;
+                            reset_fence_visgraph();
                             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
                             return false;
                         }
@@ -718,10 +842,129 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
             }
         }
     }
+    delete[] visible;
 
+    // record the points and fence items this graph was created from
+    if (!_visgraph_pts.expand_to_hold(num_points) || !_fence_item_hash.expand_to_hold(num_items)) {
+        reset_fence_visgraph();
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    for (uint8_t i = 0; i < num_points; i++) {
+        get_point(i, _visgraph_pts[i]);
+    }
+    _visgraph_numpoints = num_points;
+    for (uint16_t i = 0; i < num_items; i++) {
+        _fence_item_hash[i] = _fence_item_hash_new[i];
+    }
+    _fence_item_hash_count = num_items;
+
+    // index the graph by point so neighbours can be found quickly
+    // if this fails the shortest path calculation searches the whole graph
+    _fence_visgraph.build_index(num_points);
+
+    _visgraph_update_us = MAX(AP_HAL::micros() - start_us, 1U);
     return true;
 }
 
+// remove items from the fence visibility graph which are affected by fence changes, renumbering the remaining items to match the new fence points
+// unchanged_points is set for each fence point which was also in the previous graph, items_removed is set if any fence item was removed or changed
+// returns false if the previous graph cannot be used
+bool AP_OADijkstra::keep_fence_visgraph_items(uint16_t num_items, uint32_t unchanged_points[], bool &items_removed)
+{
+    if (_visgraph_numpoints == 0) {
+        return false;
+    }
+
+    // fence items which are new or changed since the previous graph
+    uint16_t *added_items = NEW_NOTHROW uint16_t[MAX(num_items, 1)];
+    // new point number of each point in the previous graph
+    uint8_t *new_point_num = NEW_NOTHROW uint8_t[_visgraph_numpoints];
+    if ((added_items == nullptr) || (new_point_num == nullptr)) {
+        delete[] added_items;
+        delete[] new_point_num;
+        return false;
+    }
+
+    uint16_t num_added = 0;
+    for (uint16_t i = 0; i < num_items; i++) {
+        bool found = false;
+        for (uint16_t k = 0; k < _fence_item_hash_count; k++) {
+            if (_fence_item_hash[k] == _fence_item_hash_new[i]) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            added_items[num_added++] = i;
+        }
+    }
+    items_removed = false;
+    for (uint16_t k = 0; k < _fence_item_hash_count; k++) {
+        bool found = false;
+        for (uint16_t i = 0; i < num_items; i++) {
+            if (_fence_item_hash[k] == _fence_item_hash_new[i]) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            items_removed = true;
+            break;
+        }
+    }
+
+    // match points by position, they are renumbered when points before them are added or removed
+    const uint16_t num_points = total_numpoints();
+    for (uint8_t k = 0; k < _visgraph_numpoints; k++) {
+        new_point_num[k] = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+        for (uint8_t j = 0; j < num_points; j++) {
+            Vector2f point;
+            if (!(unchanged_points[j / 32] & (1U << (j % 32))) && get_point(j, point) && (point == _visgraph_pts[k])) {
+                new_point_num[k] = j;
+                unchanged_points[j / 32] |= 1U << (j % 32);
+                break;
+            }
+        }
+    }
+
+    // keep items between unchanged points which are not blocked by a new fence item
+    uint16_t num_kept = 0;
+    for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+        AP_OAVisGraph::VisGraphItem item = _fence_visgraph[i];
+        const uint8_t num1 = new_point_num[item.id1.id_num];
+        const uint8_t num2 = new_point_num[item.id2.id_num];
+        if ((num1 == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) || (num2 == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX)) {
+            continue;
+        }
+        bool blocked = false;
+        for (uint16_t a = 0; a < num_added && !blocked; a++) {
+            blocked = intersects_fence_item(added_items[a], _visgraph_pts[item.id1.id_num], _visgraph_pts[item.id2.id_num]);
+        }
+        if (blocked) {
+            continue;
+        }
+        // keep lower numbered point first
+        item.id1.id_num = MIN(num1, num2);
+        item.id2.id_num = MAX(num1, num2);
+        _fence_visgraph[num_kept++] = item;
+    }
+    _fence_visgraph.truncate(num_kept);
+
+    delete[] added_items;
+    delete[] new_point_num;
+    return true;
+}
+
+// forget the fence visibility graph so the next one is created from scratch
+void AP_OADijkstra::reset_fence_visgraph()
+{
+    _fence_visgraph.clear();
+    _visgraph_numpoints = 0;
+    _fence_item_hash_count = 0;
+    _visgraph_items_kept = 0;
+}
+
 // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
 // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
 // requires create_inclusion_polygon_with_margin to have been run
@@ -758,11 +1001,12 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
 
 // update total distance for all nodes visible from current node
 // curr_node_idx is an index into the _short_path_data array
-void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
+// returns false if out of memory
+bool AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
 {
     // sanity check
     if (curr_node_idx >= _short_path_data_numpoints) {
-        return;
+        return true;
     }
 
     // get current node for convenience
@@ -778,26 +1022,33 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
             continue;
         }
 
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
+        // use the graph's index to find items visible from current node if possible, otherwise search the whole graph
+        const bool use_index = (curr_node.id.id_type == AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) && curr_visgraph.indexed(curr_node.id.id_num);
+        const uint16_t num_items = use_index ? curr_visgraph.num_point_items(curr_node.id.id_num) : curr_visgraph.num_items();
+        for (uint16_t n = 0; n < num_items; n++) {
+            const uint16_t i = use_index ? curr_visgraph.point_item(curr_node.id.id_num, n) : n;
             const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
             // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
             if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
                 AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
                 // find item's id in node array
                 node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
+                if (find_node_from_id(matching_id, item_node_idx) && !_short_path_data[item_node_idx].visited) {
                     // if current node's distance + distance to item is less than item's current distance, update item's distance
                     const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
                     if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
                         // update item's distance and set "distance_from_idx" to current node's index
                         _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
                         _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
+                        if (!heap_update(item_node_idx)) {
+                            return false;
+                        }
                     }
                 }
             }
         }
     }
+    return true;
 }
 
 // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
@@ -832,45 +1083,81 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
+// returns the value used to order nodes in the heap
+// heuristic is simple Euclidean distance from the node to the destination
+// This should be admissible, therefore optimal path is guaranteed
+float AP_OADijkstra::heap_key(node_index node_idx) const
 {
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
+    return _short_path_data[node_idx].distance_cm + _short_path_data[node_idx].heuristic_cm;
+}
+
+// place node at heap position pos
+void AP_OADijkstra::heap_set(uint16_t pos, node_index node_idx)
+{
+    _heap[pos] = node_idx;
+    _short_path_data[node_idx].heap_pos = pos;
+}
+
+// add a node to the heap or move it towards the top after its distance has decreased
+// returns false if out of memory
+bool AP_OADijkstra::heap_update(node_index node_idx)
+{
+    uint16_t pos = _short_path_data[node_idx].heap_pos;
+    if (pos == OA_DIJKSTRA_HEAP_NOTSET_POS) {
+        if (!_heap.expand_to_hold(_heap_numpoints + 1)) {
             return false;
         }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
+        pos = _heap_numpoints++;
+    }
+
+    // move parents down until node's position is found
+    const float key = heap_key(node_idx);
+    while (pos > 0) {
+        const uint16_t parent = (pos - 1) / 2;
+        if (heap_key(_heap[parent]) <= key) {
+            break;
         }
+        heap_set(pos, _heap[parent]);
+        pos = parent;
     }
+    heap_set(pos, node_idx);
+    return true;
+}
 
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
+// remove the node with the lowest distance plus heuristic from the heap
+// returns true if successful and node_idx argument is updated
+bool AP_OADijkstra::heap_pop(node_index &node_idx)
+{
+    if (_heap_numpoints == 0) {
+        return false;
+    }
+    node_idx = _heap[0];
+    _short_path_data[node_idx].heap_pos = OA_DIJKSTRA_HEAP_NOTSET_POS;
+    _heap_numpoints--;
+    if (_heap_numpoints == 0) {
         return true;
     }
-    return false;
+
+    // move last node down from the top until its position is found
+    const node_index last = _heap[_heap_numpoints];
+    const float key = heap_key(last);
+    uint16_t pos = 0;
+    while (true) {
+        uint16_t child = 2 * pos + 1;
+        if (child >= _heap_numpoints) {
+            break;
+        }
+        if ((child + 1 < _heap_numpoints) && (heap_key(_heap[child + 1]) < heap_key(_heap[child]))) {
+            child++;
+        }
+        if (key <= heap_key(_heap[child])) {
+            break;
+        }
+        heap_set(pos, _heap[child]);
+        pos = child;
+    }
+    heap_set(pos, last);
+    return true;
 }
 
 // calculate shortest path from origin to destination
@@ -879,6 +1166,9 @@ bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
 // resulting path is stored in _shortest_path array as vector offsets from EKF origin
 bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id)
 {
+    const uint32_t start_us = AP_HAL::micros();
+    _path_calc_us = 0;
+
     // convert origin and destination to offsets from EKF origin
     if (!origin.get_vector_xy_from_origin_NE_cm(_path_source) ||
         !destination.get_vector_xy_from_origin_NE_cm(_path_destination)) {
@@ -895,6 +1185,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
+    _destination_visgraph.build_index(total_numpoints());
 
     // expand _short_path_data if necessary
     if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
@@ -902,15 +1193,18 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, heap_pos) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, (_path_source - _path_destination).length(), OA_DIJKSTRA_HEAP_NOTSET_POS};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, OA_DIJKSTRA_HEAP_NOTSET_POS};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
+    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, heap_pos)
     for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+        Vector2f point;
+        const float heuristic_cm = get_point(i, point) ? (point - _path_destination).length() : 0;
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, heuristic_cm, OA_DIJKSTRA_HEAP_NOTSET_POS};
     }
+    _heap_numpoints = 0;
 
     // start algorithm from source point
     node_index current_node_idx = 0;
@@ -921,6 +1215,10 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
             _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
             _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            if (!heap_update(node_idx)) {
+                err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+                return false;
+            }
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
@@ -930,7 +1228,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     _short_path_data[current_node_idx].visited = true;
 
     // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
+    while (heap_pop(current_node_idx)) {
         node_index dest_node;
         // See if this next "closest" node is actually the destination
         if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
@@ -938,7 +1236,10 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
             break;
         }
         // update distances to all neighbours of current node
-        update_visible_node_distances(current_node_idx);
+        if (!update_visible_node_distances(current_node_idx)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
 
         // mark current node as visited
         _short_path_data[current_node_idx].visited = true;
@@ -981,6 +1282,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
     }
 
+    _path_calc_us = AP_HAL::micros() - start_us;
     return success;
 }
 
@@ -119,10 +119,28 @@ private:
     // returns true if line segment intersects polygon or circular fence
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
+    // returns number of fence items (inclusion polygons, exclusion polygons, inclusion circles and exclusion circles)
+    uint16_t num_fence_items() const;
+
+    // returns true if line segment intersects a single fence item
+    // items are numbered across inclusion polygons, exclusion polygons, inclusion circles and exclusion circles in that order
+    bool intersects_fence_item(uint16_t item_idx, const Vector2f &seg_start, const Vector2f &seg_end) const;
+
+    // returns a hash of a fence item's shape, used to find the items which changed since the visibility graph was created
+    uint32_t fence_item_hash(uint16_t item_idx) const;
+
     // create visibility graph for all fence (with margin) points
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // remove items from the fence visibility graph which are affected by fence changes, renumbering the remaining items to match the new fence points
+    // unchanged_points is set for each fence point which was also in the previous graph, items_removed is set if any fence item was removed or changed
+    // returns false if the previous graph cannot be used
+    bool keep_fence_visgraph_items(uint16_t num_items, uint32_t unchanged_points[], bool &items_removed);
+
+    // forget the fence visibility graph so the next one is created from scratch
+    void reset_fence_visgraph();
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
@@ -162,6 +180,18 @@ private:
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
 
+    // state of the fence visibility graph, used to update it when the fence changes
+    AP_ExpandingArray<Vector2f> _visgraph_pts;          // fence points (with margin) used to create _fence_visgraph
+    uint8_t _visgraph_numpoints;                        // number of points held in above array
+    AP_ExpandingArray<uint32_t> _fence_item_hash;       // hash of each fence item used to create _fence_visgraph
+    AP_ExpandingArray<uint32_t> _fence_item_hash_new;   // hash of each fence item now
+    uint16_t _fence_item_hash_count;                    // number of items in _fence_item_hash
+
+    // timing stats for logging
+    uint32_t _visgraph_update_us;                       // time taken to update _fence_visgraph, zero if not updated since last logged
+    uint16_t _visgraph_items_kept;                      // number of items kept from previous fence visibility graph
+    uint32_t _path_calc_us;                             // time taken by last call to calc_shortest_path
+
     // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
     // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
     // requires create_polygon_fence_with_margin to have been run
@@ -174,22 +204,39 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance from node to destination
+        uint16_t heap_pos;              // position in _heap or UINT16_MAX if not in heap
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
 
+    // binary heap of reached but unvisited nodes, ordered by distance from source plus heuristic
+    AP_ExpandingArray<node_index> _heap;
+    uint16_t _heap_numpoints;               // number of nodes in _heap
+
+    // returns the value used to order nodes in the heap
+    float heap_key(node_index node_idx) const;
+
+    // add a node to the heap or move it towards the top after its distance has decreased
+    // returns false if out of memory
+    bool heap_update(node_index node_idx);
+
+    // remove the node with the lowest distance plus heuristic from the heap
+    // returns true if successful and node_idx argument is updated
+    bool heap_pop(node_index &node_idx);
+
+    // place node at heap position pos
+    void heap_set(uint16_t pos, node_index node_idx);
+
     // update total distance for all nodes visible from current node
     // curr_node_idx is an index into the _short_path_data array
-    void update_visible_node_distances(node_index curr_node_idx);
+    // returns false if out of memory
+    bool update_visible_node_distances(node_index curr_node_idx);
 
     // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
-    // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
-
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
     uint8_t _path_numpoints;                            // number of points on return path
@@ -213,9 +260,11 @@ private:
     // Logging functions
     void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const;
     void Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const;
+    void Write_OADijkstra_timing() const;
 #else
     void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const {}
     void Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const {}
+    void Write_OADijkstra_timing() const {}
 #endif
     uint8_t _log_num_points;
     uint8_t _log_visgraph_version;
@@ -21,7 +21,9 @@
 
 // constructor initialises expanding array to use 20 elements per chunk
 AP_OAVisGraph::AP_OAVisGraph() :
-    _items(20)
+    _items(20),
+    _index_start(32),
+    _index_items(64)
 {
 }
 
@@ -41,6 +43,57 @@ bool AP_OAVisGraph::add_item(const OAItemID &id1, const OAItemID &id2, float dis
     // add item
     _items[_num_items] = {id1, id2, distance_cm};
     _num_items++;
+    _index_num_points = 0;
+    return true;
+}
+
+// build an index of the items touching each intermediate point
+// returns false if out of memory
+bool AP_OAVisGraph::build_index(uint16_t num_points)
+{
+    _index_num_points = 0;
+
+    // each item appears once for each end
+    if (uint32_t(_num_items) * 2 > UINT16_MAX ||
+        num_points >= UINT16_MAX ||
+        !_index_start.expand_to_hold(num_points+1)) {
+        return false;
+    }
+    for (uint16_t p = 0; p <= num_points; p++) {
+        _index_start[p] = 0;
+    }
+
+    // count the items for each point
+    for (uint16_t i = 0; i < _num_items; i++) {
+        const OAItemID ids[] {_items[i].id1, _items[i].id2};
+        for (const auto &id : ids) {
+            if (id.id_type == OATYPE_INTERMEDIATE_POINT && id.id_num < num_points) {
+                _index_start[id.id_num]++;
+            }
+        }
+    }
+    for (uint16_t p = 1; p < num_points; p++) {
+        _index_start[p] += _index_start[p-1];
+    }
+    if (num_points > 0) {
+        _index_start[num_points] = _index_start[num_points-1];
+    }
+    if (!_index_items.expand_to_hold(_index_start[num_points])) {
+        return false;
+    }
+
+    // fill in from the back so each point's entry in _index_start
+    // ends up at the start of its items
+    for (int32_t i = _num_items-1; i >= 0; i--) {
+        const OAItemID ids[] {_items[i].id1, _items[i].id2};
+        for (const auto &id : ids) {
+            if (id.id_type == OATYPE_INTERMEDIATE_POINT && id.id_num < num_points) {
+                _index_items[--_index_start[id.id_num]] = i;
+            }
+        }
+    }
+
+    _index_num_points = num_points;
     return true;
 }
 
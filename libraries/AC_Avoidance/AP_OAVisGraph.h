@@ -6,6 +6,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_Common/AP_ExpandingArray.h>
+#include <AP_Math/AP_Math.h>
 
 /*
  * Visibility graph used by Dijkstra's algorithm for path planning around fence, stay-out zones and moving obstacles
@@ -41,7 +42,10 @@ public:
     };
 
     // clear all elements from graph
-    void clear() { _num_items = 0; }
+    void clear() { _num_items = 0; _index_num_points = 0; }
+
+    // remove all items after the first num_items
+    void truncate(uint16_t num_items) { _num_items = MIN(_num_items, num_items); _index_num_points = 0; }
 
     // get number of items in visibility graph table
     uint16_t num_items() const { return _num_items; }
@@ -52,11 +56,34 @@ public:
     // allow accessing graph as an array, 0 indexed
     // Note: no protection against out-of-bounds accesses so use with num_items()
     const VisGraphItem& operator[](uint16_t i) const { return _items[i]; }
+    // Note: changing an item this way does not update the index
+    VisGraphItem& operator[](uint16_t i) { return _items[i]; }
+
+    // build an index of the items touching each intermediate point
+    // with an id_num below num_points, so they can be found without
+    // searching the whole graph. Adding or removing items clears the
+    // index. returns false if out of memory
+    bool build_index(uint16_t num_points);
+
+    // returns true if the index covers intermediate point id_num
+    bool indexed(oaid_num id_num) const { return id_num < _index_num_points; }
+
+    // number of items touching an indexed intermediate point
+    uint16_t num_point_items(oaid_num id_num) const { return _index_start[id_num+1] - _index_start[id_num]; }
+
+    // index into the graph of the n'th item touching an indexed intermediate point
+    uint16_t point_item(oaid_num id_num, uint16_t n) const { return _index_items[_index_start[id_num] + n]; }
 
 private:
 
     AP_ExpandingArray<VisGraphItem> _items;
     uint16_t _num_items;
+
+    // items touching each intermediate point are
+    // _index_items[_index_start[id_num]] up to _index_items[_index_start[id_num+1]]
+    AP_ExpandingArray<uint16_t> _index_start;
+    AP_ExpandingArray<uint16_t> _index_items;
+    uint16_t _index_num_points;
 };
 
 #endif  // AP_OAPATHPLANNER_ENABLED
@@ -6,6 +6,7 @@
 #define LOG_IDS_FROM_AVOIDANCE \
     LOG_OA_BENDYRULER_MSG, \
     LOG_OA_DIJKSTRA_MSG, \
+    LOG_OA_DIJKSTRA_TIMING_MSG, \
     LOG_SIMPLE_AVOID_MSG, \
     LOG_OD_VISGRAPH_MSG
 
@@ -67,6 +68,26 @@ struct PACKED log_OADijkstra {
     int32_t oa_lng;
 };
 
+// @LoggerMessage: OADT
+// @Description: Object avoidance (Dijkstra) path planning timing
+// @Field: TimeUS: Time since system startup
+// @Field: Ver: Visgraph version, increments each time the visgraph is re-generated
+// @Field: Pts: Number of fence points in visgraph
+// @Field: Edges: Number of visible pairs of fence points in visgraph
+// @Field: Kept: Number of visible pairs kept from the previous visgraph when it was last re-generated
+// @Field: GUS: Time taken to re-generate the visgraph, zero if it was not re-generated
+// @Field: PUS: Time taken to calculate the shortest path
+struct PACKED log_OADijkstraTiming {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t version;
+    uint8_t num_points;
+    uint16_t num_edges;
+    uint16_t kept;
+    uint32_t visgraph_us;
+    uint32_t path_us;
+};
+
 // @LoggerMessage: SA
 // @Description: Simple Avoidance messages
 // @Field: TimeUS: Time since system startup
@@ -113,6 +134,8 @@ struct PACKED log_OD_Visgraph {
       "OABR","QBBHHHBfLLfLLf","TimeUS,Type,Act,DYaw,Yaw,DP,RChg,Mar,DLt,DLg,DAlt,OLt,OLg,OAlt", "s--ddd-mDUmDUm", "F-------GG0GG0" , true }, \
     { LOG_OA_DIJKSTRA_MSG, sizeof(log_OADijkstra), \
       "OADJ","QBBBBLLLL","TimeUS,State,Err,CurrPoint,TotPoints,DLat,DLng,OALat,OALng", "s----DUDU", "F----GGGG" , true }, \
+    { LOG_OA_DIJKSTRA_TIMING_MSG, sizeof(log_OADijkstraTiming), \
+      "OADT","QBBHHII","TimeUS,Ver,Pts,Edges,Kept,GUS,PUS", "s----ss", "F----FF" , true }, \
     { LOG_SIMPLE_AVOID_MSG, sizeof(log_SimpleAvoid), \
       "SA",  "QBffffffB","TimeUS,State,DVelX,DVelY,DVelZ,MVelX,MVelY,MVelZ,Back", "s-nnnnnn-", "F--------", true }, \
      { LOG_OD_VISGRAPH_MSG, sizeof(log_OD_Visgraph), \
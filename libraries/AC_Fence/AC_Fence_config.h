@@ -12,6 +12,11 @@
 #define AP_FENCE_ENABLED 2
 #endif
 
+// index the edges of large fence polygons when they are loaded
+#ifndef AC_POLYFENCE_INDEX_ENABLED
+#define AC_POLYFENCE_INDEX_ENABLED (HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif
+
 // CODE_REMOVAL
 // ArduPilot 4.6 sends deprecation warnings for FENCE_POINT/FENCE_FETCH_POINT
 // ArduPilot 4.7 stops compiling them in
@@ -0,0 +1,301 @@
+#include "AC_PolyFence_index.h"
+
+#if AP_FENCE_ENABLED
+
+#include <float.h>
+
+// polygons with fewer edges than this only get a bounding box
+#ifndef AC_POLYFENCE_INDEX_MIN_EDGES
+#define AC_POLYFENCE_INDEX_MIN_EDGES 16
+#endif
+
+#define AC_POLYFENCE_INDEX_MAX_BANDS 64
+#define AC_POLYFENCE_INDEX_MAX_GRID  16
+
+bool AC_PolyFence_index::init(const Vector2l *points_lla, const Vector2f *points, uint8_t count)
+{
+    clear();
+
+    _points_lla = points_lla;
+    _points = points;
+    _count = count;
+    if (count == 0) {
+        return true;
+    }
+    // the two polygon functions decide this separately for each array
+    _num_edges_lla = Polygon_complete(points_lla, count) ? count-1 : count;
+    _num_edges_cm = Polygon_complete(points, count) ? count-1 : count;
+
+    _min_lla = _max_lla = points_lla[0];
+    _min_cm = _max_cm = points[0];
+    for (uint8_t i=1; i<count; i++) {
+        _min_lla.x = MIN(_min_lla.x, points_lla[i].x);
+        _min_lla.y = MIN(_min_lla.y, points_lla[i].y);
+        _max_lla.x = MAX(_max_lla.x, points_lla[i].x);
+        _max_lla.y = MAX(_max_lla.y, points_lla[i].y);
+        _min_cm.x = MIN(_min_cm.x, points[i].x);
+        _min_cm.y = MIN(_min_cm.y, points[i].y);
+        _max_cm.x = MAX(_max_cm.x, points[i].x);
+        _max_cm.y = MAX(_max_cm.y, points[i].y);
+    }
+
+#if AC_POLYFENCE_INDEX_ENABLED
+    if (_num_edges_lla >= AC_POLYFENCE_INDEX_MIN_EDGES && !build_bands()) {
+        clear();
+        return false;
+    }
+    if (_num_edges_cm >= AC_POLYFENCE_INDEX_MIN_EDGES && !build_grid()) {
+        clear();
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void AC_PolyFence_index::clear()
+{
+    delete[] _band_start;
+    _band_start = nullptr;
+    delete[] _band_edges;
+    _band_edges = nullptr;
+    delete[] _cell_start;
+    _cell_start = nullptr;
+    delete[] _cell_edges;
+    _cell_edges = nullptr;
+}
+
+/*
+  band of longitude holding lng, which must be within the bounding box
+ */
+uint8_t AC_PolyFence_index::band_of(int32_t lng) const
+{
+    const int64_t width = int64_t(_max_lla.y) - _min_lla.y + 1;
+    return (int64_t(lng) - _min_lla.y) * _num_bands / width;
+}
+
+uint8_t AC_PolyFence_index::cell_x(float x) const
+{
+    return constrain_int32(int32_t((x - _min_cm.x) / _cell_size.x), 0, _grid_x-1);
+}
+
+uint8_t AC_PolyFence_index::cell_y(float y) const
+{
+    return constrain_int32(int32_t((y - _min_cm.y) / _cell_size.y), 0, _grid_y-1);
+}
+
+/*
+  cell boundaries and edge distances are both rounded, so an edge in
+  a cell which hasn't been searched may look slightly closer than the
+  cell is. This is comfortably larger than that error
+ */
+float AC_PolyFence_index::rounding_margin(const Vector2f &pos) const
+{
+    const float extent = MAX(MAX(fabsf(_min_cm.x), fabsf(_max_cm.x)),
+                             MAX(fabsf(_min_cm.y), fabsf(_max_cm.y)));
+    return 1.0f + 1.0e-5f * (extent + fabsf(pos.x) + fabsf(pos.y));
+}
+
+/*
+  fill in the edges for each band of longitude. The edge lists are
+  filled from the back so the start of each band ends up in
+  _band_start without needing a second array of counts
+ */
+bool AC_PolyFence_index::build_bands()
+{
+    _num_bands = constrain_int16(_num_edges_lla / 4, 4, AC_POLYFENCE_INDEX_MAX_BANDS);
+    _band_start = NEW_NOTHROW uint16_t[_num_bands+1]();
+    if (_band_start == nullptr) {
+        return false;
+    }
+    for (uint8_t e=0; e<_num_edges_lla; e++) {
+        const Vector2l &v1 = _points_lla[e];
+        const Vector2l &v2 = _points_lla[(e+1) % _num_edges_lla];
+        const uint8_t b1 = band_of(MAX(v1.y, v2.y));
+        for (uint8_t b=band_of(MIN(v1.y, v2.y)); b<=b1; b++) {
+            _band_start[b]++;
+        }
+    }
+    for (uint8_t b=1; b<_num_bands; b++) {
+        _band_start[b] += _band_start[b-1];
+    }
+    _band_start[_num_bands] = _band_start[_num_bands-1];
+
+    _band_edges = NEW_NOTHROW uint8_t[_band_start[_num_bands]];
+    if (_band_edges == nullptr) {
+        return false;
+    }
+    for (int16_t e=_num_edges_lla-1; e>=0; e--) {
+        const Vector2l &v1 = _points_lla[e];
+        const Vector2l &v2 = _points_lla[(e+1) % _num_edges_lla];
+        const uint8_t b1 = band_of(MAX(v1.y, v2.y));
+        for (uint8_t b=band_of(MIN(v1.y, v2.y)); b<=b1; b++) {
+            _band_edges[--_band_start[b]] = e;
+        }
+    }
+    return true;
+}
+
+/*
+  fill in the edges overlapping each grid cell, the same way as the
+  bands
+ */
+bool AC_PolyFence_index::build_grid()
+{
+    const uint8_t size = constrain_int16(int16_t(ceilf(sqrtf(_num_edges_cm * 0.5f))), 2, AC_POLYFENCE_INDEX_MAX_GRID);
+    _grid_x = _grid_y = size;
+    _cell_size = (_max_cm - _min_cm) / size;
+    _cell_size.x = MAX(_cell_size.x, 1.0f);
+    _cell_size.y = MAX(_cell_size.y, 1.0f);
+
+    const uint16_t num_cells = _grid_x * _grid_y;
+    _cell_start = NEW_NOTHROW uint16_t[num_cells+1]();
+    if (_cell_start == nullptr) {
+        return false;
+    }
+    for (uint8_t e=0; e<_num_edges_cm; e++) {
+        const Vector2f &v1 = _points[e];
+        const Vector2f &v2 = _points[(e+1) % _num_edges_cm];
+        const uint8_t x1 = cell_x(MAX(v1.x, v2.x));
+        const uint8_t y0 = cell_y(MIN(v1.y, v2.y));
+        const uint8_t y1 = cell_y(MAX(v1.y, v2.y));
+        for (uint8_t x=cell_x(MIN(v1.x, v2.x)); x<=x1; x++) {
+            for (uint8_t y=y0; y<=y1; y++) {
+                _cell_start[x*_grid_y + y]++;
+            }
+        }
+    }
+    for (uint16_t c=1; c<num_cells; c++) {
+        _cell_start[c] += _cell_start[c-1];
+    }
+    _cell_start[num_cells] = _cell_start[num_cells-1];
+
+    _cell_edges = NEW_NOTHROW uint8_t[_cell_start[num_cells]];
+    if (_cell_edges == nullptr) {
+        return false;
+    }
+    for (int16_t e=_num_edges_cm-1; e>=0; e--) {
+        const Vector2f &v1 = _points[e];
+        const Vector2f &v2 = _points[(e+1) % _num_edges_cm];
+        const uint8_t x1 = cell_x(MAX(v1.x, v2.x));
+        const uint8_t y0 = cell_y(MIN(v1.y, v2.y));
+        const uint8_t y1 = cell_y(MAX(v1.y, v2.y));
+        for (uint8_t x=cell_x(MIN(v1.x, v2.x)); x<=x1; x++) {
+            for (uint8_t y=y0; y<=y1; y++) {
+                _cell_edges[--_cell_start[x*_grid_y + y]] = e;
+            }
+        }
+    }
+    return true;
+}
+
+bool AC_PolyFence_index::outside(const Vector2l &pos) const
+{
+    // every edge crossing the ray from a point outside the bounding
+    // box crosses it on the same side, so there is an even number of
+    // crossings
+    if (_count == 0 ||
+        pos.x < _min_lla.x || pos.x > _max_lla.x ||
+        pos.y < _min_lla.y || pos.y > _max_lla.y) {
+        return true;
+    }
+    if (_band_start == nullptr) {
+        return Polygon_outside(pos, _points_lla, _count);
+    }
+
+    // only edges which span the longitude of pos can cross its ray
+    const uint8_t b = band_of(pos.y);
+    bool outside = true;
+    for (uint16_t i=_band_start[b]; i<_band_start[b+1]; i++) {
+        const uint8_t e = _band_edges[i];
+        if (Polygon_crossing(pos, _points_lla[e], _points_lla[(e+1) % _num_edges_lla])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+bool AC_PolyFence_index::closest_distance(const Vector2f &pos, float &closest) const
+{
+    // the grid doesn't narrow down the edges for points outside it
+    if (_cell_start == nullptr ||
+        pos.x < _min_cm.x || pos.x > _max_cm.x ||
+        pos.y < _min_cm.y || pos.y > _max_cm.y) {
+        return Polygon_closest_distance_point(_points, _count, pos, closest);
+    }
+
+    // search rings of cells outwards from the one holding pos until
+    // no cell left unsearched can hold a closer edge
+    const float margin = rounding_margin(pos);
+    const int16_t cx = cell_x(pos.x);
+    const int16_t cy = cell_y(pos.y);
+    uint32_t searched[256/32] {};
+    float closest_sq = FLT_MAX;
+    for (int16_t r=0; ; r++) {
+        const int16_t x0 = cx - r;
+        const int16_t x1 = cx + r;
+        const int16_t y0 = cy - r;
+        const int16_t y1 = cy + r;
+        for (int16_t x=MAX(x0, 0); x<=MIN(x1, _grid_x-1); x++) {
+            // inside the ring only the top and bottom cells are new
+            const int16_t ystep = (x == x0 || x == x1) ? 1 : MAX(y1-y0, 1);
+            for (int16_t y=y0; y<=y1; y+=ystep) {
+                if (y < 0 || y >= _grid_y) {
+                    continue;
+                }
+                const uint16_t c = x*_grid_y + y;
+                for (uint16_t i=_cell_start[c]; i<_cell_start[c+1]; i++) {
+                    const uint8_t e = _cell_edges[i];
+                    const uint32_t bit = 1U << (e % 32);
+                    if (searched[e/32] & bit) {
+                        continue;
+                    }
+                    searched[e/32] |= bit;
+                    const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(_points[e], _points[(e+1) % _num_edges_cm], pos);
+                    if (dist_sq < closest_sq) {
+                        closest_sq = dist_sq;
+                    }
+                }
+            }
+        }
+
+        // distance to the nearest side of the searched block which has
+        // cells beyond it
+        float bound = FLT_MAX;
+        if (x0 > 0) {
+            bound = MIN(bound, pos.x - (_min_cm.x + x0 * _cell_size.x));
+        }
+        if (x1 < _grid_x-1) {
+            bound = MIN(bound, _min_cm.x + (x1+1) * _cell_size.x - pos.x);
+        }
+        if (y0 > 0) {
+            bound = MIN(bound, pos.y - (_min_cm.y + y0 * _cell_size.y));
+        }
+        if (y1 < _grid_y-1) {
+            bound = MIN(bound, _min_cm.y + (y1+1) * _cell_size.y - pos.y);
+        }
+        if (bound >= FLT_MAX) {
+            // searched the whole grid
+            break;
+        }
+        bound -= margin;
+        if (bound > 0 && closest_sq < sq(bound)) {
+            break;
+        }
+    }
+
+    closest = sqrtf(closest_sq);
+    return true;
+}
+
+float AC_PolyFence_index::distance_lower_bound(const Vector2f &pos) const
+{
+    if (_count == 0) {
+        return 0;
+    }
+    const float dx = MAX(MAX(_min_cm.x - pos.x, pos.x - _max_cm.x), 0.0f);
+    const float dy = MAX(MAX(_min_cm.y - pos.y, pos.y - _max_cm.y), 0.0f);
+    return norm(dx, dy) - rounding_margin(pos);
+}
+
+#endif // AP_FENCE_ENABLED
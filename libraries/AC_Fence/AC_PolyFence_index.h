@@ -0,0 +1,87 @@
+#pragma once
+
+#include "AC_Fence_config.h"
+
+#if AP_FENCE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  spatial index over a loaded fence polygon.
+
+  The bounding box lets most points be classified without looking at
+  any edges. Polygons with many edges also get a list of the edges in
+  each band of longitude, so the point-in-polygon test only looks at
+  edges which can cross its ray, and a grid of the edges near each
+  cell so the closest edge can be found by searching outwards from the
+  vehicle.
+
+  Results are the same as Polygon_outside() and
+  Polygon_closest_distance_point() on the whole polygon
+ */
+class AC_PolyFence_index {
+public:
+    AC_PolyFence_index() {}
+    ~AC_PolyFence_index() {
+        clear();
+    }
+
+    CLASS_NO_COPY(AC_PolyFence_index);
+
+    // build the index for a polygon given as lat/lng and as offsets
+    // in cm from the origin. The point arrays must outlive the index.
+    // Returns false if the edge lists could not be allocated, in
+    // which case queries fall back to checking every edge
+    bool init(const Vector2l *points_lla, const Vector2f *points, uint8_t count);
+
+    // free the edge lists
+    void clear();
+
+    // returns true if pos is outside the polygon
+    bool outside(const Vector2l &pos) const WARN_IF_UNUSED;
+
+    // closest distance in cm from pos to an edge of the polygon,
+    // returns false if the polygon has fewer than three edges
+    bool closest_distance(const Vector2f &pos, float &closest) const WARN_IF_UNUSED;
+
+    // a distance in cm from pos that no edge of the polygon is closer than
+    float distance_lower_bound(const Vector2f &pos) const WARN_IF_UNUSED;
+
+private:
+    const Vector2l *_points_lla = nullptr;
+    const Vector2f *_points = nullptr;
+    uint8_t _count = 0;         // number of points passed to init()
+    uint8_t _num_edges_lla;     // edges of _points_lla, not counting a repeated closing point
+    uint8_t _num_edges_cm;      // edges of _points, not counting a repeated closing point
+
+    // bounding boxes
+    Vector2l _min_lla;
+    Vector2l _max_lla;
+    Vector2f _min_cm;
+    Vector2f _max_cm;
+
+    // edges whose longitude range overlaps each band of longitude.
+    // Edges for band i are _band_edges[_band_start[i]] up to
+    // _band_edges[_band_start[i+1]]
+    uint8_t _num_bands;
+    uint16_t *_band_start = nullptr;
+    uint8_t *_band_edges = nullptr;
+
+    // edges whose bounding box overlaps each cell of a grid over the
+    // cm bounding box, stored the same way as the bands
+    uint8_t _grid_x;
+    uint8_t _grid_y;
+    Vector2f _cell_size;
+    uint16_t *_cell_start = nullptr;
+    uint8_t *_cell_edges = nullptr;
+
+    uint8_t band_of(int32_t lng) const;
+    uint8_t cell_x(float x) const;
+    uint8_t cell_y(float y) const;
+    float rounding_margin(const Vector2f &pos) const;
+    bool build_bands();
+    bool build_grid();
+};
+
+#endif // AP_FENCE_ENABLED
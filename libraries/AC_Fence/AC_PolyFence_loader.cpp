@@ -245,23 +245,34 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     uint16_t num_inclusion_outside = 0;
     distance_outside_fence = -FLT_MAX;
 
-    // check we are inside each inclusion zone:
+    // check we are inside each inclusion zone. Polygons whose
+    // bounding box is too far away to change distance_outside_fence
+    // don't need their closest edge found
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
+        const float lower_bound = boundary.index.distance_lower_bound(scaled_pos) * 0.01f;
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.index.outside(pos)) {
             num_inclusion_outside++;
-            if (valid_distance) {
+            if (is_positive(distance_outside_fence) && lower_bound >= distance_outside_fence) {
+                continue;
+            }
+            if (boundary.index.closest_distance(scaled_pos, distance)) {
+                distance *= 0.01f; // convert back to meters
                 if (is_positive(distance_outside_fence)) {
                     distance_outside_fence = MIN(distance_outside_fence, distance);
                 } else {
                     distance_outside_fence = distance;
                 }
             }
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        } else {
+            if (-lower_bound <= distance_outside_fence) {
+                continue;
+            }
+            if (boundary.index.closest_distance(scaled_pos, distance)) {
+                distance *= 0.01f; // convert back to meters
+                distance_outside_fence = MAX(distance_outside_fence, -distance);
+            }
         }
     }
 
@@ -269,17 +280,19 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
-            if (valid_distance) {
-                distance_outside_fence = distance;
+        if (!boundary.index.outside(pos)) {
+            if (boundary.index.closest_distance(scaled_pos, distance)) {
+                distance_outside_fence = distance * 0.01f;
             } else {
                 distance_outside_fence = 0.0f;
             }
             return true;
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        }
+        if (-boundary.index.distance_lower_bound(scaled_pos) * 0.01f <= distance_outside_fence) {
+            continue;
+        }
+        if (boundary.index.closest_distance(scaled_pos, distance)) {
+            distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
         }
     }
 
@@ -784,6 +797,9 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            if (!boundary.index.init(boundary.points_lla, boundary.points, boundary.count)) {
+                Debug("Fence: no memory for polygon index");
+            }
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -803,6 +819,9 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            if (!boundary.index.init(boundary.points_lla, boundary.points, boundary.count)) {
+                Debug("Fence: no memory for polygon index");
+            }
             _num_loaded_exclusion_boundaries++;
             break;
         }
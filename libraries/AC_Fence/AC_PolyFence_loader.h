@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AC_Fence_config.h"
+#include "AC_PolyFence_index.h"
 #include <AP_Math/AP_Math.h>
 
 // CIRCLE_INCLUSION_INT stores the radius an a 32-bit integer in
@@ -54,6 +55,7 @@ public:
 
 class AC_PolyFence_loader
 {
+    friend class AC_PolyFence_loader_Test;
 
 public:
 
@@ -306,6 +308,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        AC_PolyFence_index index; // spatial index over the points
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -316,6 +319,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        AC_PolyFence_index index; // spatial index over the points
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
@@ -0,0 +1,122 @@
+/*
+  benchmark polygon fence breach checks
+
+  The fence is an agricultural one: a large inclusion polygon with
+  many exclusion polygons spread inside it. Each benchmark iteration
+  is one AC_PolyFence_loader::breached() call for the next of a set of
+  points over the fence.
+ */
+
+#include <AP_gbenchmark.h>
+
+#include <AC_Fence/AC_PolyFence_loader.h>
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_FENCE_ENABLED
+
+#define BENCH_NUM_POLYGONS 41
+#define BENCH_NUM_POINTS 2000
+
+static const Location origin { -353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE };
+
+class BenchPolygon {
+public:
+    Vector2l points_lla[250];
+    Vector2f points[250];
+    uint8_t count;
+
+    // a jagged polygon around a centre offset, radius in 1e-7 degrees
+    void make(uint8_t n, int32_t lat_ofs, int32_t lng_ofs, int32_t radius) {
+        count = n;
+        for (uint8_t i=0; i<n; i++) {
+            const float angle = i * M_2PI / n;
+            const float r = (i % 3 == 1) ? radius * 0.6 : radius * (0.9 + 0.1 * sinf(i));
+            points_lla[i].x = origin.lat + lat_ofs + int32_t(r * cosf(angle));
+            points_lla[i].y = origin.lng + lng_ofs + int32_t(r * sinf(angle));
+            const Location loc(points_lla[i].x, points_lla[i].y, 0, Location::AltFrame::ABSOLUTE);
+            points[i] = origin.get_distance_NE(loc) * 100.0f;
+        }
+    }
+};
+
+// loads polygons into a loader the way load_from_storage() does
+class AC_PolyFence_loader_Test
+{
+public:
+    // the first polygon is an inclusion fence and the rest are
+    // exclusion fences
+    static void load(AC_PolyFence_loader &loader, BenchPolygon *polygons, uint8_t n)
+    {
+        loader._loaded_inclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::InclusionBoundary[1];
+        init_boundary(loader._loaded_inclusion_boundary[0], polygons[0]);
+        loader._num_loaded_inclusion_boundaries = 1;
+
+        loader._loaded_exclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::ExclusionBoundary[n-1];
+        for (uint8_t i=1; i<n; i++) {
+            init_boundary(loader._loaded_exclusion_boundary[i-1], polygons[i]);
+        }
+        loader._num_loaded_exclusion_boundaries = n-1;
+
+        loader.loaded_origin = origin;
+        loader._load_time_ms = 1;
+    }
+
+private:
+    template <typename T>
+    static void init_boundary(T &boundary, BenchPolygon &p)
+    {
+        boundary.points = p.points;
+        boundary.points_lla = p.points_lla;
+        boundary.count = p.count;
+        boundary.index.init(boundary.points_lla, boundary.points, boundary.count);
+    }
+};
+
+static BenchPolygon polygons[BENCH_NUM_POLYGONS];
+static Location locations[BENCH_NUM_POINTS];
+static AP_Int8 total;
+static AP_Int16 options;
+static AC_PolyFence_loader loader(total, options);
+
+static void setup_fence()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+
+    polygons[0].make(250, 0, 0, 1800000);
+    for (uint8_t i=1; i<BENCH_NUM_POLYGONS; i++) {
+        polygons[i].make(60, ((i % 7) - 3) * 400000, ((i / 7) - 3) * 400000, 150000);
+    }
+    AC_PolyFence_loader_Test::load(loader, polygons, BENCH_NUM_POLYGONS);
+
+    for (uint16_t i=0; i<BENCH_NUM_POINTS; i++) {
+        locations[i] = Location(origin.lat + int32_t((i * 7919) % 3000000) - 1500000,
+                                origin.lng + int32_t((i * 104729) % 3000000) - 1500000,
+                                0, Location::AltFrame::ABSOLUTE);
+    }
+}
+
+static void BM_PolyFenceBreached(benchmark::State& state)
+{
+    setup_fence();
+
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float distance;
+        bool breached = loader.breached(locations[i], distance);
+        gbenchmark_escape(&breached);
+        gbenchmark_escape(&distance);
+        i = (i + 1) % BENCH_NUM_POINTS;
+    }
+}
+
+BENCHMARK(BM_PolyFenceBreached);
+
+#endif  // AP_FENCE_ENABLED
+
+BENCHMARK_MAIN();
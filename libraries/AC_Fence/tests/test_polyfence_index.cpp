@@ -0,0 +1,235 @@
+#include <AP_gtest.h>
+
+#include <AC_Fence/AC_PolyFence_index.h>
+#include <AC_Fence/AC_PolyFence_loader.h>
+#include <AP_HAL/AP_HAL.h>
+
+#include <float.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const Location origin { -353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE };
+
+// a fence polygon as it would be loaded, in lat/lng and in cm from
+// the origin
+class TestPolygon {
+public:
+    Vector2l points_lla[255];
+    Vector2f points[255];
+    uint8_t count;
+    AC_PolyFence_index index;
+
+    // a jagged polygon around a centre offset, radius in 1e-7 degrees
+    void make(uint8_t n, int32_t lat_ofs, int32_t lng_ofs, int32_t radius, bool closed) {
+        count = n;
+        const uint8_t unique = closed ? n-1 : n;
+        for (uint8_t i=0; i<unique; i++) {
+            const float angle = i * M_2PI / unique;
+            // every third vertex is pulled in to give the polygon
+            // concave notches
+            const float r = (i % 3 == 1) ? radius * 0.6 : radius * (0.9 + 0.1 * sinf(i));
+            points_lla[i].x = origin.lat + lat_ofs + int32_t(r * cosf(angle));
+            points_lla[i].y = origin.lng + lng_ofs + int32_t(r * sinf(angle));
+        }
+        if (closed) {
+            points_lla[n-1] = points_lla[0];
+        }
+        for (uint8_t i=0; i<n; i++) {
+            points[i] = to_cm(points_lla[i]);
+        }
+        EXPECT_TRUE(index.init(points_lla, points, count));
+    }
+
+    // as AC_PolyFence_loader::scale_latlon_from_origin()
+    static Vector2f to_cm(const Vector2l &p) {
+        const Location loc(p.x, p.y, 0, Location::AltFrame::ABSOLUTE);
+        return origin.get_distance_NE(loc) * 100.0f;
+    }
+
+    // distance in metres from a point to the nearest edge
+    float closest_distance(const Vector2f &pos_cm) const {
+        float distance = 0;
+        EXPECT_TRUE(Polygon_closest_distance_point(points, count, pos_cm, distance));
+        return distance * 0.01f;
+    }
+
+    // check the index against the whole polygon at one point
+    void check(const Vector2l &pos) {
+        EXPECT_EQ(Polygon_outside(pos, points_lla, count), index.outside(pos));
+
+        const Vector2f pos_cm = to_cm(pos);
+        float expected = 0, closest = 0;
+        const bool expected_valid = Polygon_closest_distance_point(points, count, pos_cm, expected);
+        EXPECT_EQ(expected_valid, index.closest_distance(pos_cm, closest));
+        EXPECT_FLOAT_EQ(expected, closest);
+        EXPECT_LE(index.distance_lower_bound(pos_cm), expected);
+    }
+
+    // check points on a grid over and around the polygon, plus each vertex
+    void check_all() {
+        for (int32_t x=-2000000; x<=2000000; x+=37717) {
+            for (int32_t y=-2000000; y<=2000000; y+=41213) {
+                check(Vector2l(origin.lat + x, origin.lng + y));
+            }
+        }
+        for (uint8_t i=0; i<count; i++) {
+            check(points_lla[i]);
+            check(Vector2l(points_lla[i].x, points_lla[i].y + 1));
+            check(Vector2l(points_lla[i].x - 1, points_lla[i].y));
+        }
+    }
+};
+
+TEST(AC_PolyFence_index, LargePolygon)
+{
+    TestPolygon p;
+    p.make(250, 0, 0, 1500000, false);
+    p.check_all();
+}
+
+TEST(AC_PolyFence_index, ClosedPolygon)
+{
+    TestPolygon p;
+    p.make(101, 200000, -300000, 1000000, true);
+    p.check_all();
+}
+
+TEST(AC_PolyFence_index, SmallPolygon)
+{
+    TestPolygon p;
+    p.make(5, 0, 0, 1000000, false);
+    p.check_all();
+}
+
+#if AP_FENCE_ENABLED
+
+// loads polygons into a loader the way load_from_storage() does
+class AC_PolyFence_loader_Test
+{
+public:
+    // the first polygon is an inclusion fence and the rest are
+    // exclusion fences
+    static void load(AC_PolyFence_loader &loader, TestPolygon *polygons, uint8_t n)
+    {
+        loader._loaded_inclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::InclusionBoundary[1];
+        ASSERT_NE(nullptr, loader._loaded_inclusion_boundary);
+        init_boundary(loader._loaded_inclusion_boundary[0], polygons[0]);
+        loader._num_loaded_inclusion_boundaries = 1;
+
+        loader._loaded_exclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::ExclusionBoundary[n-1];
+        ASSERT_NE(nullptr, loader._loaded_exclusion_boundary);
+        for (uint8_t i=1; i<n; i++) {
+            init_boundary(loader._loaded_exclusion_boundary[i-1], polygons[i]);
+        }
+        loader._num_loaded_exclusion_boundaries = n-1;
+
+        loader.loaded_origin = origin;
+        loader._load_time_ms = 1;
+    }
+
+    static void unload(AC_PolyFence_loader &loader)
+    {
+        delete[] loader._loaded_inclusion_boundary;
+        loader._loaded_inclusion_boundary = nullptr;
+        loader._num_loaded_inclusion_boundaries = 0;
+        delete[] loader._loaded_exclusion_boundary;
+        loader._loaded_exclusion_boundary = nullptr;
+        loader._num_loaded_exclusion_boundaries = 0;
+        loader._load_time_ms = 0;
+    }
+
+private:
+    template <typename T>
+    static void init_boundary(T &boundary, TestPolygon &p)
+    {
+        boundary.points = p.points;
+        boundary.points_lla = p.points_lla;
+        boundary.count = p.count;
+        EXPECT_TRUE(boundary.index.init(boundary.points_lla, boundary.points, boundary.count));
+    }
+};
+
+// the expected result of a breach check against one inclusion polygon
+// and a set of exclusion polygons, from the whole polygons
+static bool expected_breach(const TestPolygon *polygons, uint8_t n, const Vector2l &pos, float &distance_outside_fence)
+{
+    const Vector2f pos_cm = TestPolygon::to_cm(pos);
+
+    // inside an exclusion zone, by the distance to its edge
+    for (uint8_t i=1; i<n; i++) {
+        if (!Polygon_outside(pos, polygons[i].points_lla, polygons[i].count)) {
+            distance_outside_fence = polygons[i].closest_distance(pos_cm);
+            return true;
+        }
+    }
+
+    // outside the inclusion zone, by the distance back to it
+    if (Polygon_outside(pos, polygons[0].points_lla, polygons[0].count)) {
+        distance_outside_fence = polygons[0].closest_distance(pos_cm);
+        return true;
+    }
+
+    // inside the fence, by the distance to the nearest edge of any zone
+    float nearest = FLT_MAX;
+    for (uint8_t i=0; i<n; i++) {
+        nearest = MIN(nearest, polygons[i].closest_distance(pos_cm));
+    }
+    distance_outside_fence = -nearest;
+    return false;
+}
+
+// an agricultural fence: a large inclusion polygon with many
+// exclusion polygons spread inside it
+TEST(AC_PolyFence_loader, Breached)
+{
+    static TestPolygon polygons[41];
+    const uint8_t n = ARRAY_SIZE(polygons);
+    polygons[0].make(250, 0, 0, 1800000, false);
+    for (uint8_t i=1; i<n; i++) {
+        polygons[i].make(60, ((i % 7) - 3) * 400000, ((i / 7) - 3) * 400000, 150000, i % 2);
+    }
+
+    static AP_Int8 total;
+    static AP_Int16 options;
+    static AC_PolyFence_loader loader(total, options);
+
+    float distance;
+    EXPECT_FALSE(loader.breached(origin, distance));
+
+    AC_PolyFence_loader_Test::load(loader, polygons, n);
+
+    uint16_t num_breached = 0;
+    uint16_t num_inside = 0;
+    auto check = [&](const Vector2l &pos) {
+        float expected_distance;
+        const bool expected = expected_breach(polygons, n, pos, expected_distance);
+        const Location loc(pos.x, pos.y, 0, Location::AltFrame::ABSOLUTE);
+        EXPECT_EQ(expected, loader.breached(loc, distance));
+        EXPECT_FLOAT_EQ(expected_distance, distance);
+        if (expected) {
+            num_breached++;
+        } else {
+            num_inside++;
+        }
+    };
+    for (int32_t x=-2000000; x<=2000000; x+=37717) {
+        for (int32_t y=-2000000; y<=2000000; y+=41213) {
+            check(Vector2l(origin.lat + x, origin.lng + y));
+        }
+    }
+    for (uint8_t i=0; i<n; i++) {
+        for (uint8_t j=0; j<polygons[i].count; j++) {
+            check(polygons[i].points_lla[j]);
+        }
+    }
+    // the grid has points both inside and outside the fence
+    EXPECT_GT(num_breached, 0U);
+    EXPECT_GT(num_inside, 0U);
+
+    AC_PolyFence_loader_Test::unload(loader);
+    EXPECT_FALSE(loader.breached(origin, distance));
+}
+
+#endif  // AP_FENCE_ENABLED
+
+AP_GTEST_MAIN()
@@ -0,0 +1,214 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LZ4.h"
+
+#include <string.h>
+
+// the LZ4 format requires the last match to start at least 12 bytes
+// from the end of the block, and the last 5 bytes to be literals
+#define LZ4_MIN_MATCH 4
+#define LZ4_MF_LIMIT 12
+#define LZ4_LAST_LITERALS 5
+
+LZ4_Compressor::~LZ4_Compressor()
+{
+    delete[] hash_table;
+}
+
+bool LZ4_Compressor::init()
+{
+    if (hash_table == nullptr) {
+        hash_table = NEW_NOTHROW uint16_t[1U<<HASH_LOG];
+    }
+    return hash_table != nullptr;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+  greedy LZ4 block compressor using a single hash table entry per
+  4 byte sequence. Returns the compressed length, or 0 if the output
+  would not fit in out_size bytes
+ */
+uint32_t LZ4_Compressor::compress(const uint8_t *in, uint32_t len, uint8_t *out, uint32_t out_size)
+{
+    if (hash_table == nullptr || len > 0xFFFF) {
+        return 0;
+    }
+    uint8_t *op = out;
+    const uint8_t *const oend = out + out_size;
+    const uint8_t *anchor = in;
+    const uint8_t *const iend = in + len;
+
+    // emit a sequence of literals from anchor followed by an optional
+    // match. Returns false if out is full
+    auto emit = [&](const uint8_t *lit_end, uint32_t match_len, uint16_t offset) -> bool {
+        const uint32_t lit_len = lit_end - anchor;
+        // token, literal length bytes, literals, offset, match length bytes
+        const uint32_t need = 1 + lit_len/255 + 1 + lit_len + 2 + match_len/255 + 1;
+        if (op + need > oend) {
+            return false;
+        }
+        uint8_t *token = op++;
+        if (lit_len >= 15) {
+            *token = 15<<4;
+            uint32_t l = lit_len - 15;
+            for (; l >= 255; l -= 255) {
+                *op++ = 255;
+            }
+            *op++ = l;
+        } else {
+            *token = lit_len<<4;
+        }
+        memcpy(op, anchor, lit_len);
+        op += lit_len;
+        if (match_len == 0) {
+            // final literals
+            return true;
+        }
+        *op++ = offset & 0xFF;
+        *op++ = offset >> 8;
+        uint32_t ml = match_len - LZ4_MIN_MATCH;
+        if (ml >= 15) {
+            *token |= 15;
+            ml -= 15;
+            for (; ml >= 255; ml -= 255) {
+                *op++ = 255;
+            }
+            *op++ = ml;
+        } else {
+            *token |= ml;
+        }
+        return true;
+    };
+
+    if (len >= LZ4_MF_LIMIT + 1) {
+        memset(hash_table, 0, sizeof(hash_table[0]) << HASH_LOG);
+        const uint8_t *const mflimit = iend - LZ4_MF_LIMIT;
+        const uint8_t *const matchlimit = iend - LZ4_LAST_LITERALS;
+        const uint8_t *ip = in + 1;
+
+        while (ip < mflimit) {
+            const uint32_t seq = read32(ip);
+            const uint32_t h = (seq * 2654435761U) >> (32 - HASH_LOG);
+            const uint8_t *ref = in + hash_table[h];
+            hash_table[h] = ip - in;
+            if (ref >= ip || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+            // extend the match backwards over pending literals
+            while (ip > anchor && ref > in && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            // and forwards
+            const uint8_t *mp = ip + LZ4_MIN_MATCH;
+            const uint8_t *mr = ref + LZ4_MIN_MATCH;
+            while (mp < matchlimit && *mp == *mr) {
+                mp++;
+                mr++;
+            }
+            if (!emit(ip, mp - ip, ip - ref)) {
+                return 0;
+            }
+            ip = mp;
+            anchor = ip;
+            if (ip < mflimit) {
+                // keep the table fresh for the position just before
+                // the next search
+                hash_table[(read32(ip-2) * 2654435761U) >> (32 - HASH_LOG)] = ip - 2 - in;
+            }
+        }
+    }
+
+    if (!emit(iend, 0, 0)) {
+        return 0;
+    }
+    return op - out;
+}
+
+/*
+  decode an LZ4 block. Returns the decoded length or -1 on corrupt
+  input or output overflow
+ */
+int32_t lz4_decompress(const uint8_t *in, uint32_t len, uint8_t *out, uint32_t out_size)
+{
+    const uint8_t *ip = in;
+    const uint8_t *const iend = in + len;
+    uint8_t *op = out;
+    uint8_t *const oend = out + out_size;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > uint32_t(iend - ip) || lit_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == iend) {
+            // the last sequence has no match
+            break;
+        }
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1]<<8);
+        ip += 2;
+        if (offset == 0 || offset > op - out) {
+            return -1;
+        }
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        // matches may overlap the output, so copy forwards bytewise
+        const uint8_t *ref = op - offset;
+        for (uint32_t i=0; i<match_len; i++) {
+            op[i] = ref[i];
+        }
+        op += match_len;
+    }
+    return op - out;
+}
@@ -0,0 +1,55 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  encoder and decoder for the LZ4 block format. The format is simple
+  to decode, so GCSs and tools can read data compressed with it using
+  any LZ4 library
+ */
+#pragma once
+
+#include <stdint.h>
+#include "AP_Common.h"
+
+class LZ4_Compressor
+{
+public:
+    LZ4_Compressor() {}
+    ~LZ4_Compressor();
+
+    CLASS_NO_COPY(LZ4_Compressor);
+
+    // allocate the hash table
+    bool init();
+
+    /*
+      compress len bytes from in, which must be less than 64k, into
+      out. Returns the compressed length, or 0 if it won't fit in
+      out_size bytes
+     */
+    uint32_t compress(const uint8_t *in, uint32_t len, uint8_t *out, uint32_t out_size);
+
+private:
+    static const uint8_t HASH_LOG = 12;
+
+    // most recent position of each hashed 4 byte sequence
+    uint16_t *hash_table = nullptr;
+};
+
+/*
+  decode an LZ4 block. Returns the decoded length, or -1 if the input
+  is corrupt or won't fit in out_size bytes
+ */
+int32_t lz4_decompress(const uint8_t *in, uint32_t len, uint8_t *out, uint32_t out_size);
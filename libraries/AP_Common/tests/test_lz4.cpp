@@ -0,0 +1,73 @@
+#include <AP_gtest.h>
+
+#include <AP_Common/LZ4.h>
+
+// round trip a buffer, returning the compressed length
+static uint32_t round_trip(LZ4_Compressor &c, const uint8_t *data, uint32_t len)
+{
+    uint8_t *comp = new uint8_t[len+64];
+    uint8_t *decoded = new uint8_t[len+1];
+    const uint32_t clen = c.compress(data, len, comp, len+64);
+    EXPECT_GT(clen, 0U);
+    EXPECT_EQ(int32_t(len), lz4_decompress(comp, clen, decoded, len+1));
+    EXPECT_EQ(0, memcmp(data, decoded, len));
+    delete[] comp;
+    delete[] decoded;
+    return clen;
+}
+
+TEST(LZ4, RoundTrip)
+{
+    LZ4_Compressor c;
+    ASSERT_TRUE(c.init());
+
+    const uint32_t len = 4096;
+    uint8_t data[len];
+    for (uint32_t i=0; i<len; i++) {
+        data[i] = (i % 23 == 3) ? uint8_t(i/23) : uint8_t(i % 23);
+    }
+    EXPECT_LT(round_trip(c, data, len), len/2);
+
+    // long runs need extended length bytes
+    memset(data, 0xA3, len);
+    EXPECT_LT(round_trip(c, data, len), 64U);
+
+    // incompressible data grows slightly
+    uint32_t x = 1;
+    for (uint32_t i=0; i<len; i++) {
+        x = x * 1103515245U + 12345U;
+        data[i] = x >> 24;
+    }
+    EXPECT_GT(round_trip(c, data, len), len);
+
+    // too short to hold a match
+    round_trip(c, data, 5);
+
+    // doesn't fit
+    uint8_t out[16];
+    EXPECT_EQ(0U, c.compress(data, len, out, sizeof(out)));
+}
+
+TEST(LZ4, Corrupt)
+{
+    uint8_t out[64];
+
+    // match offset before the start of the output
+    const uint8_t bad_offset[] { 0x10, 'a', 0x05, 0x00 };
+    EXPECT_EQ(-1, lz4_decompress(bad_offset, sizeof(bad_offset), out, sizeof(out)));
+
+    // literals past the end of the input
+    const uint8_t short_literals[] { 0x40, 'a', 'b' };
+    EXPECT_EQ(-1, lz4_decompress(short_literals, sizeof(short_literals), out, sizeof(out)));
+
+    // match past the end of the output
+    const uint8_t long_match[] { 0x1F, 'a', 0x01, 0x00, 0xFF, 0x00 };
+    EXPECT_EQ(-1, lz4_decompress(long_match, sizeof(long_match), out, sizeof(out)));
+
+    // a valid overlapping match
+    const uint8_t run[] { 0x1F, 'a', 0x01, 0x00, 0x00, 0x00 };
+    EXPECT_EQ(20, lz4_decompress(run, sizeof(run), out, sizeof(out)));
+    EXPECT_EQ('a', out[19]);
+}
+
+AP_GTEST_MAIN()
@@ -24,6 +24,7 @@
 #include "AP_Filesystem_Param.h"
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Common/LZ4.h>
 #include <ctype.h>
 
 #define PACKED_NAME "param.pck"
@@ -68,6 +69,11 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
     r.read_size = 0;
     r.file_size = 0;
     r.writebuf = nullptr;
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    r.snapshot = nullptr;
+    bool compress = false;
+    uint32_t since = 0;
+#endif
     if (!read_only) {
         // setup for upload
         r.writebuf = NEW_NOTHROW ExpandingString();
@@ -116,7 +122,40 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
             continue;
         }
 #endif
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+        if (strncmp(c, "compress=", 9) == 0) {
+            uint32_t v = strtoul(c+9, nullptr, 10);
+            if (v > 1) {
+                goto failed;
+            }
+            compress = v == 1;
+            c += 9;
+            c = strchr(c, '&');
+            continue;
+        }
+        if (strncmp(c, "since=", 6) == 0) {
+            since = strtoul(c+6, nullptr, 16);
+            c += 6;
+            c = strchr(c, '&');
+            continue;
+        }
+#endif
+    }
+
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    if (compress) {
+        // snapshots are always of all parameters
+        if (!read_only || r.start != 0 || r.count != 0) {
+            goto failed;
+        }
+        if (!build_snapshot(r, since)) {
+            delete [] r.cursors;
+            r.open = false;
+            errno = ENOMEM;
+            return -1;
+        }
     }
+#endif
 
     return idx;
 
@@ -144,13 +183,17 @@ int AP_Filesystem_Param::close(int fd)
     r.cursors = nullptr;
     delete r.writebuf;
     r.writebuf = nullptr;
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    delete r.snapshot;
+    r.snapshot = nullptr;
+#endif
     return ret;
 }
 
 /*
   packed format:
     file header:
-      uint16_t magic = 0x671b or  0x671c for included default values
+      uint16_t magic = 0x671b or  0x671c for included default values, 0x671d for compressed
       uint16_t num_params
       uint16_t total_params
 
@@ -166,6 +209,25 @@ int AP_Filesystem_Param::close(int fd)
     Any leading zero bytes after the header should be discarded as pad
     bytes. Pad bytes are used to ensure that a parameter data[] field
     does not cross a read packet boundary
+
+  compressed format, with param.pck?compress=1:
+    file header as above, with magic = 0x671d
+
+    snapshot header:
+      uint32_t id        // identifies this snapshot
+      uint32_t since     // id of the snapshot this holds changes against, 0 for all params
+      uint32_t raw_len   // total length of the per-parameter blocks
+
+    chunks:
+      uint16_t raw_len   // length of the per-parameter blocks in this chunk
+      uint16_t data_len  // data is LZ4 block compressed if data_len < raw_len
+      uint8_t data[data_len]
+
+    The per-parameter blocks are packed as above, without pad bytes.
+    A client which has a snapshot can open param.pck?compress=1&since=ID
+    to get only the parameters which have changed since. If ID isn't
+    the last snapshot sent or the parameter names have changed then
+    all parameters are sent
  */
 
 /*
@@ -201,28 +263,14 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
     }
     ap->copy_name_token(c.token, name, AP_MAX_NAME_SIZE, true);
 
-    uint8_t common_len = 0;
-    const char *last_name = c.last_name;
-    const char *pname = name;
-    while (*pname == *last_name && *pname) {
-        common_len++;
-        pname++;
-        last_name++;
-    }
-    uint8_t name_len = strlen(pname);
-    if (name_len == 0) {
-        name_len = 1;
-        common_len--;
-        pname--;
-    }
 #if AP_PARAM_DEFAULTS_ENABLED
     const bool add_default = r.with_defaults && !is_equal(ap->cast_to_float(ptype), default_val);
 #else
     const bool add_default = false;
 #endif
+    uint8_t tbuf[max_pack_len];
+    uint8_t packed_len = encode_param(name, c.last_name, ptype, ap, add_default ? &default_val : nullptr, tbuf);
     const uint8_t type_len = AP_Param::type_size(ptype);
-    uint8_t packed_len = type_len + name_len + 2 + (add_default ? type_len : 0);
-    const uint8_t flags = add_default;
 
     /*
       see if we need to add padding to ensure that a data field never
@@ -235,47 +283,78 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
         if (ofs_mod > 0 && ofs_mod < type_len) {
             const uint8_t pad = type_len - ofs_mod;
             memset(buf, 0, pad);
-            buf += pad;
-            packed_len += pad;
+            memcpy(&buf[pad], tbuf, packed_len);
+            return packed_len + pad;
         }
     }
+    memcpy(buf, tbuf, packed_len);
+    return packed_len;
+}
+
+/*
+  encode one parameter block into buf, which must be at least of size
+  max_pack_len. last_name holds the name of the previous parameter and
+  is updated. value points at the parameter value, and default_val at
+  the default value to include, if any
+ */
+uint8_t AP_Filesystem_Param::encode_param(const char *name, char *last_name, enum ap_var_type ptype,
+                                          const void *value, const float *default_val, uint8_t *buf)
+{
+    uint8_t common_len = 0;
+    const char *lname = last_name;
+    const char *pname = name;
+    while (*pname == *lname && *pname) {
+        common_len++;
+        pname++;
+        lname++;
+    }
+    uint8_t name_len = strlen(pname);
+    if (name_len == 0) {
+        name_len = 1;
+        common_len--;
+        pname--;
+    }
+    const uint8_t type_len = AP_Param::type_size(ptype);
+    uint8_t packed_len = type_len + name_len + 2;
+    const uint8_t flags = default_val != nullptr;
 
     buf[0] = uint8_t(ptype) | (flags<<4);
     buf[1] = common_len | ((name_len-1)<<4);
     memcpy(&buf[2], pname, name_len);
-    memcpy(&buf[2+name_len], ap, type_len);
+    memcpy(&buf[2+name_len], value, type_len);
 #if AP_PARAM_DEFAULTS_ENABLED
-    if (add_default) {
+    if (default_val != nullptr) {
+        packed_len += type_len;
         switch (ptype) {
             case AP_PARAM_NONE:
             case AP_PARAM_GROUP:
                 // should never happen...
                 break;
             case AP_PARAM_INT8: {
-                const int32_t int8_default = default_val;
+                const int32_t int8_default = *default_val;
                 memcpy(&buf[2+name_len+type_len], &int8_default, type_len);
                 break;
             }
             case AP_PARAM_INT16: {
-                const int16_t int16_default = default_val;
+                const int16_t int16_default = *default_val;
                 memcpy(&buf[2+name_len+type_len], &int16_default, type_len);
                 break;
             }
             case AP_PARAM_INT32: {
-                const int32_t int32_default = default_val;
+                const int32_t int32_default = *default_val;
                 memcpy(&buf[2+name_len+type_len], &int32_default, type_len);
                 break;
             }
             case AP_PARAM_FLOAT:
             case AP_PARAM_VECTOR3F: {
-                memcpy(&buf[2+name_len+type_len], &default_val, type_len);
+                memcpy(&buf[2+name_len+type_len], default_val, type_len);
                 break;
             }
         }
     }
 #endif
 
-    strcpy(c.last_name, name);
+    strcpy(last_name, name);
 
     return packed_len;
 }
@@ -333,6 +412,20 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         errno = EINVAL;
         return -1;
     }
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    if (r.snapshot != nullptr) {
+        // compressed snapshots are built when the file is opened
+        const uint32_t size = r.snapshot->get_length();
+        if (r.file_ofs >= size) {
+            return 0;
+        }
+        count = MIN(count, size - r.file_ofs);
+        memcpy(buf, &r.snapshot->get_string()[r.file_ofs], count);
+        r.file_ofs += count;
+        return count;
+    }
+#endif
+
     size_t header_total = 0;
 
     /*
@@ -663,4 +756,164 @@ bool AP_Filesystem_Param::finish_upload(const rfile &r)
     return true;
 }
 
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+/*
+  collect the current parameter values into values[], which holds
+  count entries, returning a CRC of the parameter names and types.
+  Returns false if the number of parameters is not count
+ */
+static bool snapshot_values(uint32_t *values, uint16_t count, uint32_t &layout_crc)
+{
+    char name[AP_MAX_NAME_SIZE+1];
+    name[AP_MAX_NAME_SIZE] = 0;
+    AP_Param::ParamToken token;
+    enum ap_var_type ptype;
+    uint16_t n = 0;
+
+    layout_crc = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &ptype);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &ptype)) {
+        if (n == count) {
+            return false;
+        }
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, true);
+        const uint8_t type = uint8_t(ptype);
+        layout_crc = crc_crc32(layout_crc, (const uint8_t *)name, strlen(name));
+        layout_crc = crc_crc32(layout_crc, &type, sizeof(type));
+        values[n] = 0;
+        memcpy(&values[n], ap, AP_Param::type_size(ptype));
+        n++;
+    }
+    return n == count;
+}
+
+/*
+  build a compressed snapshot of the parameters when the file is
+  opened. If since is the id of the last snapshot sent and the
+  parameter names haven't changed then only the parameters whose
+  values have changed are included
+ */
+bool AP_Filesystem_Param::build_snapshot(rfile &r, uint32_t since)
+{
+    WITH_SEMAPHORE(last_snapshot.sem);
+
+    const uint16_t count = AP_Param::count_parameters();
+    uint32_t *values = NEW_NOTHROW uint32_t[count];
+    if (values == nullptr) {
+        return false;
+    }
+    uint32_t layout_crc;
+    if (!snapshot_values(values, count, layout_crc)) {
+        delete [] values;
+        return false;
+    }
+    uint32_t id = crc_crc32(layout_crc, (const uint8_t *)values, count*sizeof(uint32_t));
+    if (id == 0) {
+        // zero means no snapshot
+        id = 1;
+    }
+    const bool delta = since != 0 &&
+        since == last_snapshot.id &&
+        last_snapshot.values != nullptr &&
+        count == last_snapshot.count &&
+        layout_crc == last_snapshot.layout_crc;
+
+    ExpandingString raw;
+    char name[AP_MAX_NAME_SIZE+1];
+    name[AP_MAX_NAME_SIZE] = 0;
+    char last_name[AP_MAX_NAME_SIZE+1] {};
+    AP_Param::ParamToken token;
+    enum ap_var_type ptype;
+    float default_val;
+    uint16_t num_params = 0;
+    uint16_t n = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &ptype, &default_val);
+         ap != nullptr && n < count;
+         ap = AP_Param::next_scalar(&token, &ptype, &default_val), n++) {
+        if (delta && values[n] == last_snapshot.values[n]) {
+            continue;
+        }
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, true);
+#if AP_PARAM_DEFAULTS_ENABLED
+        const bool add_default = r.with_defaults && !is_equal(ap->cast_to_float(ptype), default_val);
+#else
+        const bool add_default = false;
+#endif
+        uint8_t buf[max_pack_len];
+        const uint8_t len = encode_param(name, last_name, ptype, &values[n],
+                                         add_default ? &default_val : nullptr, buf);
+        if (!raw.append((const char *)buf, len)) {
+            delete [] values;
+            return false;
+        }
+        num_params++;
+    }
+
+    r.snapshot = NEW_NOTHROW ExpandingString();
+    if (r.snapshot == nullptr) {
+        delete [] values;
+        return false;
+    }
+    struct header hdr;
+    hdr.magic = pmagic_compressed;
+    hdr.num_params = num_params;
+    hdr.total_params = count;
+    struct snapshot_header shdr;
+    shdr.id = id;
+    shdr.since = delta ? since : 0;
+    shdr.raw_len = raw.get_length();
+    if (!r.snapshot->append((const char *)&hdr, sizeof(hdr)) ||
+        !r.snapshot->append((const char *)&shdr, sizeof(shdr)) ||
+        !compress_snapshot(r, raw)) {
+        delete r.snapshot;
+        r.snapshot = nullptr;
+        delete [] values;
+        return false;
+    }
+
+    // remember what was sent so the next client can ask for changes
+    delete [] last_snapshot.values;
+    last_snapshot.values = values;
+    last_snapshot.id = id;
+    last_snapshot.layout_crc = layout_crc;
+    last_snapshot.count = count;
+
+    return true;
+}
+
+/*
+  append the packed parameters to the snapshot as chunks of at most
+  snapshot_chunk_len bytes. Chunks which don't get smaller with LZ4
+  are stored
+ */
+bool AP_Filesystem_Param::compress_snapshot(rfile &r, const ExpandingString &raw)
+{
+    LZ4_Compressor lz4;
+    uint8_t *cbuf = NEW_NOTHROW uint8_t[snapshot_chunk_len];
+    if (cbuf == nullptr || !lz4.init()) {
+        delete [] cbuf;
+        return false;
+    }
+    const uint8_t *data = (const uint8_t *)raw.get_string();
+    const uint32_t raw_total = raw.get_length();
+    bool ok = true;
+    for (uint32_t ofs = 0; ok && ofs < raw_total; ) {
+        const uint16_t raw_len = MIN(raw_total - ofs, uint32_t(snapshot_chunk_len));
+        const uint8_t *chunk = cbuf;
+        uint16_t data_len = lz4.compress(&data[ofs], raw_len, cbuf, raw_len - 1);
+        if (data_len == 0) {
+            chunk = &data[ofs];
+            data_len = raw_len;
+        }
+        ok = r.snapshot->append((const char *)&raw_len, sizeof(raw_len)) &&
+             r.snapshot->append((const char *)&data_len, sizeof(data_len)) &&
+             r.snapshot->append((const char *)chunk, data_len);
+        ofs += raw_len;
+    }
+    delete [] cbuf;
+    return ok;
+}
+#endif  // AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+
 #endif  // AP_FILESYSTEM_PARAM_ENABLED
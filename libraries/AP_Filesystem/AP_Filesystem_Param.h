@@ -21,6 +21,7 @@
 
 #include "AP_Filesystem_backend.h"
 #include <AP_Common/ExpandingString.h>
+#include <AP_HAL/Semaphores.h>
 
 #include <AP_Param/AP_Param.h>
 
@@ -49,6 +50,7 @@ private:
     // Support both protocol versions
     static constexpr uint16_t pmagic = 0x671b;
     static constexpr uint16_t pmagic_with_default = 0x671c;
+    static constexpr uint16_t pmagic_compressed = 0x671d;
 
     // header at front of the file
     struct header {
@@ -57,6 +59,28 @@ private:
         uint16_t total_params; // for upload this is total file length
     };
 
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    // follows the header in a compressed snapshot
+    struct PACKED snapshot_header {
+        uint32_t id;
+        uint32_t since;
+        uint32_t raw_len;
+    };
+
+    // largest amount of packed parameters compressed as one chunk
+    static constexpr uint16_t snapshot_chunk_len = 16384;
+
+    // values in the last snapshot a client was sent, which a
+    // reconnecting client can ask for changes against
+    struct {
+        uint32_t id;
+        uint32_t layout_crc;
+        uint16_t count;
+        uint32_t *values = nullptr;
+        HAL_Semaphore sem;
+    } last_snapshot;
+#endif
+
     struct cursor {
         AP_Param::ParamToken token;
         uint32_t token_ofs;
@@ -76,15 +100,25 @@ private:
         uint32_t file_size;
         struct cursor *cursors;
         ExpandingString *writebuf; // for upload
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+        ExpandingString *snapshot; // for compressed download
+#endif
     } file[max_open_file];
 
     bool token_seek(const struct rfile &r, const uint32_t data_ofs, struct cursor &c);
     uint8_t pack_param(const struct rfile &r, struct cursor &c, uint8_t *buf);
+    uint8_t encode_param(const char *name, char *last_name, enum ap_var_type ptype,
+                         const void *value, const float *default_val, uint8_t *buf);
     bool check_file_name(const char *fname);
 
     // finish uploading parameters
     bool finish_upload(const rfile &r);
     bool param_upload_parse(const rfile &r, bool &need_retry);
+
+#if AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+    bool build_snapshot(rfile &r, uint32_t since);
+    bool compress_snapshot(rfile &r, const ExpandingString &raw);
+#endif
 };
 
 #endif  // AP_FILESYSTEM_PARAM_ENABLED
@@ -36,6 +36,11 @@ struct SysFileList {
 static const SysFileList sysfs_file_list[] = {
     {"threads.txt"},
     {"tasks.txt"},
+#if AP_SCHEDULER_PROFILER_ENABLED
+    {"task_hist.txt"},
+    {"profile.txt"},
+    {"profile_samples.txt"},
+#endif
     {"dma.txt"},
     {"memory.txt"},
     {"uarts.txt"},
@@ -105,6 +110,17 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "tasks.txt") == 0) {
         AP::scheduler().task_info(*r.str);
     }
+#endif
+#if AP_SCHEDULER_PROFILER_ENABLED
+    if (strcmp(fname, "task_hist.txt") == 0) {
+        AP::scheduler().task_histogram(*r.str);
+    }
+    if (strcmp(fname, "profile.txt") == 0) {
+        AP::scheduler().profile_info(*r.str, false);
+    }
+    if (strcmp(fname, "profile_samples.txt") == 0) {
+        AP::scheduler().profile_info(*r.str, true);
+    }
 #endif
     if (strcmp(fname, "dma.txt") == 0) {
         hal.util->dma_info(*r.str);
@@ -28,6 +28,11 @@
 #define AP_FILESYSTEM_PARAM_ENABLED 1
 #endif
 
+// compressed and delta parameter snapshots from @PARAM/param.pck
+#ifndef AP_FILESYSTEM_PARAM_COMPRESS_ENABLED
+#define AP_FILESYSTEM_PARAM_COMPRESS_ENABLED (AP_FILESYSTEM_PARAM_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
 #ifndef AP_FILESYSTEM_POSIX_ENABLED
 #define AP_FILESYSTEM_POSIX_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_QURT)
 #endif
@@ -54,6 +54,7 @@ extern const AP_HAL::HAL& hal;
 #define FFT_MIN_SAMPLES_PER_FRAME   16
 #define FFT_HARMONIC_FIT_DEFAULT    10
 #define FFT_HARMONIC_FIT_FILTER_HZ  15.0f
+#define FFT_TRACKED_FRAMES          7       // frames tracked with a sliding DFT between each full FFT
 #define FFT_HARMONIC_FIT_MULT       50.0f
 #define FFT_HARMONIC_FIT_TRACK_ROLL    4
 #define FFT_HARMONIC_FIT_TRACK_PITCH   5
@@ -169,8 +170,8 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: FFT options
-    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference
-    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise
+    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference,4:Follow detected peaks with a sliding DFT between full FFTs, which reduces CPU load with larger windows. Not used when NUM_FRAMES is set
+    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise,2:Track peaks between FFTs
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("OPTIONS", 15, AP_GyroFFT, _options, 0),
@@ -318,6 +319,21 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         return;
     }
 
+    // peak tracking is an optimisation so carry on with full FFTs if it is not possible
+    if (using_peak_tracking() && _num_frames == 0) {
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            _tracker[axis] = hal.dsp->fft_init_tracking(_state, _samples_per_frame);
+            if (_tracker[axis] == nullptr) {
+                GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AP_GyroFFT: peak tracking disabled");
+                for (uint8_t i = 0; i < axis; i++) {
+                    delete _tracker[i];
+                    _tracker[i] = nullptr;
+                }
+                break;
+            }
+        }
+    }
+
     // per-axis frame time
     _frame_time_ms = _samples_per_frame * 1000 / _fft_sampling_rate_hz;
     // The update rate for the output, defaults are 1Khz / (1 - 0.5) * 32 == 62hz
@@ -456,16 +472,46 @@ uint16_t AP_GyroFFT::run_cycle()
 
     // get the appropriate gyro buffer
     FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(_update_axis) : _downsampled_gyro_data[_update_axis]);
+    AP_HAL::DSP::SlidingDFTState* tracker = _tracker[_update_axis];
     // if we have many more samples than the window size then we are struggling to 
     // stay ahead of the gyro loop so drop samples so that this cycle will use all available samples
     if (gyro_buffer.available() > uint32_t(_state->_window_size + uint16_t(_samples_per_frame >> 1))) { // half the frame size is a heuristic
         gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
+        // the tracked peaks no longer follow on from the samples
+        if (tracker != nullptr) {
+            tracker->reset();
+        }
     }
-    // let's go!
-    hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
 
-    // calculate FFT and update filters outside the semaphore
-    uint16_t bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+    uint16_t bin_max = 0;
+    // peaks can only be tracked once the noise reference is complete, after which most frames
+    // follow them with a sliding DFT and only every FFT_TRACKED_FRAMES + 1 frame needs a full FFT
+    if (tracker != nullptr && !_thread_state._noise_needs_calibration) {
+        hal.dsp->fft_track_start(_state, tracker, gyro_buffer);
+        if (_tracked_frames[_update_axis] < FFT_TRACKED_FRAMES) {
+            bin_max = hal.dsp->fft_track_analyse(_state, tracker, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+        }
+        if (bin_max > 0) {
+            gyro_buffer.advance(_samples_per_frame);
+            _tracked_frames[_update_axis]++;
+        }
+    } else if (tracker != nullptr) {
+        tracker->reset();
+        tracker = nullptr;
+    }
+
+    if (bin_max == 0) {
+        // let's go!
+        hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
+
+        // calculate FFT and update filters outside the semaphore
+        bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+
+        if (tracker != nullptr) {
+            hal.dsp->fft_track_retune(_state, tracker);
+            _tracked_frames[_update_axis] = 0;
+        }
+    }
 
     // something has been detected, update the peak frequency and associated metrics
     update_ref_energy(bin_max);
@@ -40,7 +40,8 @@ public:
 
     enum class Options : uint32_t {
         FFTPostFilter = 1 << 0,
-        ESCNoiseCheck = 1 << 1
+        ESCNoiseCheck = 1 << 1,
+        PeakTracking = 1 << 2
     };
 
     AP_GyroFFT();
@@ -111,6 +112,8 @@ public:
     bool using_post_filter_samples() const { return (_options & uint32_t(Options::FFTPostFilter)) != 0; }
     // post filter mask of IMUs
     bool check_esc_noise() const { return (_options & uint32_t(Options::ESCNoiseCheck)) != 0; }
+    // follow detected peaks with a sliding DFT between full FFTs
+    bool using_peak_tracking() const { return (_options & uint32_t(Options::PeakTracking)) != 0; }
     // look for a frequency in the detected noise
     float has_noise_at_frequency_hz(float freq) const;
     static float calculate_notch_frequency(float* freqs, uint16_t numpeaks, float harmonic_fit, uint8_t& harmonics);
@@ -283,6 +286,10 @@ private:
 
     // state of the FFT engine
     AP_HAL::DSP::FFTWindowState* _state;
+    // sliding DFT state tracking the peaks of each axis between full FFTs
+    AP_HAL::DSP::SlidingDFTState* _tracker[XYZ_AXIS_COUNT];
+    // number of frames tracked on each axis since the last full FFT
+    uint8_t _tracked_frames[XYZ_AXIS_COUNT];
     // update state machine step information
     uint8_t _update_axis;
     // noise base of the gyros
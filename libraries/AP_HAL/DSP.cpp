@@ -30,6 +30,9 @@ extern const AP_HAL::HAL &hal;
 
 #define SQRT_2_3 0.816496580927726f
 #define SQRT_6   2.449489742783178f
+// number of times the tracked bins can be carried over to a new set of peaks
+// before being recalculated to clear out accumulated rounding errors
+#define TRACKING_MAX_RETUNES 16
 
 DSP::FFTWindowState::FFTWindowState(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size) :
     _bin_resolution((float)sample_rate / (float)window_size),
@@ -63,8 +66,10 @@ DSP::FFTWindowState::FFTWindowState(uint16_t window_size, uint16_t sample_rate,
 
     // create the Hanning window
     // https://holometer.fnal.gov/GH_FFT.pdf - equation 19
+    // this is the periodic form, dividing by window_size rather than window_size - 1, so that
+    // fft_track_analyse() can apply exactly the same window to the tracked bins in the frequency domain
     for (uint16_t i = 0; i < window_size; i++) {
-        _hanning_window[i] = (0.5f - 0.5f * cosf(2.0f * M_PI * i / ((float)window_size - 1)));
+        _hanning_window[i] = (0.5f - 0.5f * cosf(2.0f * M_PI * i / (float)window_size));
         _window_scale += _hanning_window[i];
     }
     // Calculate the inverse of the Effective Noise Bandwidth - equation 24
@@ -90,6 +95,19 @@ void DSP::FFTWindowState::free_data_structures()
     _avg_freq_bins = nullptr;
     hal.util->free_type(_sliding_window, sizeof(float) * _num_stored_freqs * _sliding_window_size, DSP_MEM_REGION);
     _sliding_window = nullptr;
+    hal.util->free_type(_raw_samples, sizeof(float) * _window_size, DSP_MEM_REGION);
+    _raw_samples = nullptr;
+}
+
+DSP::SlidingDFTState::SlidingDFTState(uint16_t advance) :
+    _advance(advance)
+{
+    _leaving_samples = (float*)hal.util->malloc_type(sizeof(float) * _advance, DSP_MEM_REGION);
+}
+
+DSP::SlidingDFTState::~SlidingDFTState()
+{
+    hal.util->free_type(_leaving_samples, sizeof(float) * _advance, DSP_MEM_REGION);
 }
 
 // step 3: find the magnitudes of the complex data
@@ -115,6 +133,7 @@ void DSP::step_cmplx_mag(FFTWindowState* fft, uint16_t start_bin, uint16_t end_b
     memset(fft->_peak_data, 0, sizeof(fft->_peak_data));
     uint16_t numpeaks = find_peaks(&freq_data[start_bin], bin_range, fft->_derivative_freq_bins, peaks, MAX_TRACKED_PEAKS, 0.0f, -1.0f, smoothwidth, 2);
     //hal.console->printf("found %d peaks\n", numpeaks);
+    fft->_num_peaks = MIN(numpeaks, uint16_t(MAX_TRACKED_PEAKS));
 
     for (uint16_t i = 0; i < MAX_TRACKED_PEAKS; i++) {
         fft->_peak_data[i]._bin = peaks[i] + start_bin;
@@ -373,6 +392,229 @@ uint16_t DSP::fft_stop_average(FFTWindowState* fft, uint16_t start_bin, uint16_t
     return numpeaks;
 }
 
+// initialize tracking of the peaks of one axis between full FFTs, the window
+// is expected to move on by advance samples each time it is analysed
+DSP::SlidingDFTState* DSP::fft_init_tracking(FFTWindowState* fft, uint16_t advance)
+{
+    if (advance == 0 || advance > fft->_window_size) {
+        return nullptr;
+    }
+
+    if (fft->_raw_samples == nullptr) {
+        fft->_raw_samples = (float*)hal.util->malloc_type(sizeof(float) * fft->_window_size, DSP_MEM_REGION);
+        if (fft->_raw_samples == nullptr) {
+            return nullptr;
+        }
+    }
+
+    SlidingDFTState* sdft = NEW_NOTHROW SlidingDFTState(advance);
+    if (sdft == nullptr || sdft->_leaving_samples == nullptr) {
+        delete sdft;
+        return nullptr;
+    }
+    return sdft;
+}
+
+// the sliding DFT of bin k moving on by H samples from a window starting at s is
+// X'[k] = e^(2 pi i kH/N) * (X[k] + sum (x[s+N+j] - x[s+j]) * e^(-2 pi i kj/N)) for j in [0, H)
+// the tracked bins are updated with the samples entering and leaving the window and the
+// current window is kept for fft_track_retune(). The samples are not consumed.
+void DSP::fft_track_start(FFTWindowState* fft, SlidingDFTState* sdft, FloatBuffer& samples)
+{
+    if (samples.peek(fft->_raw_samples, fft->_window_size) != fft->_window_size) {
+        sdft->reset();
+        return;
+    }
+
+    const uint16_t advance = sdft->_advance;
+    if (sdft->_valid) {
+        const float* entering = &fft->_raw_samples[fft->_window_size - advance];
+        for (uint16_t i = 0; i < advance; i++) {
+            sdft->_leaving_samples[i] = entering[i] - sdft->_leaving_samples[i];
+        }
+        sliding_dft_update(sdft, sdft->_leaving_samples, advance);
+    }
+    memcpy(sdft->_leaving_samples, fft->_raw_samples, sizeof(float) * advance);
+}
+
+// find the peaks in the tracked bins in the same way as step_cmplx_mag() and step_calc_frequencies() do
+// for the whole FFT, searching only the bins around the peaks from the last full FFT
+uint16_t DSP::fft_track_analyse(FFTWindowState* fft, SlidingDFTState* sdft, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    // averaging and frame averaging both need every bin
+    if (!sdft->_valid || sdft->_num_peaks == 0 || fft->_averaging || fft->_sliding_window != nullptr) {
+        return 0;
+    }
+
+    // apply the Hanning window in the frequency domain, the periodic window used by full FFTs
+    // w[n] = 0.5 - 0.5 * cos(2 pi n/N) gives W[k] = 0.5 * X[k] - 0.25 * (X[k-1] + X[k+1])
+    bool windowed[MAX_TRACKED_BINS] {};
+    bool start_bin_windowed = false;
+    for (uint8_t i = 1; i + 1 < sdft->_num_bins; i++) {
+        const uint16_t k = sdft->_bin_index[i];
+        if (sdft->_bin_index[i - 1] != k - 1 || sdft->_bin_index[i + 1] != k + 1) {
+            continue;
+        }
+        const float* x = &sdft->_bins[(i - 1) * 2];
+        const float re = 0.5f * x[2] - 0.25f * (x[0] + x[4]);
+        const float im = 0.5f * x[3] - 0.25f * (x[1] + x[5]);
+        fft->_rfft_data[k * 2] = re;
+        fft->_rfft_data[k * 2 + 1] = im;
+        fft->_freq_bins[k] = sq(re, im) * fft->_window_scale;
+        windowed[i] = true;
+        start_bin_windowed |= k == start_bin;
+    }
+
+    // peaks that were not found by the last full FFT stay at the start bin with no energy
+    if (!start_bin_windowed) {
+        fft->_freq_bins[start_bin] = 0.0f;
+    }
+    memset(fft->_peak_data, 0, sizeof(fft->_peak_data));
+    for (uint8_t p = 0; p < MAX_TRACKED_PEAKS; p++) {
+        fft->_peak_data[p]._bin = start_bin;
+        fft->_peak_data[p]._freq_hz = start_bin * fft->_bin_resolution;
+    }
+
+    for (uint8_t p = 0; p < sdft->_num_peaks; p++) {
+        const uint16_t center = sdft->_peak_bin[p];
+        // the highest bin that can be windowed and interpolated is _bin_count - 2
+        const uint16_t lowest = MAX(uint16_t(MAX(center, uint16_t(TRACKING_SEARCH_BINS)) - TRACKING_SEARCH_BINS), start_bin);
+        const uint16_t highest = MIN(uint16_t(center + TRACKING_SEARCH_BINS), uint16_t(fft->_bin_count - 2));
+
+        uint16_t peak_bin = 0;
+        float peak_energy = 0.0f;
+        for (uint8_t i = 0; i < sdft->_num_bins; i++) {
+            const uint16_t k = sdft->_bin_index[i];
+            if (windowed[i] && k >= lowest && k <= highest && fft->_freq_bins[k] > peak_energy) {
+                peak_energy = fft->_freq_bins[k];
+                peak_bin = k;
+            }
+        }
+
+        // a peak at the edge of the search range may have moved further than we can see
+        if (peak_bin == 0 || (peak_bin == lowest && lowest != start_bin)
+            || (peak_bin == highest && highest != fft->_bin_count - 2)) {
+            return 0;
+        }
+
+        uint16_t top = 0, bottom = 0;
+        const uint16_t width_start = MAX(uint16_t(lowest - 1), start_bin);
+        const uint16_t width_end = MAX(MIN(MIN(uint16_t(highest + 1), end_bin), uint16_t(fft->_bin_count - 1)), peak_bin);
+        fft->_peak_data[p]._bin = peak_bin;
+        fft->_peak_data[p]._noise_width_hz = find_noise_width(fft->_freq_bins, width_start, width_end, peak_bin, noise_att_cutoff, fft->_bin_resolution, top, bottom);
+        fft->_peak_data[p]._freq_hz = calc_frequency(fft, start_bin, peak_bin, end_bin);
+    }
+
+    return fft->_peak_data[CENTER]._bin;
+}
+
+// track the bins around the peaks found by the last full FFT of the window given to fft_track_start(),
+// bins that were already being tracked are carried over and the rest are calculated with Goertzel's algorithm
+void DSP::fft_track_retune(FFTWindowState* fft, SlidingDFTState* sdft)
+{
+    const uint8_t margin = TRACKING_SEARCH_BINS + 2;
+    uint16_t bin_index[MAX_TRACKED_BINS];
+    uint8_t num_bins = 0;
+
+    // insert the bins around each peak in ascending order
+    sdft->_num_peaks = fft->_num_peaks;
+    for (uint8_t p = 0; p < sdft->_num_peaks; p++) {
+        const uint16_t center = fft->_peak_data[p]._bin;
+        sdft->_peak_bin[p] = center;
+        const uint16_t lowest = MAX(center, uint16_t(margin)) - margin;
+        const uint16_t highest = MIN(uint16_t(center + margin), fft->_bin_count);
+        for (uint16_t k = lowest; k <= highest; k++) {
+            uint8_t i = 0;
+            while (i < num_bins && bin_index[i] < k) {
+                i++;
+            }
+            if (i < num_bins && bin_index[i] == k) {
+                continue;
+            }
+            memmove(&bin_index[i + 1], &bin_index[i], sizeof(uint16_t) * (num_bins - i));
+            bin_index[i] = k;
+            num_bins++;
+        }
+    }
+
+    const bool carry_over = sdft->_valid && sdft->_retunes < TRACKING_MAX_RETUNES;
+    float* bins = sdft->_scratch;
+    bool calculate[MAX_TRACKED_BINS] {};
+    bool carried = false;
+    memset(bins, 0, sizeof(sdft->_scratch));
+    for (uint8_t i = 0; i < num_bins; i++) {
+        const int16_t idx = carry_over ? sliding_dft_find(sdft, bin_index[i]) : -1;
+        if (idx >= 0) {
+            bins[i * 2] = sdft->_bins[idx * 2];
+            bins[i * 2 + 1] = sdft->_bins[idx * 2 + 1];
+            carried = true;
+        } else {
+            calculate[i] = true;
+        }
+    }
+
+    sdft->_num_bins = num_bins;
+    memcpy(sdft->_bin_index, bin_index, sizeof(uint16_t) * num_bins);
+    memcpy(sdft->_bins, bins, sizeof(sdft->_bins));
+    for (uint8_t i = 0; i < MAX_TRACKED_BINS; i++) {
+        const uint16_t k = i < num_bins ? sdft->_bin_index[i] : 0;
+        const float w = 2.0f * M_PI * k / fft->_window_size;
+        const float wh = 2.0f * M_PI * ((uint32_t(k) * sdft->_advance) % fft->_window_size) / fft->_window_size;
+        sdft->_cos[i] = cosf(w);
+        sdft->_sin[i] = sinf(w);
+        sdft->_advance_cos[i] = cosf(wh);
+        sdft->_advance_sin[i] = sinf(wh);
+    }
+
+    // the DFT of the whole window is a sliding update of an empty window
+    sliding_dft_update(sdft, fft->_raw_samples, fft->_window_size, calculate);
+
+    sdft->_retunes = carried ? sdft->_retunes + 1 : 0;
+    sdft->_valid = true;
+}
+
+// add len samples to the tracked bins, rotating them by the window advance.
+// Goertzel's algorithm gives sum y[j] * e^(-i w j) = e^(-i w (len-1)) * (s[len-1] - e^(-i w) * s[len-2])
+// for s[j] = y[j] + 2cos(w) * s[j-1] - s[j-2]. Every lane is run so that the loop has a fixed
+// trip count and vectorizes, unused lanes are simply not written back.
+void DSP::sliding_dft_update(SlidingDFTState* sdft, const float* samples, uint16_t len, const bool* update) const
+{
+    float* s1 = sdft->_scratch;
+    float* s2 = &sdft->_scratch[MAX_TRACKED_BINS];
+    memset(sdft->_scratch, 0, sizeof(sdft->_scratch));
+
+    for (uint16_t j = 0; j < len; j++) {
+        const float y = samples[j];
+        for (uint8_t i = 0; i < MAX_TRACKED_BINS; i++) {
+            const float s0 = y + 2.0f * sdft->_cos[i] * s1[i] - s2[i];
+            s2[i] = s1[i];
+            s1[i] = s0;
+        }
+    }
+
+    // X' = e^(i w H) * X + e^(i w) * s[len-1] - s[len-2]
+    for (uint8_t i = 0; i < sdft->_num_bins; i++) {
+        if (update != nullptr && !update[i]) {
+            continue;
+        }
+        const float re = sdft->_bins[i * 2];
+        const float im = sdft->_bins[i * 2 + 1];
+        sdft->_bins[i * 2] = re * sdft->_advance_cos[i] - im * sdft->_advance_sin[i] + sdft->_cos[i] * s1[i] - s2[i];
+        sdft->_bins[i * 2 + 1] = re * sdft->_advance_sin[i] + im * sdft->_advance_cos[i] + sdft->_sin[i] * s1[i];
+    }
+}
+
+// index of a tracked bin, or -1 if it is not tracked
+int16_t DSP::sliding_dft_find(const SlidingDFTState* sdft, uint16_t bin) const
+{
+    for (uint8_t i = 0; i < sdft->_num_bins; i++) {
+        if (sdft->_bin_index[i] == bin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // find all the peaks in the fft window using https://terpconnect.umd.edu/~toh/spectrum/PeakFindingandMeasurement.htm
 // in general peakgrup > 2 is only good for very broad noisy peaks, <= 2 better for spikey peaks, although 1 will miss
 // a true spike 50% of the time
@@ -491,4 +733,40 @@ void DSP::fastsmooth(float* input, uint16_t n, uint16_t smoothwidth) const
     }
 }
 
+void DSP::vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const
+{
+    *max_value = vin[0];
+    *max_index = 0;
+    for (uint16_t i = 1; i < len; i++) {
+        if (vin[i] > *max_value) {
+            *max_value = vin[i];
+            *max_index = i;
+        }
+    }
+}
+
+void DSP::vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const
+{
+    for (uint16_t i = 0; i < len; i++) {
+        vout[i] = vin[i] * scale;
+    }
+}
+
+void DSP::vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
+{
+    for (uint16_t i = 0; i < len; i++) {
+        vout[i] = vin1[i] + vin2[i];
+    }
+}
+
+float DSP::vector_mean_float(const float* vin, uint16_t len) const
+{
+    float mean_value = 0.0f;
+    for (uint16_t i = 0; i < len; i++) {
+        mean_value += vin[i];
+    }
+    mean_value /= len;
+    return mean_value;
+}
+
 #endif // HAL_WITH_DSP
@@ -48,6 +48,12 @@ public:
     };
 
     static const uint8_t MAX_SLIDING_WINDOW_SIZE = 8;
+    // bins either side of a tracked peak that are searched for its new position
+    static const uint8_t TRACKING_SEARCH_BINS = 2;
+    // raw bins needed per tracked peak are the search range plus the neighbours needed
+    // for the Hanning window and for Quinn's estimator, rounded up to a multiple of four
+    // so that the bins can always be updated together in vector lanes
+    static const uint8_t MAX_TRACKED_BINS = ((MAX_TRACKED_PEAKS * (2 * TRACKING_SEARCH_BINS + 5) + 3) / 4) * 4;
 
     class FFTWindowState {
     public:
@@ -73,6 +79,8 @@ public:
         float* _sliding_window;
         // three highest peaks
         FrequencyPeakData _peak_data[MAX_TRACKED_PEAKS];
+        // number of peaks found by the last analysis
+        uint8_t _num_peaks;
         // Hanning window for incoming samples, see https://en.wikipedia.org/wiki/Window_function#Hann_.28Hanning.29_window
         float* _hanning_window;
         // Use in calculating the PS of the signal [Heinz] equations (20) & (21)
@@ -83,6 +91,8 @@ public:
         uint32_t _averaging_samples;
         // current sliding window slice
         uint8_t _current_slice;
+        // unwindowed samples of the current window, used by peak tracking
+        float* _raw_samples;
         // get a frequency bin from an arbitrary slice
         float get_freq_bin(uint16_t idx) { return _sliding_window == nullptr ? _freq_bins[idx] : _avg_freq_bins[idx]; }
 
@@ -90,6 +100,45 @@ public:
         virtual ~FFTWindowState();
         FFTWindowState(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
     };
+
+    // sliding DFT of the bins around the peaks found by the last full FFT on one axis,
+    // allowing the peaks to be followed with only the samples that enter and leave the window
+    class SlidingDFTState {
+    public:
+        // number of samples the window moves between updates
+        const uint16_t _advance;
+        // samples that leave the window on the next update
+        float* _leaving_samples;
+        // number of tracked raw bins
+        uint8_t _num_bins;
+        // tracked raw bins in ascending order
+        uint16_t _bin_index[MAX_TRACKED_BINS];
+        // unwindowed DFT of the tracked bins as interleaved real and imaginary parts
+        float _bins[MAX_TRACKED_BINS * 2];
+        // cos and sin of each tracked bin's frequency in radians per sample
+        float _cos[MAX_TRACKED_BINS];
+        float _sin[MAX_TRACKED_BINS];
+        // rotation of each tracked bin caused by the window moving on
+        float _advance_cos[MAX_TRACKED_BINS];
+        float _advance_sin[MAX_TRACKED_BINS];
+        // bin each peak was centered on at the last full FFT
+        uint16_t _peak_bin[MAX_TRACKED_PEAKS];
+        // number of peaks being tracked
+        uint8_t _num_peaks;
+        // working space for retuning and for Goertzel's algorithm, which would otherwise need
+        // more stack than the FFT thread has
+        float _scratch[MAX_TRACKED_BINS * 2];
+        // number of retunes since the bins were last calculated from scratch
+        uint8_t _retunes;
+        // whether the tracked bins hold the DFT of the current window
+        bool _valid;
+
+        // stop tracking until the next full FFT, e.g. because samples were dropped
+        void reset() { _valid = false; }
+
+        ~SlidingDFTState();
+        SlidingDFTState(uint16_t advance);
+    };
     // initialise an FFT instance
     virtual FFTWindowState* fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size = 0) = 0;
     // start an FFT analysis with an ObjectBuffer
@@ -100,6 +149,14 @@ public:
     bool fft_start_average(FFTWindowState* fft);
     // finish the averaging process
     uint16_t fft_stop_average(FFTWindowState* fft, uint16_t start_bin, uint16_t end_bin, float* peaks);
+    // initialise tracking of peaks between full FFTs
+    SlidingDFTState* fft_init_tracking(FFTWindowState* fft, uint16_t advance);
+    // move the tracked bins on to the current window of samples without consuming them
+    void fft_track_start(FFTWindowState* fft, SlidingDFTState* sdft, FloatBuffer& samples);
+    // find the peaks in the tracked bins, returns 0 if a full FFT is required to find them
+    uint16_t fft_track_analyse(FFTWindowState* fft, SlidingDFTState* sdft, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff);
+    // track the bins around the peaks found by the last full FFT
+    void fft_track_retune(FFTWindowState* fft, SlidingDFTState* sdft);
 
 protected:
     // step 3: find the magnitudes of the complex data
@@ -113,14 +170,16 @@ protected:
     void update_average_from_sliding_window(FFTWindowState* fft);
     // calculate a single frequency
     uint16_t calc_frequency(FFTWindowState* fft, uint16_t start_bin, uint16_t peak_bin, uint16_t end_bin);
+    // vector operations, with portable implementations for HALs
+    // without an optimised DSP library
     // find the maximum value in an vector of floats
-    virtual void vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const = 0;
+    virtual void vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const;
     // find the mean value in an vector of floats
-    virtual float vector_mean_float(const float* vin, uint16_t len) const = 0;
+    virtual float vector_mean_float(const float* vin, uint16_t len) const;
     // multiply an vector of floats by a scale factor
-    virtual void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const = 0;
+    virtual void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const;
     // add two vectors together
-    virtual void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const = 0;
+    virtual void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const;
     // algorithm for finding peaks in noisy data as per https://terpconnect.umd.edu/~toh/spectrum/PeakFindingandMeasurement.htm
     uint16_t find_peaks(const float* input, uint16_t length, float* output, uint16_t* peaks, uint16_t peaklen, 
         float slopeThreshold, float ampThreshold, uint16_t smoothwidth, uint16_t peakgroup) const;
@@ -135,6 +194,10 @@ protected:
     float calculate_jains_estimator(const FFTWindowState* fft, const float* real_fft, uint16_t k_max);
     // init averaging FFT data
     bool fft_init_average(FFTWindowState* fft);
+    // add a block of samples to the tracked bins, or only to those selected by update
+    void sliding_dft_update(SlidingDFTState* sdft, const float* samples, uint16_t len, const bool* update = nullptr) const;
+    // index of a tracked bin, or -1 if it is not tracked
+    int16_t sliding_dft_find(const SlidingDFTState* sdft, uint16_t bin) const;
 
 #endif // HAL_WITH_DSP
 };
@@ -126,6 +126,18 @@ public:
         return false;
     }
 
+    FUNCTOR_TYPEDEF(ParallelProc, void, uint8_t);
+
+    /*
+      call proc(0) to proc(n-1) concurrently on worker threads,
+      returning once all calls have completed. Returns false without
+      calling proc if the HAL can't run work in parallel, in which
+      case the caller should make the calls itself
+     */
+    virtual bool run_parallel(ParallelProc proc, uint8_t n) {
+        return false;
+    }
+
 private:
 
     AP_HAL::Proc _delay_cb;
@@ -85,7 +85,7 @@
 #endif
 
 #ifndef HAL_GYROFFT_ENABLED
-#define HAL_GYROFFT_ENABLED 0
+#define HAL_GYROFFT_ENABLED 1
 #endif
 
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NONE
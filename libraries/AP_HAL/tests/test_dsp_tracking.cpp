@@ -0,0 +1,126 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_HAL/DSP.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+
+static const uint16_t SAMPLE_RATE = 1000;
+
+// a motor fundamental sweeping slowly upwards with its second harmonic and some noise
+static float sample(uint32_t n, float& phase, float& freq_hz)
+{
+    freq_hz = 120.0f + n * 0.002f;
+    phase += 2.0f * M_PI * freq_hz / SAMPLE_RATE;
+    return 10.0f * sinf(phase) + 4.0f * sinf(2.0f * phase) + 0.5f * sinf(n * 1.7f);
+}
+
+// run over several window sizes, the frequency domain window only matches the full FFT's window
+// exactly for the periodic Hanning window and the difference grows as the window gets smaller
+class DSPTrackingParameterizedTestFixture : public ::testing::TestWithParam<uint16_t> {
+};
+
+// the tracked peaks should follow the peaks found by a full FFT of the same samples
+TEST_P(DSPTrackingParameterizedTestFixture, FollowsFullFFT)
+{
+    const uint16_t WINDOW_SIZE = GetParam();
+    const uint16_t ADVANCE = WINDOW_SIZE / 4;
+    AP_HAL::DSP::FFTWindowState* tracked = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE);
+    AP_HAL::DSP::FFTWindowState* full = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE);
+    ASSERT_TRUE(tracked != nullptr && full != nullptr);
+    AP_HAL::DSP::SlidingDFTState* sdft = hal.dsp->fft_init_tracking(tracked, ADVANCE);
+    ASSERT_TRUE(sdft != nullptr);
+
+    FloatBuffer tracked_samples(WINDOW_SIZE + ADVANCE);
+    FloatBuffer full_samples(WINDOW_SIZE + ADVANCE);
+    uint32_t n = 0;
+    float phase = 0.0f;
+    float freq_hz = 0.0f;
+    uint16_t tracked_frames = 0;
+    const uint16_t start_bin = MAX(20 * WINDOW_SIZE / SAMPLE_RATE, 1);
+    const uint16_t end_bin = 400 * WINDOW_SIZE / SAMPLE_RATE;
+
+    for (uint16_t frame = 0; frame < 400; frame++) {
+        while (tracked_samples.available() < WINDOW_SIZE) {
+            const float s = sample(n++, phase, freq_hz);
+            tracked_samples.push(s);
+            full_samples.push(s);
+        }
+
+        hal.dsp->fft_start(full, full_samples, ADVANCE);
+        const uint16_t full_bin = hal.dsp->fft_analyse(full, start_bin, end_bin, 0.5f);
+
+        hal.dsp->fft_track_start(tracked, sdft, tracked_samples);
+        // a full FFT every eighth frame, as AP_GyroFFT does
+        uint16_t bin = (frame % 8 == 0) ? 0 : hal.dsp->fft_track_analyse(tracked, sdft, start_bin, end_bin, 0.5f);
+        if (bin > 0) {
+            tracked_samples.advance(ADVANCE);
+            tracked_frames++;
+            EXPECT_EQ(full_bin, bin);
+            EXPECT_NEAR(full->_peak_data[0]._freq_hz, tracked->_peak_data[0]._freq_hz, tracked->_bin_resolution);
+            EXPECT_NEAR(full->_freq_bins[bin], tracked->_freq_bins[bin], full->_freq_bins[bin] * 0.05f);
+        } else {
+            hal.dsp->fft_start(tracked, tracked_samples, ADVANCE);
+            bin = hal.dsp->fft_analyse(tracked, start_bin, end_bin, 0.5f);
+            hal.dsp->fft_track_retune(tracked, sdft);
+        }
+        EXPECT_NEAR(freq_hz, tracked->_peak_data[0]._freq_hz, tracked->_bin_resolution);
+    }
+
+    // peaks only fall back to a full FFT when they drift away from the tracked bins
+    EXPECT_GT(tracked_frames, 300);
+
+    delete sdft;
+    delete tracked;
+    delete full;
+}
+
+// a gap in the samples must be picked up by a full FFT
+TEST_P(DSPTrackingParameterizedTestFixture, ResetNeedsFullFFT)
+{
+    const uint16_t WINDOW_SIZE = GetParam();
+    const uint16_t ADVANCE = WINDOW_SIZE / 4;
+    const uint16_t start_bin = MAX(20 * WINDOW_SIZE / SAMPLE_RATE, 1);
+    const uint16_t end_bin = 400 * WINDOW_SIZE / SAMPLE_RATE;
+    AP_HAL::DSP::FFTWindowState* fft = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE);
+    ASSERT_TRUE(fft != nullptr);
+    AP_HAL::DSP::SlidingDFTState* sdft = hal.dsp->fft_init_tracking(fft, ADVANCE);
+    ASSERT_TRUE(sdft != nullptr);
+
+    FloatBuffer samples(WINDOW_SIZE + ADVANCE);
+    uint32_t n = 0;
+    float phase = 0.0f;
+    float freq_hz;
+    while (samples.available() < WINDOW_SIZE) {
+        samples.push(sample(n++, phase, freq_hz));
+    }
+    hal.dsp->fft_track_start(fft, sdft, samples);
+    EXPECT_EQ(hal.dsp->fft_track_analyse(fft, sdft, start_bin, end_bin, 0.5f), 0);
+    hal.dsp->fft_start(fft, samples, ADVANCE);
+    hal.dsp->fft_analyse(fft, start_bin, end_bin, 0.5f);
+    hal.dsp->fft_track_retune(fft, sdft);
+
+    while (samples.available() < WINDOW_SIZE) {
+        samples.push(sample(n++, phase, freq_hz));
+    }
+    hal.dsp->fft_track_start(fft, sdft, samples);
+    EXPECT_GT(hal.dsp->fft_track_analyse(fft, sdft, start_bin, end_bin, 0.5f), 0);
+
+    sdft->reset();
+    hal.dsp->fft_track_start(fft, sdft, samples);
+    EXPECT_EQ(hal.dsp->fft_track_analyse(fft, sdft, start_bin, end_bin, 0.5f), 0);
+
+    delete sdft;
+    delete fft;
+}
+
+INSTANTIATE_TEST_CASE_P(
+        dsp_tracking_Test,
+        DSPTrackingParameterizedTestFixture,
+        ::testing::Values(32, 64, 256));
+
+#endif // HAL_WITH_DSP
+
+AP_GTEST_MAIN()
@@ -0,0 +1,95 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_WITH_DSP
+
+#include <AP_Math/AP_Math.h>
+#include "DSP_RealFFT.h"
+
+using namespace ap;
+
+// The algorithms originally came from betaflight but are now substantially modified based on theory and experiment.
+// https://holometer.fnal.gov/GH_FFT.pdf "Spectrum and spectral density estimation by the Discrete Fourier transform (DFT),
+// including a comprehensive list of window functions and some new flat-top windows." - Heinzel et. al is a great reference
+// for understanding the underlying theory although we do not use spectral density here since time resolution is equally
+// important as frequency resolution. Referred to as [Heinz] throughout the code.
+
+// initialize the FFT state machine
+AP_HAL::DSP::FFTWindowState* DSP_RealFFT::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+{
+    FFTWindowStateRealFFT* fft = NEW_NOTHROW FFTWindowStateRealFFT(window_size, sample_rate, sliding_window_size);
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr
+        || fft->_rfft.size() != window_size) {
+        delete fft;
+        return nullptr;
+    }
+    return fft;
+}
+
+// start an FFT analysis
+void DSP_RealFFT::fft_start(AP_HAL::DSP::FFTWindowState* state, FloatBuffer& samples, uint16_t advance)
+{
+    step_hanning((FFTWindowStateRealFFT*)state, samples, advance);
+}
+
+// perform remaining steps of an FFT analysis
+uint16_t DSP_RealFFT::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    FFTWindowStateRealFFT* fft = (FFTWindowStateRealFFT*)state;
+    step_fft(fft);
+    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(fft, start_bin, end_bin);
+}
+
+// create an instance of the FFT state machine
+DSP_RealFFT::FFTWindowStateRealFFT::FFTWindowStateRealFFT(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+    : AP_HAL::DSP::FFTWindowState::FFTWindowState(window_size, sample_rate, sliding_window_size)
+{
+    if (_freq_bins == nullptr || _hanning_window == nullptr || _rfft_data == nullptr || _derivative_freq_bins == nullptr) {
+        return;
+    }
+    // failure is picked up by fft_init()
+    _rfft.init(window_size);
+}
+
+// step 1: filter the incoming samples through a Hanning window
+void DSP_RealFFT::step_hanning(FFTWindowStateRealFFT* fft, FloatBuffer& samples, uint16_t advance)
+{
+    // apply hanning window to gyro samples and store result in _freq_bins
+    uint32_t read_window = samples.peek(&fft->_freq_bins[0], fft->_window_size);
+    if (read_window != fft->_window_size) {
+        return;
+    }
+    samples.advance(advance);
+    for (uint16_t i = 0; i < fft->_window_size; i++) {
+        fft->_freq_bins[i] *= fft->_hanning_window[i];
+    }
+}
+
+// step 2: perform a real FFT on the windowed data
+void DSP_RealFFT::step_fft(FFTWindowStateRealFFT* fft)
+{
+    // bins 0 to _bin_count as interleaved real and imaginary parts,
+    // components at the nyquist frequency are real only
+    fft->_rfft.transform(fft->_freq_bins, fft->_rfft_data);
+
+    for (uint16_t i = 0, j = 0; i < fft->_bin_count; i++, j += 2) {
+        fft->_freq_bins[i] = sq(fft->_rfft_data[j], fft->_rfft_data[j+1]);
+    }
+}
+
+#endif
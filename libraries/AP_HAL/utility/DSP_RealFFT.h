@@ -0,0 +1,53 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_WITH_DSP
+
+#include "RealFFT.h"
+
+namespace ap {
+
+// FFT analysis using the portable real FFT, for HALs without a vendor
+// DSP library such as SITL and Linux
+class DSP_RealFFT : public AP_HAL::DSP {
+public:
+    // initialise an FFT instance
+    FFTWindowState* fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size) override;
+    // start an FFT analysis with an ObjectBuffer
+    void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) override;
+    // perform remaining steps of an FFT analysis
+    uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
+
+    class FFTWindowStateRealFFT : public AP_HAL::DSP::FFTWindowState {
+        friend class ap::DSP_RealFFT;
+
+    public:
+        FFTWindowStateRealFFT(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
+
+    private:
+        RealFFT _rfft;
+    };
+
+private:
+    void step_hanning(FFTWindowStateRealFFT* fft, FloatBuffer& samples, uint16_t advance);
+    void step_fft(FFTWindowStateRealFFT* fft);
+};
+
+}
+
+#endif
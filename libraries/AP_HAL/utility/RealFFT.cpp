@@ -0,0 +1,184 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RealFFT.h"
+
+#include <AP_Common/AP_Common.h>
+#include <math.h>
+
+RealFFT::~RealFFT()
+{
+    free_tables();
+}
+
+void RealFFT::free_tables()
+{
+    delete[] _bitrev;
+    _bitrev = nullptr;
+    delete[] _stage_cos;
+    _stage_cos = nullptr;
+    delete[] _stage_sin;
+    _stage_sin = nullptr;
+    delete[] _split_cos;
+    _split_cos = nullptr;
+    delete[] _split_sin;
+    _split_sin = nullptr;
+    delete[] _re;
+    _re = nullptr;
+    delete[] _im;
+    _im = nullptr;
+    _n = 0;
+    _half = 0;
+}
+
+bool RealFFT::init(uint16_t n)
+{
+    free_tables();
+    if (n < 4 || (n & (n - 1)) != 0) {
+        return false;
+    }
+
+    const uint16_t half = n / 2;
+    _bitrev = NEW_NOTHROW uint16_t[half];
+    _stage_cos = NEW_NOTHROW float[half];
+    _stage_sin = NEW_NOTHROW float[half];
+    _split_cos = NEW_NOTHROW float[half/2 + 1];
+    _split_sin = NEW_NOTHROW float[half/2 + 1];
+    _re = NEW_NOTHROW float[half];
+    _im = NEW_NOTHROW float[half];
+    if (_bitrev == nullptr || _stage_cos == nullptr || _stage_sin == nullptr ||
+        _split_cos == nullptr || _split_sin == nullptr || _re == nullptr || _im == nullptr) {
+        free_tables();
+        return false;
+    }
+    _n = n;
+    _half = half;
+
+    uint16_t bits = 0;
+    while ((1U << bits) < half) {
+        bits++;
+    }
+    for (uint16_t k = 0; k < half; k++) {
+        uint16_t r = 0;
+        for (uint16_t b = 0; b < bits; b++) {
+            r |= ((k >> b) & 1U) << (bits - 1 - b);
+        }
+        _bitrev[k] = r;
+    }
+
+    // twiddles are calculated in double so the larger tables are no
+    // less accurate than the smaller ones
+    for (uint16_t h = 1; h < half; h <<= 1) {
+        for (uint16_t j = 0; j < h; j++) {
+            const double angle = -M_PI * j / h;
+            _stage_cos[h - 1 + j] = cos(angle);
+            _stage_sin[h - 1 + j] = sin(angle);
+        }
+    }
+    for (uint16_t k = 0; k <= half/2; k++) {
+        const double angle = -2.0 * M_PI * k / n;
+        _split_cos[k] = cos(angle);
+        _split_sin[k] = sin(angle);
+    }
+    return true;
+}
+
+void RealFFT::transform(const float *in, float *out)
+{
+    const uint16_t half = _half;
+    float *re = _re;
+    float *im = _im;
+
+    // pairs of real samples as complex samples, in bit reversed order
+    for (uint16_t k = 0; k < half; k++) {
+        const uint16_t r = _bitrev[k];
+        re[r] = in[2*k];
+        im[r] = in[2*k + 1];
+    }
+
+    // the first two stages have trivial twiddles, so do them together
+    // as a radix-4 pass
+    if (half >= 4) {
+        for (uint16_t i = 0; i < half; i += 4) {
+            const float ar = re[i] + re[i+1];
+            const float ai = im[i] + im[i+1];
+            const float br = re[i] - re[i+1];
+            const float bi = im[i] - im[i+1];
+            const float cr = re[i+2] + re[i+3];
+            const float ci = im[i+2] + im[i+3];
+            // (re[i+2] - re[i+3]) * -i
+            const float dr = im[i+2] - im[i+3];
+            const float di = re[i+3] - re[i+2];
+            re[i]   = ar + cr;
+            im[i]   = ai + ci;
+            re[i+2] = ar - cr;
+            im[i+2] = ai - ci;
+            re[i+1] = br + dr;
+            im[i+1] = bi + di;
+            re[i+3] = br - dr;
+            im[i+3] = bi - di;
+        }
+    } else {
+        for (uint16_t i = 0; i < half; i += 2) {
+            const float tr = re[i+1];
+            const float ti = im[i+1];
+            re[i+1] = re[i] - tr;
+            im[i+1] = im[i] - ti;
+            re[i] += tr;
+            im[i] += ti;
+        }
+    }
+
+    for (uint16_t h = 4; h < half; h <<= 1) {
+        const float *wc = &_stage_cos[h - 1];
+        const float *ws = &_stage_sin[h - 1];
+        for (uint16_t start = 0; start < half; start += 2*h) {
+            float *r0 = &re[start];
+            float *i0 = &im[start];
+            float *r1 = &re[start + h];
+            float *i1 = &im[start + h];
+            for (uint16_t j = 0; j < h; j++) {
+                const float tr = r1[j] * wc[j] - i1[j] * ws[j];
+                const float ti = r1[j] * ws[j] + i1[j] * wc[j];
+                r1[j] = r0[j] - tr;
+                i1[j] = i0[j] - ti;
+                r0[j] += tr;
+                i0[j] += ti;
+            }
+        }
+    }
+
+    // split the transform Z of the complex samples into the real
+    // transform X. With A = Z[k] and B = Z[half-k], the even and odd
+    // sample transforms are E = (A + B*)/2 and O = (A - B*)/2i, giving
+    // X[k] = E + W^k O and X[half-k] = (E - W^k O)*
+    out[0] = re[0] + im[0];
+    out[1] = 0;
+    out[2*half] = re[0] - im[0];
+    out[2*half + 1] = 0;
+    for (uint16_t k = 1; k <= half/2; k++) {
+        const uint16_t m = half - k;
+        const float er = 0.5f * (re[k] + re[m]);
+        const float ei = 0.5f * (im[k] - im[m]);
+        const float or_ = 0.5f * (im[k] + im[m]);
+        const float oi = 0.5f * (re[m] - re[k]);
+        const float tr = or_ * _split_cos[k] - oi * _split_sin[k];
+        const float ti = or_ * _split_sin[k] + oi * _split_cos[k];
+        out[2*k] = er + tr;
+        out[2*k + 1] = ei + ti;
+        out[2*m] = er - tr;
+        out[2*m + 1] = ti - ei;
+    }
+}
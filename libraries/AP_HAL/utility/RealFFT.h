@@ -0,0 +1,67 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+  forward FFT of real samples for HALs without a vendor DSP library.
+
+  The n real samples are treated as n/2 complex samples, transformed
+  with an iterative radix-2 FFT and then split into the n/2+1 bins of
+  the real transform. Bit reversal and all twiddle factors are
+  calculated once by init(). The complex data is held as separate
+  real and imaginary arrays and each stage's twiddles are contiguous,
+  so the butterfly loops can be vectorised by the compiler.
+
+  Bins follow the usual convention X[k] = sum x[j] e^(-2 pi i jk/n),
+  the same as arm_rfft_fast_f32()
+ */
+class RealFFT {
+public:
+    RealFFT() {}
+    ~RealFFT();
+
+    RealFFT(const RealFFT &other) = delete;
+    RealFFT &operator=(const RealFFT&) = delete;
+
+    // prepare for transforms of n real samples, n must be a power of
+    // two of at least 4. Returns false if the tables could not be
+    // allocated
+    bool init(uint16_t n);
+
+    // transform n real samples into bins 0 to n/2, written to out as
+    // interleaved real and imaginary parts, so out must hold n+2 floats
+    void transform(const float *in, float *out);
+
+    uint16_t size() const { return _n; }
+
+private:
+    void free_tables();
+
+    uint16_t _n = 0;        // number of real samples
+    uint16_t _half = 0;     // number of complex samples, n/2
+    uint16_t *_bitrev = nullptr; // bit reversed position of each complex sample
+    // twiddles for the complex FFT, stage with half-length h at [h-1, 2h-1)
+    float *_stage_cos = nullptr;
+    float *_stage_sin = nullptr;
+    // e^(-2 pi i k/n) for k in [0, n/4], used to split the complex
+    // result into the real transform
+    float *_split_cos = nullptr;
+    float *_split_sin = nullptr;
+    // complex work buffer
+    float *_re = nullptr;
+    float *_im = nullptr;
+};
@@ -2,10 +2,19 @@
 
 #include <atomic>
 #include <stdint.h>
+#include <string.h>
 #include <AP_HAL/AP_HAL_Boards.h>
 #include <AP_HAL/AP_HAL_Macros.h>
 #include <AP_HAL/Semaphores.h>
 
+#ifndef HAL_CACHE_LINE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
+#define HAL_CACHE_LINE_SIZE 32
+#else
+#define HAL_CACHE_LINE_SIZE 64
+#endif
+#endif
+
 /*
  * Circular buffer of bytes.
  */
@@ -461,6 +470,255 @@ private:
     HAL_Semaphore sem;
 };
 
+/*
+  lock-free ring buffer for objects of fixed size, for use where there
+  is exactly one producer thread and one consumer thread, so neither
+  side needs a semaphore. The read and write indexes are kept on
+  separate cache lines, and each side keeps a cached copy of the other
+  side's index so it only touches the other side's cache line when the
+  buffer looks full (or empty).
+
+  push(), reserve() and commit() may only be called from the producer
+  thread. pop(), peek(), readptr() and advance() may only be called
+  from the consumer thread. set_size() and clear() need both threads
+  to be idle
+ */
+template <class T>
+class ObjectBuffer_SPSC {
+public:
+    ObjectBuffer_SPSC(uint32_t _size = 0) {
+        set_size(_size);
+    }
+    ~ObjectBuffer_SPSC(void) {
+        delete[] buffer;
+    }
+
+    CLASS_NO_COPY(ObjectBuffer_SPSC);
+
+    // return number of objects the buffer can hold
+    uint32_t get_size(void) const {
+        return size>0?size-1:0;
+    }
+
+    // set size of ringbuffer, caller responsible for locking
+    bool set_size(uint32_t _size) {
+        clear();
+        if (_size+1 == size) {
+            return true;
+        }
+        delete[] buffer;
+        buffer = nullptr;
+        size = 0;
+        if (_size == 0) {
+            return true;
+        }
+        // one slot is always left empty to tell full from empty
+        buffer = NEW_NOTHROW T[_size+1];
+        if (buffer == nullptr) {
+            return false;
+        }
+        size = _size+1;
+        return true;
+    }
+
+    // Discards the buffer content, emptying it.
+    void clear(void) {
+        head.store(0);
+        tail.store(0);
+        tail_cache = 0;
+        head_cache = 0;
+    }
+
+    /*
+      consumer side
+     */
+
+    // return number of objects available to be read from the front
+    // of the queue. This may also be called from the producer thread
+    uint32_t available(void) const {
+        return count(head.load(std::memory_order_relaxed), tail.load(std::memory_order_acquire));
+    }
+
+    // true is available() == 0
+    bool is_empty(void) const WARN_IF_UNUSED {
+        return available() == 0;
+    }
+
+    // pop earliest object off the front of the queue
+    bool pop(T &object) WARN_IF_UNUSED {
+        return pop(&object, 1) == 1;
+    }
+
+    // pop up to n objects off the front of the queue, returning the
+    // number popped
+    uint32_t pop(T *data, uint32_t n) {
+        n = peek(data, n);
+        advance(n);
+        return n;
+    }
+
+    // copy an object out from the front of the queue without advancing the read pointer
+    bool peek(T &object) WARN_IF_UNUSED {
+        return peek(&object, 1) == 1;
+    }
+
+    // read up to n objects without advancing the read pointer
+    uint32_t peek(T *data, uint32_t n) {
+        const uint32_t avail = consumer_available(n);
+        if (n > avail) {
+            n = avail;
+        }
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        const uint32_t n1 = (size - h) < n ? (size - h) : n;
+        memcpy(data, &buffer[h], n1*sizeof(T));
+        memcpy(&data[n1], &buffer[0], (n-n1)*sizeof(T));
+        return n;
+    }
+
+    /*
+      return a pointer to first contiguous array of available
+      objects. Return nullptr if none available
+     */
+    const T *readptr(uint32_t &n) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        const uint32_t avail = consumer_available(UINT32_MAX);
+        n = (size - h) < avail ? (size - h) : avail;
+        return n ? &buffer[h] : nullptr;
+    }
+
+    // advance the read pointer (discarding objects)
+    bool advance(uint32_t n) {
+        if (n > consumer_available(n)) {
+            return false;
+        }
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        head.store((h + n) % size, std::memory_order_release);
+        return true;
+    }
+
+    /*
+      producer side
+     */
+
+    // return number of objects that could be written to the back of
+    // the queue. This may also be called from the consumer thread
+    uint32_t space(void) const {
+        if (size == 0) {
+            return 0;
+        }
+        return size - 1 - count(head.load(std::memory_order_acquire), tail.load(std::memory_order_relaxed));
+    }
+
+    // push one object onto the back of the queue
+    bool push(const T &object) {
+        return push(&object, 1);
+    }
+
+    // push N objects onto the back of the queue. Either all or none are pushed
+    bool push(const T *object, uint32_t n) {
+        Span vec[2];
+        if (producer_space(n) < n) {
+            return false;
+        }
+        const uint8_t n_vec = reserve(vec, n);
+        uint32_t ofs = 0;
+        for (uint8_t v=0; v<n_vec; v++) {
+            memcpy(vec[v].data, &object[ofs], vec[v].len*sizeof(T));
+            ofs += vec[v].len;
+        }
+        return commit(n);
+    }
+
+    /*
+      reserve space for up to n objects, filling in vec with the one or
+      two contiguous parts of the buffer that may be written to.
+      Returns the number of parts. The objects become visible to the
+      consumer when commit() is called, which allows a batch of
+      objects to be published at once
+     */
+    struct Span {
+        T *data;
+        uint32_t len;
+    };
+    uint8_t reserve(Span vec[2], uint32_t n) {
+        const uint32_t avail = producer_space(n);
+        if (n > avail) {
+            n = avail;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        vec[0].data = &buffer[t];
+        if (n <= size - t) {
+            vec[0].len = n;
+            return 1;
+        }
+        vec[0].len = size - t;
+        vec[1].data = &buffer[0];
+        vec[1].len = n - vec[0].len;
+        return 2;
+    }
+
+    // publish n objects previously written to space from reserve()
+    bool commit(uint32_t n) {
+        if (n > producer_space(n)) {
+            return false;
+        }
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        tail.store((t + n) % size, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // number of objects readable by the consumer. The producer's index
+    // is only re-read if fewer than need objects appear to be available
+    uint32_t consumer_available(uint32_t need) const {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t avail = count(h, tail_cache);
+        if (avail < need) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            avail = count(h, tail_cache);
+        }
+        return avail;
+    }
+
+    // number of objects writable by the producer. The consumer's index
+    // is only re-read if there appears to be room for fewer than need
+    uint32_t producer_space(uint32_t need) const {
+        if (size == 0) {
+            return 0;
+        }
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t space = size - 1 - count(head_cache, t);
+        if (space < need) {
+            head_cache = head.load(std::memory_order_acquire);
+            space = size - 1 - count(head_cache, t);
+        }
+        return space;
+    }
+
+    // number of objects between a read and a write index
+    uint32_t count(uint32_t h, uint32_t t) const {
+        return t >= h ? t - h : size - h + t;
+    }
+
+    T *buffer = nullptr;
+    uint32_t size = 0;
+
+    uint8_t pad0[HAL_CACHE_LINE_SIZE];
+
+    // owned by the consumer
+    std::atomic<uint32_t> head{0};
+    mutable uint32_t tail_cache = 0;
+
+    uint8_t pad1[HAL_CACHE_LINE_SIZE];
+
+    // owned by the producer
+    std::atomic<uint32_t> tail{0};
+    mutable uint32_t head_cache = 0;
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
@@ -0,0 +1,89 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/RealFFT.h>
+#include <math.h>
+#include <stdlib.h>
+
+// direct DFT of n real samples, bins 0 to n/2
+static void dft(const float *in, uint16_t n, double *out)
+{
+    for (uint16_t k = 0; k <= n/2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t j = 0; j < n; j++) {
+            const double angle = -2.0 * M_PI * ((uint32_t(j) * k) % n) / n;
+            re += in[j] * cos(angle);
+            im += in[j] * sin(angle);
+        }
+        out[2*k] = re;
+        out[2*k + 1] = im;
+    }
+}
+
+static void check_size(uint16_t n)
+{
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(n));
+    EXPECT_EQ(fft.size(), n);
+
+    float *in = new float[n];
+    float *out = new float[n + 2];
+    double *expected = new double[n + 2];
+
+    // a gyro-like signal: two tones, an offset and some noise
+    srand(n);
+    for (uint16_t i = 0; i < n; i++) {
+        in[i] = 0.3f + sinf(2 * M_PI * i * 7.3f / n) + 0.5f * cosf(2 * M_PI * i * 0.21f)
+            + 0.1f * (rand() / float(RAND_MAX) - 0.5f);
+    }
+
+    dft(in, n, expected);
+    fft.transform(in, out);
+
+    // allow for float rounding growing with log2(n)
+    double peak = 0;
+    for (uint16_t i = 0; i < n + 2; i++) {
+        peak = MAX(peak, fabs(expected[i]));
+    }
+    const double tolerance = 1.0e-6 * peak * log2(n) + 1.0e-5;
+    for (uint16_t i = 0; i < n + 2; i++) {
+        EXPECT_NEAR(out[i], expected[i], tolerance) << "n=" << n << " i=" << i;
+    }
+
+    delete[] in;
+    delete[] out;
+    delete[] expected;
+}
+
+TEST(RealFFT, MatchesDFT)
+{
+    for (uint16_t n = 4; n <= 1024; n *= 2) {
+        check_size(n);
+    }
+}
+
+TEST(RealFFT, BadSizes)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(0));
+    EXPECT_FALSE(fft.init(2));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_EQ(fft.size(), 0);
+}
+
+TEST(RealFFT, Reinit)
+{
+    // an engine can be reused for another size
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(256));
+    ASSERT_TRUE(fft.init(32));
+    float in[32] {};
+    float out[34];
+    in[0] = 1;
+    fft.transform(in, out);
+    for (uint8_t k = 0; k <= 16; k++) {
+        EXPECT_FLOAT_EQ(out[2*k], 1.0f);
+        EXPECT_FLOAT_EQ(out[2*k + 1], 0.0f);
+    }
+}
+
+AP_GTEST_MAIN()
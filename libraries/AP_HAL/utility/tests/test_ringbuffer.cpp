@@ -122,4 +122,95 @@ TEST(ObjectBufferTest, PeekTest)
     }
 }
 
+TEST(ObjectBufferSPSCTest, Basic)
+{
+    const uint16_t size = 32;
+    ObjectBuffer_SPSC<uint32_t> x{size};
+    EXPECT_EQ(x.available(), 0U);
+    EXPECT_EQ(x.get_size(), unsigned(size));
+    EXPECT_EQ(x.space(), unsigned(size));
+    EXPECT_TRUE(x.is_empty());
+
+    EXPECT_TRUE(x.push(17U));
+    EXPECT_EQ(x.available(), 1U);
+    EXPECT_EQ(x.space(), unsigned(size-1));
+    uint32_t v = 0;
+    EXPECT_TRUE(x.peek(v));
+    EXPECT_EQ(v, 17U);
+    EXPECT_TRUE(x.pop(v));
+    EXPECT_EQ(v, 17U);
+    EXPECT_TRUE(x.is_empty());
+    EXPECT_FALSE(x.pop(v));
+
+    // fill it up, pushes are all or nothing
+    uint32_t data[size+1];
+    for (uint32_t i=0; i<size+1; i++) {
+        data[i] = i;
+    }
+    EXPECT_FALSE(x.push(data, size+1));
+    EXPECT_TRUE(x.push(data, size));
+    EXPECT_EQ(x.space(), 0U);
+    EXPECT_FALSE(x.push(data[0]));
+    uint32_t out[size] {};
+    EXPECT_EQ(x.pop(out, size), unsigned(size));
+    for (uint32_t i=0; i<size; i++) {
+        EXPECT_EQ(out[i], i);
+    }
+}
+
+TEST(ObjectBufferSPSCTest, Wraparound)
+{
+    ObjectBuffer_SPSC<uint16_t> x{10};
+    uint16_t next_push = 0;
+    uint16_t next_pop = 0;
+    for (uint8_t i=0; i<100; i++) {
+        const uint16_t in[3] { next_push, uint16_t(next_push+1), uint16_t(next_push+2) };
+        EXPECT_TRUE(x.push(in, 3));
+        next_push += 3;
+        uint16_t out[3];
+        EXPECT_EQ(x.pop(out, 3), 3U);
+        for (uint8_t j=0; j<3; j++) {
+            EXPECT_EQ(out[j], next_pop++);
+        }
+    }
+    EXPECT_TRUE(x.is_empty());
+}
+
+TEST(ObjectBufferSPSCTest, ReserveCommit)
+{
+    ObjectBuffer_SPSC<uint8_t> x{16};
+    // move the indexes part way through the buffer
+    uint8_t tmp[12] {};
+    EXPECT_TRUE(x.push(tmp, 12));
+    EXPECT_TRUE(x.advance(12));
+
+    ObjectBuffer_SPSC<uint8_t>::Span vec[2];
+    EXPECT_EQ(x.reserve(vec, 10), 2);
+    EXPECT_EQ(vec[0].len + vec[1].len, 10U);
+    uint8_t v = 0;
+    for (uint8_t i=0; i<2; i++) {
+        for (uint32_t j=0; j<vec[i].len; j++) {
+            vec[i].data[j] = v++;
+        }
+    }
+    // nothing is visible until committed
+    EXPECT_TRUE(x.is_empty());
+    EXPECT_TRUE(x.commit(10));
+    EXPECT_EQ(x.available(), 10U);
+
+    // readptr gives the part up to the end of the buffer
+    uint32_t n = 0;
+    const uint8_t *p = x.readptr(n);
+    EXPECT_NE(p, nullptr);
+    EXPECT_EQ(n, vec[0].len);
+    EXPECT_EQ(p[0], 0);
+    EXPECT_TRUE(x.advance(n));
+    p = x.readptr(n);
+    EXPECT_EQ(n, vec[1].len);
+    EXPECT_EQ(p[0], vec[0].len);
+    EXPECT_TRUE(x.advance(n));
+    EXPECT_FALSE(x.advance(1));
+    EXPECT_EQ(x.readptr(n), nullptr);
+}
+
 AP_GTEST_MAIN()
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <errno.h>
 #include <poll.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/mman.h>
@@ -362,6 +363,11 @@ bool Scheduler::SchedulerThread::_run()
 
 void Scheduler::teardown()
 {
+    for (uint8_t i = 0; i < _num_parallel_workers; i++) {
+        _parallel_workers[i].stop();
+        _parallel_workers[i].join();
+    }
+
     _timer_thread.stop();
     _io_thread.stop();
     _rcin_thread.stop();
@@ -432,3 +438,96 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
 
     return true;
 }
+
+/*
+  start the worker threads used by run_parallel(), one per CPU
+  available to us beyond the one the main thread runs on. Each worker
+  is pinned to its own CPU and runs at main thread priority so that it
+  behaves as an extension of the main loop
+ */
+bool Scheduler::init_parallel_workers()
+{
+    _parallel_init_done = true;
+
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+        return false;
+    }
+    const int main_cpu = sched_getcpu();
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && _num_parallel_workers < LINUX_SCHEDULER_MAX_PARALLEL_WORKERS; cpu++) {
+        if (!CPU_ISSET(cpu, &cpus) || cpu == main_cpu) {
+            continue;
+        }
+        ParallelWorker &w = _parallel_workers[_num_parallel_workers];
+        w.setup(*this, _num_parallel_workers+1);
+        w.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
+        if (!w.start("ap-parallel", SCHED_FIFO, APM_LINUX_MAIN_PRIORITY)) {
+            break;
+        }
+        cpu_set_t pin;
+        CPU_ZERO(&pin);
+        CPU_SET(cpu, &pin);
+        w.set_affinity(pin);
+        _num_parallel_workers++;
+    }
+
+    return _num_parallel_workers > 0;
+}
+
+bool Scheduler::run_parallel(ParallelProc proc, uint8_t n)
+{
+    if (!in_main_thread() || n == 0) {
+        return false;
+    }
+    if (!_parallel_init_done) {
+        init_parallel_workers();
+    }
+    if (_num_parallel_workers == 0) {
+        return false;
+    }
+
+    _parallel_proc = proc;
+    _parallel_count = n;
+
+    // items are dealt out round-robin, with the main thread taking
+    // item 0 so it is never left idle waiting for the workers
+    const uint8_t nworkers = MIN(_num_parallel_workers, uint8_t(n-1));
+    for (uint8_t i = 0; i < nworkers; i++) {
+        _parallel_workers[i].start_sem.signal();
+    }
+    run_parallel_items(0);
+    for (uint8_t i = 0; i < nworkers; i++) {
+        _parallel_workers[i].done_sem.wait_blocking();
+    }
+
+    return true;
+}
+
+void Scheduler::run_parallel_items(uint8_t index)
+{
+    const uint8_t stride = MIN(_num_parallel_workers, uint8_t(_parallel_count-1)) + 1;
+    for (uint8_t i = index; i < _parallel_count; i += stride) {
+        _parallel_proc(i);
+    }
+}
+
+bool Scheduler::ParallelWorker::_run()
+{
+    while (true) {
+        start_sem.wait_blocking();
+        if (_should_exit) {
+            break;
+        }
+        _sched->run_parallel_items(_index);
+        done_sem.signal();
+    }
+    return true;
+}
+
+bool Scheduler::ParallelWorker::stop()
+{
+    _should_exit = true;
+    start_sem.signal();
+    return true;
+}
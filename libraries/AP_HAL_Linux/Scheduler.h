@@ -11,6 +11,9 @@
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
 
+// worker threads for run_parallel(), in addition to the main thread
+#define LINUX_SCHEDULER_MAX_PARALLEL_WORKERS 3
+
 #define AP_LINUX_SENSORS_STACK_SIZE  256 * 1024
 #define AP_LINUX_SENSORS_SCHED_POLICY  SCHED_FIFO
 #define AP_LINUX_SENSORS_SCHED_PRIO 12
@@ -53,7 +56,13 @@ public:
       create a new thread
      */
     bool thread_create(AP_HAL::MemberProc, const char *name, uint32_t stack_size, priority_base base, int8_t priority) override;
-    
+
+    /*
+      run proc(0..n-1) on the main thread and a pool of worker threads
+      pinned to the other CPUs. Must be called from the main thread
+     */
+    bool run_parallel(ParallelProc proc, uint8_t n) override;
+
     /*
       set cpu affinity mask to be applied on initialization - setting it
       later has no effect.
@@ -74,8 +83,36 @@ private:
         Scheduler &_sched;
     };
 
+    class ParallelWorker : public Thread {
+    public:
+        ParallelWorker()
+            : Thread(nullptr)
+        { }
+
+        void setup(Scheduler &sched, uint8_t index) {
+            _sched = &sched;
+            _index = index;
+        }
+
+        bool stop() override;
+
+        BinarySemaphore start_sem;
+        BinarySemaphore done_sem;
+
+    protected:
+        bool _run() override;
+
+        Scheduler *_sched = nullptr;
+        uint8_t _index = 0;
+    };
+
     void     init_realtime();
 
+    bool     init_parallel_workers();
+
+    // call _parallel_proc for the items assigned to one thread
+    void     run_parallel_items(uint8_t index);
+
     void     init_cpu_affinity();
 
     void _wait_all_threads();
@@ -117,6 +154,12 @@ private:
 
     Semaphore _io_semaphore;
     cpu_set_t _cpu_affinity;
+
+    ParallelWorker _parallel_workers[LINUX_SCHEDULER_MAX_PARALLEL_WORKERS];
+    uint8_t _num_parallel_workers;
+    bool _parallel_init_done;
+    ParallelProc _parallel_proc;
+    uint8_t _parallel_count;
 };
 
 }
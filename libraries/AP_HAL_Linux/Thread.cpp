@@ -227,6 +227,15 @@ bool Thread::join()
     return true;
 }
 
+bool Thread::set_affinity(const cpu_set_t &cpus)
+{
+    if (_ctx == 0) {
+        return false;
+    }
+
+    return pthread_setaffinity_np(_ctx, sizeof(cpus), &cpus) == 0;
+}
+
 
 bool PeriodicThread::set_rate(uint32_t rate_hz)
 {
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <pthread.h>
+#include <sched.h>
 #include <inttypes.h>
 #include <stdlib.h>
 
@@ -47,6 +48,8 @@ public:
 
     void set_auto_free(bool auto_free) { _auto_free = auto_free; }
 
+    bool set_affinity(const cpu_set_t &cpus);
+
     virtual bool stop() { return false; }
 
     bool join();
@@ -23,11 +23,11 @@
 #include "GPIO.h"
 #include "SITL_State.h"
 #include "Util.h"
-#include "DSP.h"
 #include "CANSocketIface.h"
 #include "SPIDevice.h"
 
 #include <AP_BoardConfig/AP_BoardConfig.h>
+#include <AP_HAL/utility/DSP_RealFFT.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
 #include <AP_HAL_Empty/AP_HAL_Empty_Private.h>
 #include <AP_InternalError/AP_InternalError.h>
@@ -50,7 +50,7 @@ static RCOutput sitlRCOutput(&sitlState);
 static GPIO sitlGPIO(&sitlState);
 static AnalogIn sitlAnalogIn(&sitlState);
 #if HAL_WITH_DSP
-static DSP dspDriver;
+static ap::DSP_RealFFT dspDriver;
 #endif
 
 
@@ -202,6 +202,15 @@ const AP_Param::GroupInfo AP_Logger::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("_MAX_FILES", 12, AP_Logger, _params.max_log_files, MAX_LOG_FILES),
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress file logs
+    // @Description: When enabled, logs written by the File backend are compressed in blocks using the LZ4 block format, reducing the amount of data written to storage. Logs downloaded over MAVLink are decompressed by the vehicle. Logs copied from the card, for example with MAVFTP, must be converted back to a normal log with Tools/scripts/decompress_log.py before being loaded into tools which don't support them. Takes effect when the next log is opened.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPRESS", 13, AP_Logger, _params.file_compress, 0),
+#endif
+
     AP_GROUPEND
 };
 
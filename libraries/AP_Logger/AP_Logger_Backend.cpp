@@ -687,6 +687,10 @@ bool AP_Logger_Backend::logging_enabled() const
 
 void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats)
 {
+    uint8_t write_queue_max;
+    uint32_t write_latency_avg_us;
+    uint32_t write_latency_max_us;
+    get_write_stats(write_queue_max, write_latency_avg_us, write_latency_max_us);
     const struct log_DSF pkt {
         LOG_PACKET_HEADER_INIT(LOG_DF_FILE_STATS),
         time_us         : AP_HAL::micros64(),
@@ -696,6 +700,9 @@ void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats
         buf_space_min   : _stats.buf_space_min,
         buf_space_max   : _stats.buf_space_max,
         buf_space_avg   : (_stats.blocks) ? (_stats.buf_space_sigma / _stats.blocks) : 0,
+        write_queue_max : write_queue_max,
+        write_latency_avg : write_latency_avg_us,
+        write_latency_max : write_latency_max_us,
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
@@ -250,6 +250,14 @@ protected:
     void df_stats_log();
     void df_stats_clear();
 
+    // get and reset write queue depth and write latency statistics
+    // for the DSF message
+    virtual void get_write_stats(uint8_t &queue_max, uint32_t &latency_avg_us, uint32_t &latency_max_us) {
+        queue_max = 0;
+        latency_avg_us = 0;
+        latency_max_us = 0;
+    }
+
     AP_Logger_RateLimiter *rate_limiter;
 
 private:
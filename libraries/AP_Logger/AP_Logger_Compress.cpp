@@ -0,0 +1,75 @@
+#include "AP_Logger_Compress.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <string.h>
+
+constexpr uint32_t AP_Logger_Compress::END_BLOCK_SIZE;
+
+uint32_t AP_Logger_Compress::encode_block(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+    log_compressed_block hdr {};
+    hdr.magic = LOG_COMPRESSED_BLOCK_MAGIC;
+    hdr.raw_len = len;
+    uint8_t *data = out + sizeof(hdr);
+
+    // fall back to storing the data if it doesn't get smaller
+    const uint32_t clen = lz4.compress(in, len, data, len);
+    if (clen > 0) {
+        hdr.type = uint8_t(LogBlockType::LZ4);
+        hdr.data_len = clen;
+    } else {
+        hdr.type = uint8_t(LogBlockType::STORED);
+        hdr.data_len = len;
+        memcpy(data, in, len);
+    }
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr) + hdr.data_len;
+}
+
+int32_t AP_Logger_Compress::decode_block(const log_compressed_block &hdr, const uint8_t *data,
+                                         uint8_t *out, uint32_t out_size)
+{
+    if (hdr.magic != LOG_COMPRESSED_BLOCK_MAGIC || hdr.raw_len > out_size) {
+        return -1;
+    }
+    switch (LogBlockType(hdr.type)) {
+    case LogBlockType::STORED:
+        if (hdr.data_len != hdr.raw_len) {
+            return -1;
+        }
+        memcpy(out, data, hdr.raw_len);
+        return hdr.raw_len;
+    case LogBlockType::LZ4: {
+        const int32_t n = lz4_decompress(data, hdr.data_len, out, hdr.raw_len);
+        return n == int32_t(hdr.raw_len) ? n : -1;
+    }
+    case LogBlockType::END:
+        return hdr.raw_len == 0 && hdr.data_len == sizeof(uint32_t) ? 0 : -1;
+    }
+    return -1;
+}
+
+void AP_Logger_Compress::encode_end_block(uint32_t raw_size, uint8_t out[END_BLOCK_SIZE])
+{
+    log_compressed_block hdr {};
+    hdr.magic = LOG_COMPRESSED_BLOCK_MAGIC;
+    hdr.data_len = sizeof(raw_size);
+    hdr.type = uint8_t(LogBlockType::END);
+    memcpy(out, &hdr, sizeof(hdr));
+    memcpy(&out[sizeof(hdr)], &raw_size, sizeof(raw_size));
+}
+
+bool AP_Logger_Compress::decode_end_block(const uint8_t block[END_BLOCK_SIZE], uint32_t &raw_size)
+{
+    log_compressed_block hdr;
+    memcpy(&hdr, block, sizeof(hdr));
+    if (LogBlockType(hdr.type) != LogBlockType::END ||
+        decode_block(hdr, nullptr, nullptr, 0) != 0) {
+        return false;
+    }
+    memcpy(&raw_size, &block[sizeof(hdr)], sizeof(raw_size));
+    return true;
+}
+
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
@@ -0,0 +1,85 @@
+/*
+   AP_Logger logging - block compression
+
+   Compressed log files are a sequence of blocks, each a
+   log_compressed_block header followed by the block data. The data is
+   either stored as-is or compressed in the LZ4 block format, so a
+   block can be decoded with any LZ4 implementation. Each block is
+   compressed independently so a log can be decoded up to the point
+   where it was truncated. A log which was closed cleanly ends with an
+   END block giving its decoded size
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/LZ4.h>
+
+#define LOG_COMPRESSED_BLOCK_MAGIC 0x5A4C5041 // "APLZ"
+
+enum class LogBlockType : uint8_t {
+    STORED = 0,
+    LZ4 = 1,
+    END = 2,    // no decoded data, 4 byte decoded size of the log
+};
+
+struct PACKED log_compressed_block {
+    uint32_t magic;
+    uint32_t raw_len;   // length of the block once decoded
+    uint32_t data_len;  // length of the data following this header
+    uint8_t type;       // LogBlockType
+    uint8_t reserved[3];
+};
+
+class AP_Logger_Compress
+{
+public:
+    AP_Logger_Compress() {}
+
+    CLASS_NO_COPY(AP_Logger_Compress);
+
+    // allocate the compressor state
+    bool init() { return lz4.init(); }
+
+    // space needed for a block holding len bytes of log data
+    static uint32_t max_block_size(uint32_t len) {
+        return len + sizeof(log_compressed_block);
+    }
+
+    /*
+      encode len bytes from in as a block, header included, into out,
+      which must be at least max_block_size(len) bytes. len must be
+      less than 64k. Returns the size of the block
+     */
+    uint32_t encode_block(const uint8_t *in, uint32_t len, uint8_t *out);
+
+    /*
+      decode the data of a block described by hdr into out. Returns
+      the number of bytes decoded, or -1 if the block is corrupt or
+      won't fit in out_size bytes
+     */
+    static int32_t decode_block(const log_compressed_block &hdr, const uint8_t *data,
+                                uint8_t *out, uint32_t out_size);
+
+    // size of the END block closing a log
+    static constexpr uint32_t END_BLOCK_SIZE = sizeof(log_compressed_block) + sizeof(uint32_t);
+
+    // encode an END block recording raw_size decoded bytes into out
+    static void encode_end_block(uint32_t raw_size, uint8_t out[END_BLOCK_SIZE]);
+
+    /*
+      get the decoded size of a log from the last END_BLOCK_SIZE bytes
+      of the file. Returns false if the log didn't end with an END
+      block, in which case the blocks have to be walked to find it
+     */
+    static bool decode_end_block(const uint8_t block[END_BLOCK_SIZE], uint32_t &raw_size);
+
+private:
+    LZ4_Compressor lz4;
+};
+
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
@@ -26,6 +26,7 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_InternalError/AP_InternalError.h>
 #include <AP_RTC/AP_RTC.h>
+#include <AP_Scheduler/Profiler.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 #include <AP_AHRS/AP_AHRS.h>
 
@@ -94,6 +95,18 @@ void AP_Logger_File::Init()
 
     DEV_PRINTF("AP_Logger_File: buffer size=%u\n", (unsigned)bufsize);
 
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+    uint32_t async_chunk = _writebuf_chunk;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // leave room for a block header in case compression is enabled
+    async_chunk = AP_Logger_Compress::max_block_size(_writebuf_chunk);
+#endif
+    _async_io_ok = _async_io.init(async_chunk);
+    if (!_async_io_ok) {
+        DEV_PRINTF("AP_Logger_File: async writes disabled\n");
+    }
+#endif
+
     _initialised = true;
 
     const char* custom_dir = hal.util->get_custom_log_directory();
@@ -182,6 +195,7 @@ void AP_Logger_File::periodic_1Hz()
 
 void AP_Logger_File::periodic_fullrate()
 {
+    AP_PROFILE_SCOPE("LogPush");
     AP_Logger_Backend::push_log_blocks();
 }
 
@@ -442,6 +456,8 @@ bool AP_Logger_File::StartNewLogOK() const
 /* Write a block of data at current offset */
 bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical)
 {
+    // includes waiting for the IO thread to release the buffer
+    AP_PROFILE_SCOPE("LogWrite");
     WITH_SEMAPHORE(semaphore);
 
 #if APM_BUILD_TYPE(APM_BUILD_Replay)
@@ -452,6 +468,12 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
 #endif
 
 
+    if (_writebuf_discard_pending) {
+        // the IO thread has yet to drop the previous log's data
+        _dropped++;
+        return false;
+    }
+
     uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
@@ -482,7 +504,7 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         return false;
     }
 
-    _writebuf.write((uint8_t*)pBuffer, size);
+    _writebuf.push((const uint8_t*)pBuffer, size);
     df_stats_gather(size, _writebuf.space());
     return true;
 }
@@ -522,8 +544,14 @@ uint32_t AP_Logger_File::_get_log_size(const uint16_t log_num)
         if (_write_filename != nullptr && strcmp(_write_filename, fname) == 0) {
             // it is the file we are currently writing
             free(fname);
+            uint32_t size = _write_offset;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+            if (_compressing) {
+                size = _write_raw_offset;
+            }
+#endif
             write_fd_semaphore.give();
-            return _write_offset;
+            return size;
         }
         write_fd_semaphore.give();
     }
@@ -533,8 +561,19 @@ uint32_t AP_Logger_File::_get_log_size(const uint16_t log_num)
         free(fname);
         return 0;
     }
+    uint32_t size = st.st_size;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // a compressed log is downloaded decoded, so report that size
+    const int fd = AP::FS().open(fname, O_RDONLY);
+    if (fd != -1) {
+        if (log_is_compressed(fd)) {
+            size = compressed_log_size(fd, size);
+        }
+        AP::FS().close(fd);
+    }
+#endif
     free(fname);
-    return st.st_size;
+    return size;
 }
 
 uint32_t AP_Logger_File::_get_log_time(const uint16_t log_num)
@@ -627,9 +666,31 @@ int16_t AP_Logger_File::get_log_data(const uint16_t list_entry, const uint16_t p
         free(fname);
         _read_offset = 0;
         _read_fd_log_num = log_num;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        _read_compressed = log_is_compressed(_read_fd);
+        if (_read_compressed) {
+            if (_read_buf == nullptr) {
+                _read_buf = (uint8_t *)malloc(2 * _writebuf_chunk);
+            }
+            if (_read_buf == nullptr) {
+                AP::FS().close(_read_fd);
+                _read_fd = -1;
+                return -1;
+            }
+            _read_block_ofs = 0;
+            _read_raw_start = 0;
+            _read_raw_len = 0;
+        }
+#endif
     }
     uint32_t ofs = page * (uint32_t)LOGGER_PAGE_SIZE + offset;
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_read_compressed) {
+        return read_compressed(ofs, len, data);
+    }
+#endif
+
     if (ofs != _read_offset) {
         if (AP::FS().lseek(_read_fd, ofs, SEEK_SET) == (off_t)-1) {
             AP::FS().close(_read_fd);
@@ -651,6 +712,10 @@ void AP_Logger_File::end_log_transfer()
         AP::FS().close(_read_fd);
         _read_fd = -1;
     }
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    free(_read_buf);
+    _read_buf = nullptr;
+#endif
 }
 
 /*
@@ -716,6 +781,15 @@ void AP_Logger_File::stop_logging(void)
     if (_write_fd != -1) {
         int fd = _write_fd;
         _write_fd = -1;
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+        // don't close the file under writes still in flight
+        async_io_wait_all();
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (have_sem) {
+            compress_write_end_block(fd);
+        }
+#endif
         AP::FS().close(fd);
     }
     if (have_sem) {
@@ -783,6 +857,13 @@ void AP_Logger_File::start_new_log(void)
 
     stop_logging();
 
+    {
+        // anything still queued belongs to the previous log. Only
+        // the IO thread may pop from _writebuf, so it does the discard
+        WITH_SEMAPHORE(semaphore);
+        _writebuf_discard_pending = true;
+    }
+
     start_new_log_reset_variables();
 
     if (_read_fd != -1) {
@@ -824,6 +905,11 @@ void AP_Logger_File::start_new_log(void)
 #endif
 #endif
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // each log is either entirely compressed or not
+    const bool compressing = compress_init();
+#endif
+
     // create the log directory if need be
     ensure_log_directory_exists();
 
@@ -845,7 +931,12 @@ void AP_Logger_File::start_new_log(void)
     _last_write_ms = AP_HAL::millis();
     _open_error_ms = 0;
     _write_offset = 0;
-    _writebuf.clear();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    _compressing = compressing;
+    _compress_len = 0;
+    _compress_ofs = 0;
+    _write_raw_offset = 0;
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -893,6 +984,9 @@ void AP_Logger_File::flush(void)
     }
     if (write_fd_semaphore.take(1)) {
         if (_write_fd != -1) {
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+            async_io_wait_all();
+#endif
             ::fsync(_write_fd);
         }
         write_fd_semaphore.give();
@@ -917,6 +1011,11 @@ void AP_Logger_File::io_timer(void)
         start_new_log_pending = false;
     }
 
+    if (_writebuf_discard_pending) {
+        _writebuf.advance(_writebuf.available());
+        _writebuf_discard_pending = false;
+    }
+
     if (erase.log_num != 0) {
         // continue erase
         erase_next();
@@ -934,11 +1033,26 @@ void AP_Logger_File::io_timer(void)
         write_lastlog_file(log_num);
     }
 
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+    if (_async_io_ok) {
+        async_io_reap(tnow);
+        if (_write_fd == -1) {
+            return;
+        }
+    }
+#endif
+
     uint32_t nbytes = _writebuf.available();
-    if (nbytes == 0) {
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // a partly written compressed block must be finished first
+    const bool block_pending = _compress_ofs < _compress_len;
+#else
+    const bool block_pending = false;
+#endif
+    if (nbytes == 0 && !block_pending) {
         return;
     }
-    if (nbytes < _writebuf_chunk && 
+    if (nbytes < _writebuf_chunk && !block_pending &&
         tnow - _last_write_time < 2000UL) {
         // write in _writebuf_chunk-sized chunks, but always write at
         // least once per 2 seconds if data is available
@@ -960,24 +1074,48 @@ void AP_Logger_File::io_timer(void)
     }
 #endif
     _last_write_time = tnow;
+
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+    if (_async_io_ok) {
+        async_io_submit();
+        return;
+    }
+#endif
+
     if (nbytes > _writebuf_chunk) {
         // be kind to the filesystem layer
         nbytes = _writebuf_chunk;
     }
 
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    const uint8_t *head;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_compressing) {
+        if (!block_pending) {
+            uint32_t consumed = nbytes;
+            _compress_len = compress_next_block(consumed, _compress_buf);
+            _compress_ofs = 0;
+            _compress_raw_len = consumed;
+            _writebuf.advance(consumed);
+        }
+        head = &_compress_buf[_compress_ofs];
+        nbytes = _compress_len - _compress_ofs;
+    } else
+#endif
+    {
+        uint32_t size;
+        head = _writebuf.readptr(size);
+        nbytes = MIN(nbytes, size);
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
-    // try to align writes on a 512 byte boundary to avoid filesystem reads
-    if ((nbytes + _write_offset) % 512 != 0) {
-        uint32_t ofs = (nbytes + _write_offset) % 512;
-        if (ofs < nbytes) {
-            nbytes -= ofs;
+        // try to align writes on a 512 byte boundary to avoid filesystem reads
+        if ((nbytes + _write_offset) % 512 != 0) {
+            uint32_t ofs = (nbytes + _write_offset) % 512;
+            if (ofs < nbytes) {
+                nbytes -= ofs;
+            }
         }
-    }
 #endif
+    }
     last_io_operation = "write";
     if (!write_fd_semaphore.take(1)) {
         return;
@@ -992,7 +1130,12 @@ void AP_Logger_File::io_timer(void)
         nbytes = bytes_until_fsync; // write exactly enough to sync
     }
 
+    const uint32_t write_start_us = AP_HAL::micros();
     ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
+    const uint32_t write_latency_us = AP_HAL::micros() - write_start_us;
+    _write_count++;
+    _write_latency_sum_us += write_latency_us;
+    _write_latency_max_us = MAX(_write_latency_max_us, write_latency_us);
     last_io_operation = "";
     if (nwritten <= 0) {
         if (errno == ENOSPC) {
@@ -1015,7 +1158,17 @@ void AP_Logger_File::io_timer(void)
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (_compressing) {
+            _compress_ofs += nwritten;
+            if (_compress_ofs == _compress_len) {
+                _write_raw_offset += _compress_raw_len;
+            }
+        } else
+#endif
+        {
+            _writebuf.advance(nwritten);
+        }
 
         // we know nwritten > 0 so we won't sync if bytes_until_fsync == 0
         if ((uint32_t)nwritten == bytes_until_fsync) {
@@ -1040,6 +1193,294 @@ void AP_Logger_File::io_timer(void)
     write_fd_semaphore.give();
 }
 
+void AP_Logger_File::get_write_stats(uint8_t &queue_max, uint32_t &latency_avg_us, uint32_t &latency_max_us)
+{
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+    if (_async_io_ok) {
+        _async_io.get_stats(queue_max, latency_avg_us, latency_max_us);
+        return;
+    }
+#endif
+    // the IO thread updates these under the write semaphore
+    WITH_SEMAPHORE(write_fd_semaphore);
+    queue_max = _write_count > 0 ? 1 : 0;
+    latency_avg_us = _write_count > 0 ? _write_latency_sum_us / _write_count : 0;
+    latency_max_us = _write_latency_max_us;
+    _write_count = 0;
+    _write_latency_sum_us = 0;
+    _write_latency_max_us = 0;
+}
+
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+/*
+  collect completed asynchronous writes, handling errors the same way
+  as for blocking writes. Failed writes are retried until the file
+  times out
+ */
+void AP_Logger_File::async_io_reap(uint32_t tnow)
+{
+    uint32_t bytes_written = 0;
+    int err = 0;
+    const bool ok = _async_io.reap(bytes_written, err);
+    if (bytes_written > 0) {
+        _last_write_ms = tnow;
+    }
+    if (ok) {
+        if (bytes_written > 0) {
+            _last_write_failed = false;
+        }
+        return;
+    }
+    _last_write_failed = true;
+    if (err == ENOSPC) {
+        DEV_PRINTF("Out of space for logging\n");
+        stop_logging();
+        _open_error_ms = AP_HAL::millis(); // prevent logging starting again for 5s
+    } else if ((tnow - _last_write_ms)/1000U > unsigned(_front._params.file_timeout)) {
+        // as for blocking writes, give up and close the file
+        if (!write_fd_semaphore.take(1)) {
+            return;
+        }
+        if (_write_fd != -1) {
+            async_io_wait_all();
+            AP::FS().close(_write_fd);
+            _write_fd = -1;
+            printf("Failed to write to File: %s\n", strerror(err));
+        }
+        write_fd_semaphore.give();
+    }
+}
+
+/*
+  complete the asynchronous writes before the file is closed or
+  synced, accounting for their errors as for blocking writes
+ */
+void AP_Logger_File::async_io_wait_all()
+{
+    uint32_t bytes_written = 0;
+    int err = 0;
+    const bool ok = _async_io.wait_all(bytes_written, err);
+    if (bytes_written > 0) {
+        _last_write_ms = AP_HAL::millis();
+    }
+    if (ok) {
+        return;
+    }
+    _last_write_failed = true;
+    if (err == ENOSPC) {
+        DEV_PRINTF("Out of space for logging\n");
+    } else {
+        printf("Failed to write to File: %s\n", strerror(err));
+    }
+}
+
+/*
+  move as many chunks as we have free requests for from the write
+  buffer to the file. Data leaves the write buffer once the write is
+  queued, so the buffer drains at the rate of the queue rather than
+  the rate of the storage
+ */
+void AP_Logger_File::async_io_submit()
+{
+    if (!write_fd_semaphore.take(1)) {
+        return;
+    }
+    if (_write_fd == -1) {
+        write_fd_semaphore.give();
+        return;
+    }
+
+    uint8_t *buf;
+    while ((buf = _async_io.get_buffer()) != nullptr) {
+        uint32_t nbytes = MIN(_writebuf.available(), uint32_t(_writebuf_chunk));
+        if (nbytes == 0) {
+            break;
+        }
+        const bool partial = nbytes < _writebuf_chunk;
+        uint32_t len;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (_compressing) {
+            len = compress_next_block(nbytes, buf);
+        } else
+#endif
+        {
+#if !AP_FILESYSTEM_LITTLEFS_ENABLED
+            // keep the end of a partial chunk on a 512 byte boundary so
+            // following chunks are aligned
+            if ((nbytes + _write_offset) % 512 != 0) {
+                uint32_t ofs = (nbytes + _write_offset) % 512;
+                if (ofs < nbytes) {
+                    nbytes -= ofs;
+                }
+            }
+#endif
+            nbytes = _writebuf.peek(buf, nbytes);
+            len = nbytes;
+        }
+        last_io_operation = "write";
+        if (!_async_io.submit(_write_fd, buf, len, _write_offset)) {
+            // out of kernel resources, try again next time
+            last_io_operation = "";
+            break;
+        }
+        last_io_operation = "";
+        _writebuf.advance(nbytes);
+        _write_offset += len;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (_compressing) {
+            _write_raw_offset += nbytes;
+        }
+#endif
+        if (partial) {
+            break;
+        }
+    }
+
+    write_fd_semaphore.give();
+}
+#endif  // AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  allocate the compression state if LOG_FILE_COMPRESS is set,
+  returning true if the next log should be compressed
+ */
+bool AP_Logger_File::compress_init()
+{
+    if (_front._params.file_compress == 0) {
+        return false;
+    }
+    if (_compress_buf == nullptr) {
+        _compress_buf = (uint8_t *)malloc(AP_Logger_Compress::max_block_size(_writebuf_chunk));
+    }
+    return _compress_buf != nullptr && _compress.init();
+}
+
+/*
+  compress up to nbytes from the start of the write buffer into a
+  block in out, which must have room for max_block_size(nbytes). A
+  block ends early where the buffer wraps. nbytes is set to the
+  number of bytes consumed, which the caller must advance the buffer
+  by once the block is safely queued. Returns the length of the block
+ */
+uint32_t AP_Logger_File::compress_next_block(uint32_t &nbytes, uint8_t *out)
+{
+    uint32_t size;
+    const uint8_t *head = _writebuf.readptr(size);
+    nbytes = MIN(nbytes, size);
+    if (nbytes == 0) {
+        return 0;
+    }
+    return _compress.encode_block(head, nbytes, out);
+}
+
+/*
+  close a compressed log with an END block so its decoded size can be
+  found without walking all of its blocks. A log with a partly written
+  block or a failed write is truncated, and is left as it is
+ */
+void AP_Logger_File::compress_write_end_block(int fd)
+{
+    if (!_compressing || _compress_ofs < _compress_len || _last_write_failed) {
+        return;
+    }
+    uint8_t block[AP_Logger_Compress::END_BLOCK_SIZE];
+    AP_Logger_Compress::encode_end_block(_write_raw_offset, block);
+    if (AP::FS().lseek(fd, _write_offset, SEEK_SET) != (off_t)-1 &&
+        AP::FS().write(fd, block, sizeof(block)) == int32_t(sizeof(block))) {
+        _write_offset += sizeof(block);
+    }
+}
+
+// return true if the log open on fd is compressed, leaving it at the start of the file
+bool AP_Logger_File::log_is_compressed(int fd)
+{
+    uint32_t magic;
+    const bool ret = AP::FS().read(fd, &magic, sizeof(magic)) == int32_t(sizeof(magic)) &&
+                     magic == LOG_COMPRESSED_BLOCK_MAGIC;
+    AP::FS().lseek(fd, 0, SEEK_SET);
+    return ret;
+}
+
+/*
+  return the decoded size of a compressed log of file_size bytes. A
+  log which wasn't closed cleanly has no END block, so its block
+  headers are added up, stopping at a truncated block as replay does
+ */
+uint32_t AP_Logger_File::compressed_log_size(int fd, uint32_t file_size)
+{
+    uint8_t end[AP_Logger_Compress::END_BLOCK_SIZE];
+    uint32_t raw_size = 0;
+    if (file_size >= sizeof(end) &&
+        AP::FS().lseek(fd, file_size - sizeof(end), SEEK_SET) != (off_t)-1 &&
+        AP::FS().read(fd, end, sizeof(end)) == int32_t(sizeof(end)) &&
+        AP_Logger_Compress::decode_end_block(end, raw_size)) {
+        return raw_size;
+    }
+
+    log_compressed_block hdr;
+    uint32_t ofs = 0;
+    raw_size = 0;
+    EXPECT_DELAY_MS(3000);
+    while (file_size - ofs >= sizeof(hdr)) {
+        if (AP::FS().lseek(fd, ofs, SEEK_SET) == (off_t)-1 ||
+            AP::FS().read(fd, &hdr, sizeof(hdr)) != int32_t(sizeof(hdr)) ||
+            hdr.magic != LOG_COMPRESSED_BLOCK_MAGIC ||
+            hdr.data_len > file_size - ofs - sizeof(hdr)) {
+            break;
+        }
+        raw_size += hdr.raw_len;
+        ofs += sizeof(hdr) + hdr.data_len;
+    }
+    return raw_size;
+}
+
+/*
+  read up to len bytes at ofs in the decoded log open for download,
+  decoding blocks as the transfer reaches them. Transfers move
+  forwards, so going backwards restarts decoding from the first block
+ */
+int16_t AP_Logger_File::read_compressed(uint32_t ofs, uint16_t len, uint8_t *data)
+{
+    uint8_t *block_data = _read_buf;
+    uint8_t *raw = &_read_buf[_writebuf_chunk];
+
+    if (ofs < _read_raw_start) {
+        _read_block_ofs = 0;
+        _read_raw_start = 0;
+        _read_raw_len = 0;
+    }
+
+    uint16_t ret = 0;
+    while (ret < len) {
+        if (ofs < _read_raw_start + _read_raw_len) {
+            const uint32_t n = MIN(uint32_t(len - ret), _read_raw_start + _read_raw_len - ofs);
+            memcpy(&data[ret], &raw[ofs - _read_raw_start], n);
+            ret += n;
+            ofs += n;
+            continue;
+        }
+        // decode the next block. The log ends at a truncated or
+        // corrupt block
+        log_compressed_block hdr;
+        if (AP::FS().lseek(_read_fd, _read_block_ofs, SEEK_SET) == (off_t)-1 ||
+            AP::FS().read(_read_fd, &hdr, sizeof(hdr)) != int32_t(sizeof(hdr)) ||
+            hdr.data_len > _writebuf_chunk ||
+            AP::FS().read(_read_fd, block_data, hdr.data_len) != int32_t(hdr.data_len)) {
+            break;
+        }
+        const int32_t n = AP_Logger_Compress::decode_block(hdr, block_data, raw, _writebuf_chunk);
+        if (n < 0) {
+            break;
+        }
+        _read_block_ofs += sizeof(hdr) + hdr.data_len;
+        _read_raw_start += _read_raw_len;
+        _read_raw_len = n;
+    }
+    return ret;
+}
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
 bool AP_Logger_File::io_thread_alive() const
 {
     if (!hal.scheduler->is_system_initialized()) {
@@ -10,6 +10,8 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "AP_Logger_Backend.h"
+#include "AP_Logger_File_AsyncIO.h"
+#include "AP_Logger_Compress.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
@@ -66,6 +68,8 @@ public:
     bool logging_started(void) const override { return _write_fd != -1; }
     void io_timer(void) override;
 
+    void get_write_stats(uint8_t &queue_max, uint32_t &latency_avg_us, uint32_t &latency_max_us) override;
+
 protected:
 
     bool WritesOK() const override;
@@ -109,11 +113,55 @@ private:
     bool dirent_to_log_num(const dirent *de, uint16_t &log_num) const;
     bool write_lastlog_file(uint16_t log_num);
 
-    // write buffer
-    ByteBuffer _writebuf{0};
+    // write buffer, filled by writers holding the semaphore and
+    // drained by the IO thread
+    ObjectBuffer_SPSC<uint8_t> _writebuf{0};
+    // set by start_new_log() so the IO thread, as the only consumer,
+    // discards the previous log's data; writers wait until it has
+    volatile bool _writebuf_discard_pending;
     const uint16_t _writebuf_chunk = HAL_LOGGER_WRITE_CHUNK_SIZE;
     uint32_t _last_write_time;
 
+    // write latency statistics for blocking writes, protected by
+    // write_fd_semaphore
+    uint32_t _write_count;
+    uint32_t _write_latency_sum_us;
+    uint32_t _write_latency_max_us;
+
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+    AP_Logger_File_AsyncIO _async_io;
+    bool _async_io_ok;
+    void async_io_reap(uint32_t tnow);
+    void async_io_wait_all();
+    void async_io_submit();
+#endif
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // block compression of the current log, see LOG_FILE_COMPRESS
+    AP_Logger_Compress _compress;
+    bool _compressing;
+    // compressed block being written by blocking writes
+    uint8_t *_compress_buf;
+    uint32_t _compress_len;
+    uint32_t _compress_ofs;
+    uint32_t _compress_raw_len;
+    // decoded bytes in the blocks written to the current log
+    uint32_t _write_raw_offset;
+    bool compress_init();
+    uint32_t compress_next_block(uint32_t &nbytes, uint8_t *out);
+    void compress_write_end_block(int fd);
+
+    // compressed logs are decoded a block at a time for download
+    bool _read_compressed;
+    uint8_t *_read_buf;         // block data followed by the decoded block
+    uint32_t _read_block_ofs;   // file offset of the next block
+    uint32_t _read_raw_start;   // log offset of the decoded block
+    uint32_t _read_raw_len;     // length of the decoded block
+    bool log_is_compressed(int fd);
+    uint32_t compressed_log_size(int fd, uint32_t file_size);
+    int16_t read_compressed(uint32_t ofs, uint16_t len, uint8_t *data);
+#endif
+
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
     char *_lastlog_file_name() const;
@@ -0,0 +1,193 @@
+#include "AP_Logger_File_AsyncIO.h"
+
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+AP_Logger_File_AsyncIO::~AP_Logger_File_AsyncIO()
+{
+    uint32_t bytes_written = 0;
+    int err = 0;
+    wait_all(bytes_written, err);
+    for (auto &r : _requests) {
+        free(r.buf);
+    }
+}
+
+bool AP_Logger_File_AsyncIO::init(uint32_t chunk_size)
+{
+    for (auto &r : _requests) {
+        // align to a filesystem block so the writes can go straight
+        // to the page cache
+        if (posix_memalign((void **)&r.buf, 512, chunk_size) != 0) {
+            r.buf = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t *AP_Logger_File_AsyncIO::get_buffer()
+{
+    WITH_SEMAPHORE(_sem);
+    for (auto &r : _requests) {
+        if (!r.busy && r.buf != nullptr) {
+            return r.buf;
+        }
+    }
+    return nullptr;
+}
+
+// start or restart the write for a request
+bool AP_Logger_File_AsyncIO::start(Request &r)
+{
+    r.retry = false;
+    return aio_write(&r.cb) == 0;
+}
+
+bool AP_Logger_File_AsyncIO::submit(int fd, uint8_t *buf, uint32_t len, uint64_t offset)
+{
+    WITH_SEMAPHORE(_sem);
+    for (auto &r : _requests) {
+        if (r.buf != buf || r.busy) {
+            continue;
+        }
+        memset(&r.cb, 0, sizeof(r.cb));
+        r.cb.aio_fildes = fd;
+        r.cb.aio_buf = r.buf;
+        r.cb.aio_nbytes = len;
+        r.cb.aio_offset = offset;
+        r.cb.aio_sigevent.sigev_notify = SIGEV_NONE;
+        r.start_us = AP_HAL::micros64();
+        if (!start(r)) {
+            return false;
+        }
+        r.busy = true;
+        _in_flight++;
+        _queue_max = MAX(_queue_max, _in_flight);
+        return true;
+    }
+    return false;
+}
+
+// record the latency of a completed request and free it
+void AP_Logger_File_AsyncIO::complete(Request &r)
+{
+    const uint32_t latency_us = AP_HAL::micros64() - r.start_us;
+    _latency_count++;
+    _latency_sum_us += latency_us;
+    _latency_max_us = MAX(_latency_max_us, latency_us);
+    r.busy = false;
+    _in_flight--;
+}
+
+// move a request on past n bytes which have been written
+void AP_Logger_File_AsyncIO::advance(Request &r, size_t n)
+{
+    r.cb.aio_buf = (uint8_t *)r.cb.aio_buf + n;
+    r.cb.aio_nbytes -= n;
+    r.cb.aio_offset += n;
+}
+
+bool AP_Logger_File_AsyncIO::reap(uint32_t &bytes_written, int &err)
+{
+    WITH_SEMAPHORE(_sem);
+    bool ret = true;
+    for (auto &r : _requests) {
+        if (!r.busy) {
+            continue;
+        }
+        if (r.retry) {
+            // a previous attempt failed, try again
+            if (!start(r)) {
+                r.retry = true;
+                err = errno;
+                ret = false;
+            }
+            continue;
+        }
+        const int e = aio_error(&r.cb);
+        if (e == EINPROGRESS) {
+            continue;
+        }
+        const ssize_t n = aio_return(&r.cb);
+        if (e != 0 || n < 0) {
+            r.retry = true;
+            err = e;
+            ret = false;
+            continue;
+        }
+        bytes_written += n;
+        if (size_t(n) < r.cb.aio_nbytes) {
+            // short write, send the rest
+            advance(r, n);
+            r.retry = true;
+            continue;
+        }
+        complete(r);
+    }
+    return ret;
+}
+
+bool AP_Logger_File_AsyncIO::wait_all(uint32_t &bytes_written, int &err)
+{
+    WITH_SEMAPHORE(_sem);
+    bool ret = true;
+    for (auto &r : _requests) {
+        if (!r.busy) {
+            continue;
+        }
+        if (!r.retry) {
+            // the write is with the kernel, we must not let the
+            // caller close the file under it
+            const struct aiocb *list[1] { &r.cb };
+            while (aio_error(&r.cb) == EINPROGRESS) {
+                aio_suspend(list, 1, nullptr);
+            }
+            const int e = aio_error(&r.cb);
+            const ssize_t n = aio_return(&r.cb);
+            if (e == 0 && n >= 0) {
+                bytes_written += n;
+                advance(r, n);
+            }
+        }
+        // write whatever failed, was short or was waiting to be
+        // retried synchronously, as the caller is about to close the
+        // file
+        while (r.cb.aio_nbytes > 0) {
+            const ssize_t n = pwrite(r.cb.aio_fildes, (const void *)r.cb.aio_buf, r.cb.aio_nbytes, r.cb.aio_offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                err = n < 0 ? errno : EIO;
+                ret = false;
+                break;
+            }
+            bytes_written += n;
+            advance(r, n);
+        }
+        r.retry = false;
+        complete(r);
+    }
+    return ret;
+}
+
+void AP_Logger_File_AsyncIO::get_stats(uint8_t &queue_max, uint32_t &latency_avg_us, uint32_t &latency_max_us)
+{
+    WITH_SEMAPHORE(_sem);
+    queue_max = _queue_max;
+    latency_avg_us = _latency_count ? _latency_sum_us / _latency_count : 0;
+    latency_max_us = _latency_max_us;
+    _queue_max = _in_flight;
+    _latency_count = 0;
+    _latency_sum_us = 0;
+    _latency_max_us = 0;
+}
+
+#endif  // AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
@@ -0,0 +1,86 @@
+/*
+   AP_Logger logging - asynchronous file writes
+
+   This keeps several chunk writes to the log file in flight using
+   POSIX AIO, so a slow write or fsync on an SD card doesn't stop the
+   IO thread from draining the logger write buffer
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
+
+#include <aio.h>
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/Semaphores.h>
+
+#ifndef HAL_LOGGER_ASYNC_WRITE_DEPTH
+#define HAL_LOGGER_ASYNC_WRITE_DEPTH 4
+#endif
+
+class AP_Logger_File_AsyncIO
+{
+public:
+    AP_Logger_File_AsyncIO() {}
+    ~AP_Logger_File_AsyncIO();
+
+    CLASS_NO_COPY(AP_Logger_File_AsyncIO);
+
+    // allocate the chunk buffers
+    bool init(uint32_t chunk_size);
+
+    // return a buffer of chunk_size bytes which can be filled and
+    // passed to submit(), or nullptr if all writes are in flight
+    uint8_t *get_buffer();
+
+    // start writing len bytes of a buffer from get_buffer() to fd at
+    // offset. Returns false if the write couldn't be queued
+    bool submit(int fd, uint8_t *buf, uint32_t len, uint64_t offset);
+
+    /*
+      collect completed writes, adding the number of bytes written to
+      bytes_written. Failed writes are retried on the next call.
+      Returns false if a write failed, with the error in err
+     */
+    bool reap(uint32_t &bytes_written, int &err);
+
+    /*
+      wait for the writes in flight to complete, finishing any that
+      failed, were short or are waiting to be retried with blocking
+      writes. Used before closing the file. Adds the number of bytes
+      written to bytes_written and returns false if a write failed,
+      with the error in err
+     */
+    bool wait_all(uint32_t &bytes_written, int &err);
+
+    // number of writes in flight
+    uint8_t in_flight() const { return _in_flight; }
+
+    // get and reset queue depth and write latency statistics
+    void get_stats(uint8_t &queue_max, uint32_t &latency_avg_us, uint32_t &latency_max_us);
+
+private:
+    struct Request {
+        struct aiocb cb;
+        uint8_t *buf;
+        uint64_t start_us;
+        bool busy;
+        bool retry;
+    } _requests[HAL_LOGGER_ASYNC_WRITE_DEPTH] {};
+
+    bool start(Request &r);
+    void advance(Request &r, size_t n);
+    void complete(Request &r);
+
+    uint8_t _in_flight = 0;
+    HAL_Semaphore _sem;
+
+    // statistics since the last get_stats()
+    uint8_t _queue_max = 0;
+    uint32_t _latency_count = 0;
+    uint64_t _latency_sum_us = 0;
+    uint32_t _latency_max_us = 0;
+};
+
+#endif  // AP_LOGGER_FILE_ASYNC_WRITE_ENABLED
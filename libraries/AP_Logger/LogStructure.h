@@ -228,6 +228,9 @@ struct PACKED log_DSF {
     uint32_t buf_space_min;
     uint32_t buf_space_max;
     uint32_t buf_space_avg;
+    uint8_t write_queue_max;
+    uint32_t write_latency_avg;
+    uint32_t write_latency_max;
 };
 
 struct PACKED log_Event {
@@ -319,6 +322,32 @@ struct PACKED log_MAV {
     uint32_t GCS_SYSID_last_seen_ms;
 };
 
+struct PACKED log_MAVR {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint8_t sysid;
+    uint8_t compid;
+    uint8_t mavtype;
+    uint32_t last_seen_ms;
+    uint32_t rx_count;
+    uint32_t fwd_count;
+};
+
+struct PACKED log_MAVS {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint32_t budget;
+    uint32_t demand;
+    uint32_t tx_rate;
+    uint16_t scale;
+    uint8_t buckets;
+    uint16_t bucket_sends;
+    uint16_t max_late_ms;
+    uint16_t max_update_us;
+};
+
 struct PACKED log_RSSI {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -478,6 +507,9 @@ struct PACKED log_TERRAIN {
     uint16_t pending;
     uint16_t loaded;
     float reference_offset;
+    uint32_t hits;
+    uint32_t misses;
+    uint16_t prefetched;
 };
 
 struct PACKED log_ARSP {
@@ -714,6 +746,9 @@ struct PACKED log_VER {
 // @Field: FMn: Minimum free space in write buffer in last time period
 // @Field: FMx: Maximum free space in write buffer in last time period
 // @Field: FAv: Average free space in write buffer in last time period
+// @Field: WQ: Maximum number of storage writes in flight in last time period
+// @Field: WLa: Average storage write latency in last time period
+// @Field: WLx: Maximum storage write latency in last time period
 
 // @LoggerMessage: ERR
 // @Description: Specifically coded error messages
@@ -781,6 +816,30 @@ struct PACKED log_VER {
 // @Field: tf: times buffer was full when a message was going to be sent
 // @Field: mgs: time MAV_GCS_SYSID heartbeat (or manual control) last seen
 
+// @LoggerMessage: MAVR
+// @Description: GCS MAVLink route learned on a channel
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number the route was learned on
+// @Field: sys: system id reached through this channel
+// @Field: comp: component id reached through this channel
+// @Field: type: MAV_TYPE from the component's heartbeat
+// @Field: Age: time since a packet was last received from the component on this channel
+// @Field: Rx: packets received from the component on this channel
+// @Field: Fwd: packets forwarded on this channel to reach the component
+
+// @LoggerMessage: MAVS
+// @Description: GCS MAVLink stream scheduler statistics
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number
+// @Field: BW: bandwidth of the link available to streamed messages
+// @Field: Dem: bandwidth streamed messages need at their requested intervals
+// @Field: Tx: bytes per second written to the link since the last message
+// @Field: Scl: stream intervals as a percentage of their requested intervals, to fit within BW
+// @Field: Bkt: number of message interval buckets in use
+// @Field: Snt: streamed messages sent since the last message
+// @Field: Late: longest time a bucket of streamed messages was sent after it was due since the last message
+// @Field: UMx: longest time spent in update_send since the last message
+
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
 // @Field: TimeUS: Time since system startup
@@ -1049,6 +1108,9 @@ struct PACKED log_VER {
 // @Field: Pending: Number of tile requests outstanding
 // @Field: Loaded: Number of tiles in memory
 // @Field: ROfs: terrain reference offset for arming altitude
+// @Field: Hit: Number of height lookups which found their tile in memory
+// @Field: Miss: Number of height lookups which had to wait for a tile to be loaded
+// @Field: PF: Number of tiles loaded ahead of the vehicle
 
 // @LoggerMessage: TSYN
 // @Description: Time synchronisation response information
@@ -1200,7 +1262,7 @@ LOG_STRUCTURE_FROM_AVOIDANCE \
     { LOG_SIMSTATE_MSG, sizeof(log_AHRS), \
       "SIM","QccCfLLffff","TimeUS,Roll,Pitch,Yaw,Alt,Lat,Lng,Q1,Q2,Q3,Q4", "sddhmDU----", "FBBB0GG0000", true }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
-      "TERR","QBLLHffHHf","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs", "s-DU-mm--m", "F-GG-00--0", true }, \
+      "TERR","QBLLHffHHfIIH","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs,Hit,Miss,PF", "s-DU-mm--m---", "F-GG-00--0---", true }, \
 LOG_STRUCTURE_FROM_ESC_TELEM \
 LOG_STRUCTURE_FROM_SERVO_TELEM \
     { LOG_PIDR_MSG, sizeof(log_PID), \
@@ -1229,11 +1291,15 @@ LOG_STRUCTURE_FROM_HAL \
 LOG_STRUCTURE_FROM_RPM \
 LOG_STRUCTURE_FROM_FENCE \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
-      "DSF", "QIHIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv", "s--b---", "F--0---" }, \
+      "DSF", "QIHIIIIBII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv,WQ,WLa,WLx", "s--b----ss", "F--0----FF" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
       "MAV", "QBHHHBHHI",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf,mgs", "s#----s-s", "F-000-C-C" },   \
+    { LOG_MAVR_MSG, sizeof(log_MAVR),   \
+      "MAVR", "QBBBBIII", "TimeUS,chan,sys,comp,type,Age,Rx,Fwd", "s#---s--", "F----C00" },   \
+    { LOG_MAVS_MSG, sizeof(log_MAVS),   \
+      "MAVS", "QBIIIHBHHH", "TimeUS,chan,BW,Dem,Tx,Scl,Bkt,Snt,Late,UMx", "s#BBB%--ss", "F-000000CF" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -1331,6 +1397,8 @@ enum LogMessages : uint8_t {
     LOG_EVENT_MSG,
     LOG_WHEELENCODER_MSG,
     LOG_MAV_MSG,
+    LOG_MAVS_MSG,
+    LOG_MAVR_MSG,
     LOG_ERROR_MSG,
     LOG_ADSB_MSG,
     LOG_ARM_DISARM_MSG,
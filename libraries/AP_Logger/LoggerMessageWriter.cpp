@@ -333,8 +333,19 @@ void LoggerMessageWriter_WriteSysInfo::process() {
         if (! _logger_backend->Write_MessageF("Param space used: %u/%u", AP_Param::storage_used(), AP_Param::storage_size())) {
             return; // call me again
         }
+        stage = Stage::PARAM_LOAD_TIME;
+        FALLTHROUGH;
+
+    case Stage::PARAM_LOAD_TIME: {
+        uint32_t load_us;
+        uint16_t loaded;
+        AP_Param::load_all_stats(load_us, loaded);
+        if (! _logger_backend->Write_MessageF("Param load: %u in %uus", unsigned(loaded), unsigned(load_us))) {
+            return; // call me again
+        }
         stage = Stage::RC_PROTOCOL;
         FALLTHROUGH;
+    }
 
     case Stage::RC_PROTOCOL: {
 #if CONFIG_HAL_BOARD != HAL_BOARD_LINUX
@@ -35,6 +35,7 @@ private:
         VER,  // i.e. the "VER" message
         SYSTEM_ID,
         PARAM_SPACE_USED,
+        PARAM_LOAD_TIME,
         RC_PROTOCOL,
         RC_OUTPUT,
     };
@@ -0,0 +1,108 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+
+#include <AP_Logger/AP_Logger_Compress.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+// encode a block and check it decodes to the original data
+static void check_round_trip(AP_Logger_Compress &c, const uint8_t *data, uint32_t len, LogBlockType expected_type)
+{
+    uint8_t *block = new uint8_t[AP_Logger_Compress::max_block_size(len)];
+    uint8_t *decoded = new uint8_t[len+1];
+
+    const uint32_t block_len = c.encode_block(data, len, block);
+    ASSERT_LE(block_len, AP_Logger_Compress::max_block_size(len));
+
+    log_compressed_block hdr;
+    memcpy(&hdr, block, sizeof(hdr));
+    EXPECT_EQ(uint32_t(LOG_COMPRESSED_BLOCK_MAGIC), hdr.magic);
+    EXPECT_EQ(len, hdr.raw_len);
+    EXPECT_EQ(block_len, sizeof(hdr) + hdr.data_len);
+    EXPECT_EQ(uint8_t(expected_type), hdr.type);
+
+    EXPECT_EQ(int32_t(len), AP_Logger_Compress::decode_block(hdr, &block[sizeof(hdr)], decoded, len+1));
+    EXPECT_EQ(0, memcmp(data, decoded, len));
+
+    // output too small for the block
+    if (len > 0) {
+        EXPECT_EQ(-1, AP_Logger_Compress::decode_block(hdr, &block[sizeof(hdr)], decoded, len-1));
+    }
+
+    delete[] block;
+    delete[] decoded;
+}
+
+TEST(AP_Logger_Compress, RoundTrip)
+{
+    AP_Logger_Compress c;
+    ASSERT_TRUE(c.init());
+
+    // log-like data: a repeated message with a changing timestamp
+    const uint32_t len = 4096;
+    uint8_t data[len];
+    for (uint32_t i=0; i<len; i++) {
+        data[i] = (i % 23 == 3) ? uint8_t(i/23) : uint8_t(i % 23);
+    }
+    check_round_trip(c, data, len, LogBlockType::LZ4);
+
+    // long runs need extended length bytes
+    memset(data, 0xA3, len);
+    check_round_trip(c, data, len, LogBlockType::LZ4);
+
+    // incompressible data is stored
+    uint32_t x = 1;
+    for (uint32_t i=0; i<len; i++) {
+        x = x * 1103515245U + 12345U;
+        data[i] = x >> 24;
+    }
+    check_round_trip(c, data, len, LogBlockType::STORED);
+
+    // blocks too short to hold a match
+    check_round_trip(c, data, 5, LogBlockType::STORED);
+    check_round_trip(c, data, 0, LogBlockType::STORED);
+}
+
+TEST(AP_Logger_Compress, BadMagic)
+{
+    uint8_t out[64] {};
+    log_compressed_block hdr {};
+    hdr.raw_len = 1;
+    hdr.data_len = 1;
+    EXPECT_EQ(-1, AP_Logger_Compress::decode_block(hdr, out, out, sizeof(out)));
+}
+
+TEST(AP_Logger_Compress, EndBlock)
+{
+    uint8_t block[AP_Logger_Compress::END_BLOCK_SIZE];
+    AP_Logger_Compress::encode_end_block(123456789U, block);
+
+    uint32_t raw_size = 0;
+    EXPECT_TRUE(AP_Logger_Compress::decode_end_block(block, raw_size));
+    EXPECT_EQ(123456789U, raw_size);
+
+    // an END block decodes to no data
+    log_compressed_block hdr;
+    memcpy(&hdr, block, sizeof(hdr));
+    uint8_t out[8];
+    EXPECT_EQ(0, AP_Logger_Compress::decode_block(hdr, &block[sizeof(hdr)], out, sizeof(out)));
+
+    // the end of a log without one
+    uint8_t data[64];
+    memset(data, 0x55, sizeof(data));
+    AP_Logger_Compress c;
+    ASSERT_TRUE(c.init());
+    uint8_t *other = new uint8_t[AP_Logger_Compress::max_block_size(sizeof(data))];
+    const uint32_t len = c.encode_block(data, sizeof(data), other);
+    ASSERT_GE(len, AP_Logger_Compress::END_BLOCK_SIZE);
+    EXPECT_FALSE(AP_Logger_Compress::decode_end_block(&other[len - AP_Logger_Compress::END_BLOCK_SIZE], raw_size));
+    EXPECT_FALSE(AP_Logger_Compress::decode_end_block(other, raw_size));
+    delete[] other;
+}
+
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+AP_GTEST_PANIC()
+AP_GTEST_MAIN()
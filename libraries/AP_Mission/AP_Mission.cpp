@@ -87,6 +87,12 @@ void AP_Mission::init()
         _cmd_total.set(0);
     }
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    if (_cmd_cache == nullptr) {
+        // the mission works without the cache if this fails
+        _cmd_cache = NEW_NOTHROW Mission_Command[AP_MISSION_CMD_CACHE_SIZE]();
+    }
+#endif
 
     // check_eeprom_version - checks version of missions stored in eeprom matches this library
     // command list will be cleared if they do not match
@@ -832,6 +838,17 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    Mission_Command *cached = nullptr;
+    if (_cmd_cache != nullptr) {
+        cached = &_cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+        if (cached->index == index) {
+            cmd = *cached;
+            return true;
+        }
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -890,6 +907,12 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    if (cached != nullptr) {
+        *cached = cmd;
+    }
+#endif
+
     // return success
     return true;
 }
@@ -984,6 +1007,17 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         _storage.write_block(pos_in_storage+5, packed.bytes, 10);
     }
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    if (_cmd_cache != nullptr) {
+        // the stored form can differ from cmd, so decode it again
+        // when it is next read
+        Mission_Command &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+        if (cached.index == index) {
+            cached.index = 0;
+        }
+    }
+#endif
+
     // remember when the mission last changed
     if (index != 0) {
         // Update of home location is not a true change
@@ -464,6 +464,10 @@ public:
         // clear commands
         _nav_cmd.index = AP_MISSION_CMD_INDEX_NONE;
         _do_cmd.index = AP_MISSION_CMD_INDEX_NONE;
+
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+        _cmd_cache = nullptr;
+#endif
     }
 
     // get singleton instance
@@ -939,6 +943,13 @@ private:
     // const functions
     static HAL_Semaphore _rsem;
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    // commands decoded from storage, at their index modulo
+    // AP_MISSION_CMD_CACHE_SIZE. Entries with an index of zero are
+    // empty, as home is never cached. Protected by _rsem
+    mutable Mission_Command *_cmd_cache;
+#endif
+
     // mission items common to all vehicles:
     bool start_command_do_aux_function(const AP_Mission::Mission_Command& cmd);
     bool start_command_do_gripper(const AP_Mission::Mission_Command& cmd);
@@ -51,6 +51,7 @@ private:
     void run_set_current_cmd_while_stopped_test();
     void run_replace_cmd_test();
     void run_max_cmd_test();
+    void run_read_speed_test();
 
     AP_Mission mission{
             FUNCTOR_BIND_MEMBER(&MissionTest::start_cmd, bool, const AP_Mission::Mission_Command &),
@@ -153,6 +154,9 @@ void MissionTest::run_mission_test()
     // run_max_cmd_test - tests filling the eeprom with commands and then reading them back
     //run_max_cmd_test();
 
+    // run_read_speed_test - times reading the mission back from storage
+    //run_read_speed_test();
+
     // print current mission
     print_mission();
 
@@ -1323,6 +1327,61 @@ void MissionTest::run_max_cmd_test()
     }
 }
 
+// run_read_speed_test - time reading every command of a mission. The
+// first pass decodes each command from storage, later passes come from
+// the command cache if AP_MISSION_CMD_CACHE_SIZE is non-zero
+void MissionTest::run_read_speed_test()
+{
+    AP_Mission::Mission_Command cmd {};
+    const uint16_t passes = 10;
+
+    // fill the mission with waypoints
+    mission.clear();
+    cmd.id = MAV_CMD_NAV_WAYPOINT;
+    for (uint16_t i=1; i<mission.num_commands_max(); i++) {
+        cmd.content.location = Location{
+            12345678,
+            23456789,
+            i,
+            Location::AltFrame::ABSOLUTE
+        };
+        if (!mission.add_cmd(cmd)) {
+            break;
+        }
+    }
+    const uint16_t num_commands = mission.num_commands();
+
+    uint32_t pass_us[passes];
+    bool success = true;
+    for (uint16_t p=0; p<passes; p++) {
+        const uint32_t start_us = AP_HAL::micros();
+        for (uint16_t i=1; i<num_commands; i++) {
+            if (!mission.read_cmd_from_storage(i, cmd) ||
+                cmd.content.location.alt != i) {
+                success = false;
+            }
+        }
+        pass_us[p] = AP_HAL::micros() - start_us;
+    }
+
+    uint32_t warm_us = 0;
+    for (uint16_t p=1; p<passes; p++) {
+        warm_us += pass_us[p];
+    }
+    warm_us /= passes-1;
+
+    hal.console->printf("read %u commands: first pass %luus, later passes %luus (cache size %u)\n",
+                        (unsigned)num_commands,
+                        (unsigned long)pass_us[0],
+                        (unsigned long)warm_us,
+                        (unsigned)AP_MISSION_CMD_CACHE_SIZE);
+    if (success) {
+        hal.console->printf("\nTest Passed!\n\n");
+    } else {
+        hal.console->printf("\nTest failed!  Commands did not read back correctly\n\n");
+    }
+}
+
 // setup
 void MissionTest::setup(void)
 {
@@ -19,8 +19,19 @@
 #include <stdint.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
+#include <AP_HAL/AP_HAL_Boards.h>
 #include "AP_Nav_Common.h"
 
+/*
+  give each core its own copy of the scratch space so cores can be
+  updated concurrently, see the EK3_OPTIONS ParallelLanes bit. This
+  costs over 7k of memory per core so is only done where the lanes
+  can run in parallel
+ */
+#ifndef NAVEKF_SCRATCH_PER_CORE
+#define NAVEKF_SCRATCH_PER_CORE (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -42,10 +53,17 @@ public:
 #endif
 
 protected:
+#if NAVEKF_SCRATCH_PER_CORE
+    Matrix24 KH;                          // intermediate result used for covariance updates
+    Matrix24 KHP;                         // intermediate result used for covariance updates
+    Matrix24 nextP;                       // Predicted covariance matrix before addition of process noise to diagonals
+    Vector28 Kfusion;                     // intermediate fusion vector
+#else
     static Matrix24 KH;                   // intermediate result used for covariance updates
     static Matrix24 KHP;                  // intermediate result used for covariance updates
     static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
     static Vector28 Kfusion;              // intermediate fusion vector
+#endif
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
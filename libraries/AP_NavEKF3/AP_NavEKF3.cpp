@@ -10,9 +10,12 @@
 #include <AP_BoardConfig/AP_BoardConfig.h>
 
 #include "AP_DAL/AP_DAL.h"
+#include <AP_Scheduler/Profiler.h>
 
 #include <new>
 
+extern const AP_HAL::HAL& hal;
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -739,8 +742,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.
-    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching
+    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution. Bit 2 (ParallelLanes): run the EKF lanes concurrently on worker threads, one per CPU. Only supported on Linux boards, elsewhere the lanes are run in turn as normal.
+    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching, 2:ParallelLanes
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -909,6 +912,8 @@ bool NavEKF3::coreBetterScore(uint8_t new_core, uint8_t current_core) const
 */
 void NavEKF3::UpdateFilter(void)
 {
+    AP_PROFILE_SCOPE("EKF3");
+
     dal.start_frame(AP_DAL::FrameType::UpdateFilterEKF3);
 
     if (!core) {
@@ -917,17 +922,32 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
+    // the lanes can only run concurrently when they don't share the
+    // scratch space in NavEKF_core_common
+    if (NAVEKF_SCRATCH_PER_CORE && option_is_enabled(Option::ParallelLanes) && num_cores > 1) {
+        // the lanes are independent given the same DAL frame, so run
+        // them concurrently if the HAL supports it. The prediction
+        // scheduling decision updates shared DAL state so is made for
+        // all lanes before any of them run
+        for (uint8_t i=0; i<num_cores; i++) {
+            coreAllowPrediction[i] = !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+                                       dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+        }
+        if (!hal.scheduler->run_parallel(FUNCTOR_BIND_MEMBER(&NavEKF3::updateCoreFilter, void, uint8_t), num_cores)) {
+            for (uint8_t i=0; i<num_cores; i++) {
+                updateCoreFilter(i);
+            }
+        }
+    } else {
+        for (uint8_t i=0; i<num_cores; i++) {
+            // if we have not overrun by more than 3 IMU frames, and we
+            // have already used more than 1/3 of the CPU budget for this
+            // loop then suppress the prediction step. This allows
+            // multiple EKF instances to cooperate on scheduling
+            coreAllowPrediction[i] = !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+                                       dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+            updateCoreFilter(i);
         }
-        core[i].UpdateFilter(allow_state_prediction);
     }
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
@@ -1020,6 +1040,13 @@ void NavEKF3::UpdateFilter(void)
     sources.align_inactive_sources();
 }
 
+// run the filter update for one core, called from worker threads
+// when the ParallelLanes option is set
+void NavEKF3::updateCoreFilter(uint8_t core_index)
+{
+    core[core_index].UpdateFilter(coreAllowPrediction[core_index]);
+}
+
 /*
   check if switching lanes will reduce the normalised
   innovations. This is called when the vehicle code is about to
@@ -1409,9 +1436,12 @@ bool NavEKF3::getOriginLLH(Location &loc) const
     if (!core) {
         return false;
     }
-    if (common_origin_valid) {
-        loc = common_EKF_origin;
-        return true;
+    {
+        WITH_SEMAPHORE(origin_sem);
+        if (common_origin_valid) {
+            loc = common_EKF_origin;
+            return true;
+        }
     }
     return core[primary].getOriginLLH(loc);
 }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <AP_Common/Location.h>
+#include <AP_HAL/Semaphores.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
@@ -459,6 +460,7 @@ private:
     enum class Option {
         JammingExpected     = (1<<0),
         ManualLaneSwitch   = (1<<1),
+        ParallelLanes      = (1<<2),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -543,10 +545,15 @@ private:
     float coreRelativeErrors[MAX_EKF_CORES];        // relative errors of cores with respect to primary
     float coreErrorScores[MAX_EKF_CORES];           // the instance error values used to update relative core error
     uint64_t coreLastTimePrimary_us[MAX_EKF_CORES]; // last time we were using this core as primary
+    bool coreAllowPrediction[MAX_EKF_CORES];        // true when this core may run the state prediction this frame
 
     // origin set by one of the cores
     Location common_EKF_origin;
     bool common_origin_valid;
+    HAL_Semaphore origin_sem;                       // protects the common origin when cores run in parallel
+
+    // run the filter update for one core
+    void updateCoreFilter(uint8_t core_index);
     
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
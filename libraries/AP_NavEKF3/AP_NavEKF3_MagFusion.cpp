@@ -5,6 +5,7 @@
 
 #include <GCS_MAVLink/GCS.h>
 #include <AP_DAL/AP_DAL.h>
+#include <AP_Scheduler/Profiler.h>
 
 // minimum GPS horizontal speed required to use GPS ground course for yaw alignment (m/s)
 #if APM_BUILD_TYPE(APM_BUILD_ArduPlane)
@@ -226,6 +227,8 @@ void NavEKF3_core::alignYawAngle(const yaw_elements &yawAngData)
 // select fusion of magnetometer data
 void NavEKF3_core::SelectMagFusion()
 {
+    AP_PROFILE_SCOPE("SelectMagFusion");
+
     // clear the flag that lets other processes know that the expensive magnetometer fusion operation has been performed on that time step
     // used for load levelling
     magFusePerformed = false;
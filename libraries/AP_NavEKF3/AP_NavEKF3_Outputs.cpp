@@ -252,7 +252,7 @@ bool NavEKF3_core::getPosNE(Vector2p &posNE) const
     if (PV_AidingMode != AID_NONE) {
         // This is the normal mode of operation where we can use the EKF position states
         // correct for the IMU offset (EKF calculations are at the IMU)
-        posNE = outputDataNew.position.xy().topostype() + posOffsetNED.xy().topostype() + public_origin.get_distance_NE_postype(EKF_origin);
+        posNE = outputDataNew.position.xy().topostype() + posOffsetNED.xy().topostype() + get_public_origin().get_distance_NE_postype(EKF_origin);
         return true;
 
     } else {
@@ -262,7 +262,7 @@ bool NavEKF3_core::getPosNE(Vector2p &posNE) const
             if ((gps.status(selected_gps) >= AP_DAL_GPS::GPS_OK_FIX_2D)) {
                 // If the origin has been set and we have GPS, then return the GPS position relative to the origin
                 const Location &gpsloc = gps.location(selected_gps);
-                posNE = public_origin.get_distance_NE_postype(gpsloc);
+                posNE = get_public_origin().get_distance_NE_postype(gpsloc);
                 return false;
 #if EK3_FEATURE_BEACON_FUSION
             } else if (rngBcn.alignmentStarted) {
@@ -305,7 +305,7 @@ bool NavEKF3_core::getPosD(postype_t &posD) const
     // adjust posD for difference between our origin and the public_origin
     Location local_origin;
     if (getOriginLLH(local_origin)) {
-        posD += (public_origin.alt - local_origin.alt) * 0.01;
+        posD += (get_public_origin().alt - local_origin.alt) * 0.01;
     }
 
     return ret;
@@ -406,7 +406,7 @@ void NavEKF3_core::getEkfControlLimits(float &ekfGndSpdLimit, float &ekfNavVelGa
 bool NavEKF3_core::getOriginLLH(Location &loc) const
 {
     if (validOrigin) {
-        loc = public_origin;
+        loc = get_public_origin();
         // report internally corrected reference height if enabled
         if ((frontend->_originHgtMode & (1<<2)) == 0) {
             loc.alt = (int32_t)(100.0f * (float)ekfGpsRefHgt);
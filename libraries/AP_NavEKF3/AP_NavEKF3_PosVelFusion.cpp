@@ -4,6 +4,7 @@
 #include "AP_NavEKF3_core.h"
 #include <GCS_MAVLink/GCS.h>
 #include <AP_DAL/AP_DAL.h>
+#include <AP_Scheduler/Profiler.h>
 
 /********************************************************
 *                   RESET FUNCTIONS                     *
@@ -439,7 +440,7 @@ void NavEKF3_core::CorrectExtNavForSensorOffset(ext_nav_elements &ext_nav_data)
     ext_nav_data.corrected = true;
 
     // external nav data is against the public_origin, so convert to offset from EKF_origin
-    ext_nav_data.pos.xy() += EKF_origin.get_distance_NE_ftype(public_origin);
+    ext_nav_data.pos.xy() += EKF_origin.get_distance_NE_ftype(get_public_origin());
 
 #if HAL_VISUALODOM_ENABLED
     const auto *visual_odom = dal.visualodom();
@@ -501,6 +502,8 @@ void NavEKF3_core::CalculateVelInnovationsAndVariances(const Vector3F &velocity,
 // select fusion of velocity, position and height measurements
 void NavEKF3_core::SelectVelPosFusion()
 {
+    AP_PROFILE_SCOPE("SelectVelPosFusion");
+
     // Check if the magnetometer has been fused on that time step and the filter is running at faster than 200 Hz
     // If so, don't fuse measurements on this time step to reduce frame over-runs
     // Only allow one time slip to prevent high rate magnetometer data preventing fusion of other measurements
@@ -6,6 +6,7 @@
 #include <AP_VisualOdom/AP_VisualOdom.h>
 #include <AP_Logger/AP_Logger.h>
 #include <AP_DAL/AP_DAL.h>
+#include <AP_Scheduler/Profiler.h>
 
 // constructor
 NavEKF3_core::NavEKF3_core(NavEKF3 *_frontend, AP_DAL &_dal) :
@@ -1009,6 +1010,8 @@ void NavEKF3_core::calcOutputStates()
 */
 void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
 {
+    AP_PROFILE_SCOPE("CovariancePrediction");
+
     ftype daxVar;       // X axis delta angle noise variance rad^2
     ftype dayVar;       // Y axis delta angle noise variance rad^2
     ftype dazVar;       // Z axis delta angle noise variance rad^2
@@ -2253,6 +2256,20 @@ void NavEKF3_core::verifyTiltErrorVariance()
 }
 #endif
 
+// return a copy of the public origin, taken under the lock held by setOrigin()
+Location NavEKF3_core::get_public_origin(void) const
+{
+    WITH_SEMAPHORE(frontend->origin_sem);
+    return public_origin;
+}
+
+// return true when one of the cores has set the common origin
+bool NavEKF3_core::common_origin_valid(void) const
+{
+    WITH_SEMAPHORE(frontend->origin_sem);
+    return frontend->common_origin_valid;
+}
+
 /*
   move the EKF origin to the current position at 1Hz. The public_origin doesn't move.
   By moving the EKF origin we keep the distortion due to spherical
@@ -2261,7 +2278,7 @@ void NavEKF3_core::verifyTiltErrorVariance()
 void NavEKF3_core::moveEKFOrigin(void)
 {
     // only move origin when we have a origin and we're using GPS
-    if (!frontend->common_origin_valid || !filterStatus.flags.using_gps) {
+    if (!common_origin_valid() || !filterStatus.flags.using_gps) {
         return;
     }
 
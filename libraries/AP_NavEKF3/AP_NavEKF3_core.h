@@ -1553,6 +1553,10 @@ private:
     // move EKF origin at 1Hz
     void moveEKFOrigin(void);
 
+    // copy of the origin shared between cores, which another core may set while cores run in parallel
+    Location get_public_origin(void) const;
+    bool common_origin_valid(void) const;
+
     // handle earth field updates
     void getEarthFieldTable(const Location &loc);
     void checkUpdateEarthField(void);
@@ -0,0 +1,284 @@
+/*
+  benchmark the EKF3 update cycle
+
+  The filter is driven through AP_DAL in the same way as Replay,
+  using synthetic replay frames for a vehicle in straight and level
+  flight. Each benchmark iteration is one 400Hz IMU frame followed by
+  NavEKF3::UpdateFilter, so the reported time is ns per UpdateFilter.
+
+  The fusion benchmarks add one sensor at a time to an IMU and baro
+  only configuration; the difference between them gives the cost of
+  the extra fusion step (FuseVelPosNED, FuseMagnetometer,
+  FuseAirspeed and FuseOptFlow).
+ */
+
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/Location.h>
+#include <AP_DAL/AP_DAL.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_NavEKF2/AP_NavEKF2.h>
+#include <AP_NavEKF3/AP_NavEKF3.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// the EKF writes some log messages directly from UpdateFilter
+static AP_Logger logger;
+
+#define BENCH_LOOP_RATE_HZ 400
+#define BENCH_DT_US (1000000U / BENCH_LOOP_RATE_HZ)
+#define BENCH_WARMUP_FRAMES (30 * BENCH_LOOP_RATE_HZ)
+#define BENCH_SPEED 20.0f          // m/s, flying north
+#define BENCH_HEIGHT 50.0f         // m above ground for optical flow
+
+enum BenchSensor : uint8_t {
+    SENSOR_GPS      = 1U<<0,
+    SENSOR_MAG      = 1U<<1,
+    SENSOR_AIRSPEED = 1U<<2,
+    SENSOR_OPTFLOW  = 1U<<3,
+};
+
+static NavEKF2 ekf2;
+
+// the DAL clock must never go backwards between benchmarks
+static uint64_t sim_time_us = 1000000;
+
+static const Location home { -353632640, 1491652352, 58400, Location::AltFrame::ABSOLUTE };
+
+/*
+  set a parameter in the EKF3 SRCn_ source subgroup
+ */
+static bool set_source_param(NavEKF3 &ekf, const char *name, float value)
+{
+    for (const AP_Param::GroupInfo *g = NavEKF3::var_info2; g->type != AP_PARAM_NONE; g++) {
+        if (g->type == AP_PARAM_GROUP && strcmp(g->name, "SRC") == 0) {
+            return AP_Param::set_object_value((const uint8_t *)&ekf + g->offset,
+                                              AP_NavEKF_Source::var_info, name, value);
+        }
+    }
+    return false;
+}
+
+class EKF3Bench {
+public:
+    EKF3Bench(uint8_t _lanes, uint8_t _sensors) :
+        lanes(_lanes),
+        sensors(_sensors),
+        // a new filter for each run so that no state carries over from
+        // earlier benchmarks and every run sees the same frames. The
+        // cores are allocated through the DAL and are never freed, as
+        // on a vehicle
+        ekf3(NEW_NOTHROW NavEKF3())
+    {
+        if (ekf3 == nullptr) {
+            AP_HAL::panic("Unable to allocate NavEKF3");
+        }
+        AP_Param::set_object_value(ekf3, NavEKF3::var_info, "IMU_MASK", (1U<<lanes)-1);
+        // the synthetic GPS is perfect, don't wait for the pre-flight checks
+        AP_Param::set_object_value(ekf3, NavEKF3::var_info, "GPS_CHECK", 0);
+        set_source_param(*ekf3, "1_VELXY", float(int8_t((sensors & SENSOR_OPTFLOW) ?
+                                                         AP_NavEKF_Source::SourceXY::OPTFLOW :
+                                                         AP_NavEKF_Source::SourceXY::GPS)));
+        start_time_us = sim_time_us;
+        write_headers();
+        step(AP_DAL::FrameType::InitialiseFilterEKF3);
+        for (uint32_t i=0; i<BENCH_WARMUP_FRAMES; i++) {
+            step();
+        }
+    }
+
+    ~EKF3Bench() {
+        delete ekf3;
+    }
+
+    CLASS_NO_COPY(EKF3Bench);
+
+    // advance one IMU frame and run the filter
+    void step(AP_DAL::FrameType type = AP_DAL::FrameType::UpdateFilterEKF3);
+
+private:
+    void write_headers();
+
+    const uint8_t lanes;
+    const uint8_t sensors;
+    NavEKF3 *ekf3;
+    uint64_t start_time_us;
+    uint32_t frame = 0;
+};
+
+void EKF3Bench::write_headers()
+{
+    auto &dal = AP::dal();
+
+    log_RFRN rfrn {};
+    rfrn.lat = home.lat;
+    rfrn.lng = home.lng;
+    rfrn.alt = home.alt;
+    rfrn.EAS2TAS = 1.0f;
+    rfrn.available_memory = 1024*1024U;
+    rfrn.vehicle_class = uint8_t(AP_DAL::VehicleClass::FIXED_WING);
+    rfrn.ekf_type = 3;
+    rfrn.armed = 1;
+    rfrn.fly_forward = 1;
+    rfrn.ahrs_airspeed_sensor_enabled = (sensors & SENSOR_AIRSPEED) ? 1U : 0U;
+    rfrn.opticalflow_enabled = (sensors & SENSOR_OPTFLOW) ? 1U : 0U;
+    dal.handle_message(rfrn);
+
+    log_RISH rish {};
+    rish.loop_rate_hz = BENCH_LOOP_RATE_HZ;
+    rish.loop_delta_t = 1.0f / BENCH_LOOP_RATE_HZ;
+    rish.accel_count = lanes;
+    rish.gyro_count = lanes;
+    dal.handle_message(rish);
+
+    log_RBRH rbrh {};
+    rbrh.num_instances = 1;
+    dal.handle_message(rbrh);
+
+    log_RGPH rgph {};
+    rgph.num_sensors = uint8_t((sensors & SENSOR_GPS) ? 1 : 0);
+    dal.handle_message(rgph);
+
+    log_RGPI rgpi {};
+    rgpi.lag_sec = 0.2f;
+    rgpi.have_vertical_velocity = 1;
+    rgpi.horizontal_accuracy_returncode = 1;
+    rgpi.vertical_accuracy_returncode = 1;
+    rgpi.get_lag_returncode = 1;
+    rgpi.speed_accuracy_returncode = 1;
+    rgpi.status = uint8_t((sensors & SENSOR_GPS) ? 3 : 0);
+    rgpi.num_sats = 12;
+    dal.handle_message(rgpi);
+
+    log_RMGH rmgh {};
+    rmgh.available = (sensors & SENSOR_MAG) != 0;
+    rmgh.count = uint8_t((sensors & SENSOR_MAG) ? 1 : 0);
+    rmgh.num_enabled = uint8_t((sensors & SENSOR_MAG) ? 1 : 0);
+    rmgh.consistent = true;
+    dal.handle_message(rmgh);
+
+    if (sensors & SENSOR_AIRSPEED) {
+        log_RASH rash {};
+        rash.num_sensors = 1;
+        dal.handle_message(rash);
+    }
+}
+
+void EKF3Bench::step(AP_DAL::FrameType type)
+{
+    auto &dal = AP::dal();
+
+    sim_time_us += BENCH_DT_US;
+    frame++;
+    const uint32_t now_ms = sim_time_us / 1000U;
+    const float dt = BENCH_DT_US * 1.0e-6f;
+
+    log_RFRH rfrh {};
+    rfrh.time_us = sim_time_us;
+    rfrh.time_flying_ms = uint32_t((sim_time_us - start_time_us) / 1000U);
+    dal.handle_message(rfrh);
+
+    // level, unaccelerated flight: the accelerometers see only gravity
+    for (uint8_t i=0; i<lanes; i++) {
+        log_RISI risi {};
+        risi.delta_velocity = Vector3f(0, 0, -GRAVITY_MSS * dt);
+        risi.delta_velocity_dt = dt;
+        risi.delta_angle_dt = dt;
+        risi.use_accel = 1;
+        risi.use_gyro = 1;
+        risi.get_delta_velocity_ret = 1;
+        risi.get_delta_angle_ret = 1;
+        risi.instance = i;
+        dal.handle_message(risi);
+    }
+
+    // baro at 50Hz
+    if (frame % 8 == 0) {
+        log_RBRI rbri {};
+        rbri.last_update_ms = now_ms;
+        rbri.healthy = true;
+        dal.handle_message(rbri);
+    }
+
+    // compass at 100Hz, earth field seen while heading north
+    if ((sensors & SENSOR_MAG) && frame % 4 == 0) {
+        log_RMGI rmgi {};
+        rmgi.last_update_usec = uint32_t(sim_time_us);
+        rmgi.field = Vector3f(200, 0, 450);
+        rmgi.use_for_yaw = true;
+        rmgi.healthy = true;
+        dal.handle_message(rmgi);
+    }
+
+    // GPS at 5Hz
+    if ((sensors & SENSOR_GPS) && frame % 80 == 0) {
+        Location loc = home;
+        loc.offset((sim_time_us - start_time_us) * 1.0e-6f * BENCH_SPEED, 0);
+        log_RGPJ rgpj {};
+        rgpj.last_message_time_ms = now_ms;
+        rgpj.velocity = Vector3f(BENCH_SPEED, 0, 0);
+        rgpj.sacc = 0.3f;
+        rgpj.lat = loc.lat;
+        rgpj.lng = loc.lng;
+        rgpj.alt = loc.alt;
+        rgpj.hacc = 0.5f;
+        rgpj.vacc = 0.8f;
+        rgpj.hdop = 80;
+        dal.handle_message(rgpj);
+    }
+
+    // airspeed at 10Hz
+    if ((sensors & SENSOR_AIRSPEED) && frame % 40 == 0) {
+        log_RASI rasi {};
+        rasi.airspeed = BENCH_SPEED;
+        rasi.last_update_ms = now_ms;
+        rasi.healthy = true;
+        rasi.use = true;
+        dal.handle_message(rasi);
+    }
+
+    // optical flow at 10Hz, ground moving aft at speed/height
+    if ((sensors & SENSOR_OPTFLOW) && frame % 40 == 0) {
+        ekf3->writeOptFlowMeas(255,
+                              Vector2f(0, -BENCH_SPEED / BENCH_HEIGHT),
+                              Vector2f(),
+                              now_ms,
+                              Vector3f(),
+                              BENCH_HEIGHT);
+    }
+
+    log_RFRF rfrf {};
+    rfrf.frame_types = uint8_t(type);
+    dal.handle_message(rfrf, ekf2, *ekf3);
+}
+
+static void BM_EKF3_UpdateFilter(benchmark::State& state)
+{
+    EKF3Bench bench(state.range_x(), SENSOR_GPS | SENSOR_MAG);
+    while (state.KeepRunning()) {
+        bench.step();
+    }
+}
+
+static void BM_EKF3_Fusion(benchmark::State& state)
+{
+    EKF3Bench bench(1, state.range_x());
+    while (state.KeepRunning()) {
+        bench.step();
+    }
+}
+
+BENCHMARK(BM_EKF3_UpdateFilter)->DenseRange(1, MIN(3, INS_MAX_INSTANCES));
+
+// IMU and baro only, then adding GPS (FuseVelPosNED), compass
+// (FuseMagnetometer), airspeed (FuseAirspeed) and optical flow
+// (FuseOptFlow)
+BENCHMARK(BM_EKF3_Fusion)
+    ->Arg(0)
+    ->Arg(SENSOR_GPS)
+    ->Arg(SENSOR_GPS | SENSOR_MAG)
+    ->Arg(SENSOR_GPS | SENSOR_MAG | SENSOR_AIRSPEED)
+    ->Arg(SENSOR_GPS | SENSOR_MAG | SENSOR_OPTFLOW);
+
+BENCHMARK_MAIN();
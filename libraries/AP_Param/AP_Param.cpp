@@ -25,6 +25,8 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
@@ -104,6 +106,25 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+// name index
+AP_Param::NameIndexEntry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+uint16_t AP_Param::_name_index_size;
+uint16_t AP_Param::_name_index_marker;
+bool AP_Param::_name_index_built;
+uint8_t AP_Param::_name_index_stale_lookups;
+HAL_Semaphore AP_Param::_name_index_sem;
+
+// number of lookups after a change in the parameter layout before
+// the name index is rebuilt
+#define AP_PARAM_NAME_INDEX_REBUILD_LOOKUPS 32
+#endif
+
+// statistics from the last load_all()
+uint32_t AP_Param::_load_all_us;
+uint16_t AP_Param::_load_all_loaded;
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -917,6 +938,30 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        const struct GroupInfo *ginfo = nullptr;
+        const NameIndexEntry *e;
+        // the index only holds scalars, and includes the elements of
+        // top level vectors which find() doesn't match, so fall
+        // through to the search on a miss. The search matches the
+        // top level group prefix and vector element suffixes with
+        // case, but other parts of the name without, so only exact
+        // matches are taken from the index and the search decides
+        // the rest
+        if (strnlen(name, AP_MAX_NAME_SIZE+1) <= AP_MAX_NAME_SIZE &&
+            name_index_update() &&
+            (e = name_index_lookup(name, ginfo, false)) != nullptr &&
+            var_info(e->token.key).type != AP_PARAM_VECTOR3F) {
+            *ptype = (enum ap_var_type)e->type;
+            if (flags != nullptr && ginfo != nullptr) {
+                *flags = ginfo->flags;
+            }
+            return e->ap;
+        }
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         uint8_t type = info.type;
@@ -976,6 +1021,21 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 // by-name equivalent of find_by_index()
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        if (name_index_update()) {
+            const struct GroupInfo *ginfo;
+            const NameIndexEntry *e = name_index_lookup(name, ginfo, true);
+            if (e == nullptr) {
+                return nullptr;
+            }
+            *token = e->token;
+            *ptype = (enum ap_var_type)e->type;
+            return e->ap;
+        }
+    }
+#endif
     AP_Param *ap;
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
@@ -998,6 +1058,130 @@ AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, Para
     return ap;
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  hash of a parameter name, ignoring case so that the index can be
+  used by find_by_name(), which ignores case, as well as by find()
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint8_t buf[AP_MAX_NAME_SIZE];
+    uint8_t len = 0;
+    for (; len<AP_MAX_NAME_SIZE && name[len] != 0; len++) {
+        buf[len] = toupper(name[len]);
+    }
+    uint64_t hash = FNV_1_OFFSET_BASIS_64;
+    hash_fnv_1a(len, buf, &hash);
+    return uint32_t(hash ^ (hash >> 32));
+}
+
+/*
+  make sure the name index matches the current parameter layout,
+  returning false if lookups should fall back to searching the
+  var_info tables. The layout changes many times during startup as
+  objects load their parameters, so the index is only rebuilt once
+  the layout has been stable for a number of lookups
+ */
+bool AP_Param::name_index_update(void)
+{
+    if (_name_index_marker != _count_marker) {
+        _name_index_marker = _count_marker;
+        _name_index_built = false;
+        _name_index_stale_lookups = 0;
+    }
+    if (_name_index_built) {
+        return true;
+    }
+    if (_name_index_stale_lookups < AP_PARAM_NAME_INDEX_REBUILD_LOOKUPS) {
+        _name_index_stale_lookups++;
+        return false;
+    }
+
+    const uint16_t marker = _count_marker;
+    const uint16_t count = count_parameters();
+    if (count > _name_index_size) {
+        delete[] _name_index;
+        _name_index = NEW_NOTHROW NameIndexEntry[count];
+        _name_index_size = _name_index != nullptr ? count : 0;
+        _name_index_count = 0;
+        if (_name_index == nullptr) {
+            return false;
+        }
+    }
+
+    // walk the same scalars as find_by_name() does
+    uint16_t n = 0;
+    ParamToken token {};
+    enum ap_var_type type;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && n < _name_index_size;
+         ap = next_scalar(&token, &type)) {
+        if (type > AP_PARAM_FLOAT) {
+            continue;
+        }
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+        name[AP_MAX_NAME_SIZE] = 0;
+        NameIndexEntry &e = _name_index[n++];
+        e.hash = name_hash(name);
+        e.token = token;
+        e.ap = ap;
+        e.type = type;
+    }
+    qsort(_name_index, n, sizeof(_name_index[0]), [](const void *v1, const void *v2) {
+        const uint32_t h1 = ((const NameIndexEntry *)v1)->hash;
+        const uint32_t h2 = ((const NameIndexEntry *)v2)->hash;
+        return h1 < h2 ? -1 : (h1 > h2 ? 1 : 0);
+    });
+    _name_index_count = n;
+
+    // another thread may have changed the layout while we were
+    // walking it
+    _name_index_built = (marker == _count_marker);
+    return _name_index_built;
+}
+
+/*
+  find a parameter in the name index, returning its group info in
+  ginfo. Entries which hash to the same value are checked by name,
+  ignoring case if ignore_case is set
+ */
+const AP_Param::NameIndexEntry *AP_Param::name_index_lookup(const char *name, const struct GroupInfo *&ginfo, bool ignore_case)
+{
+    const uint32_t hash = name_hash(name);
+
+    // binary search for the first entry with this hash
+    uint16_t lo = 0;
+    uint16_t hi = _name_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (; lo < _name_index_count && _name_index[lo].hash == hash; lo++) {
+        const NameIndexEntry &e = _name_index[lo];
+        uint32_t group_element;
+        struct GroupNesting group_nesting {};
+        uint8_t idx;
+        const struct Info *info = e.ap->find_var_info_token(e.token, &group_element, ginfo, group_nesting, &idx);
+        if (info == nullptr) {
+            continue;
+        }
+        char buf[AP_MAX_NAME_SIZE];
+        e.ap->copy_name_info(info, ginfo, group_nesting, idx, buf, sizeof(buf), false);
+        const int cmp = ignore_case ? strncasecmp(name, buf, AP_MAX_NAME_SIZE) : strncmp(name, buf, AP_MAX_NAME_SIZE);
+        if (cmp == 0) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+#endif  // AP_PARAM_NAME_INDEX_ENABLED
+
 /*
   Find a variable by pointer, returning key. This is used for loading pointer variables
 */
@@ -1566,6 +1750,146 @@ void AP_Param::setup_sketch_defaults(void)
 }
 
 
+#if AP_PARAM_LOAD_INDEX_ENABLED
+// key for a storage header which sorts the same way for equal headers
+uint32_t AP_Param::header_index_key(uint16_t key, uint32_t group_element, uint8_t type)
+{
+    return (uint32_t(key) << 23) | (group_element << 5) | type;
+}
+
+/*
+  add the variables in a group to the header index, following the
+  same walk as find_by_header_group(). Entries are only stored if
+  index is not null, so this can also be used to count them. Returns
+  the new number of entries
+ */
+uint16_t AP_Param::header_index_group(HeaderIndexEntry *index, uint16_t n, uint16_t size,
+                                      uint16_t vindex, const struct GroupInfo *group_info,
+                                      uint32_t group_base, uint8_t group_shift,
+                                      ptrdiff_t group_offset)
+{
+    uint8_t type;
+    for (uint8_t i=0;
+         (type=group_info[i].type) != AP_PARAM_NONE;
+         i++) {
+        if (type == AP_PARAM_GROUP) {
+            if (group_shift + _group_level_shift >= _group_bits) {
+                continue;
+            }
+            const struct GroupInfo *ginfo = get_group_info(group_info[i]);
+            if (ginfo == nullptr) {
+                continue;
+            }
+            ptrdiff_t new_offset = group_offset;
+            if (!adjust_group_offset(vindex, group_info[i], new_offset)) {
+                continue;
+            }
+            n = header_index_group(index, n, size, vindex, ginfo,
+                                   group_id(group_info, group_base, i, group_shift),
+                                   group_shift + _group_level_shift, new_offset);
+            continue;
+        }
+        ptrdiff_t base;
+        if (!get_base(var_info(vindex), base)) {
+            continue;
+        }
+        if (index != nullptr) {
+            if (n >= size) {
+                return n;
+            }
+            index[n].header = header_index_key(var_info(vindex).key,
+                                               group_id(group_info, group_base, i, group_shift),
+                                               type);
+            index[n].seq = n;
+            index[n].ptr = (void*)(base + group_info[i].offset + group_offset);
+        }
+        n++;
+    }
+    return n;
+}
+
+/*
+  add all variables to the header index, or count them if index is
+  null
+ */
+uint16_t AP_Param::header_index_fill(HeaderIndexEntry *index, uint16_t size)
+{
+    uint16_t n = 0;
+    for (uint16_t i=0; i<_num_vars; i++) {
+        const auto &info = var_info(i);
+        if (info.type == AP_PARAM_GROUP) {
+            const struct GroupInfo *group_info = get_group_info(info);
+            if (group_info != nullptr) {
+                n = header_index_group(index, n, size, i, group_info, 0, 0, 0);
+            }
+            continue;
+        }
+        ptrdiff_t base;
+        if (!get_base(info, base)) {
+            continue;
+        }
+        if (index != nullptr) {
+            if (n >= size) {
+                break;
+            }
+            index[n].header = header_index_key(info.key, 0, info.type);
+            index[n].seq = n;
+            index[n].ptr = (void*)base;
+        }
+        n++;
+    }
+    return n;
+}
+
+/*
+  build the header index with a single walk of var_info, so each
+  stored value can be found with a binary search rather than a
+  search of var_info. Returns nullptr if there isn't enough memory
+ */
+AP_Param::HeaderIndexEntry *AP_Param::header_index_build(uint16_t &count)
+{
+    const uint16_t size = header_index_fill(nullptr, 0);
+    auto *index = NEW_NOTHROW HeaderIndexEntry[size];
+    if (index == nullptr) {
+        return nullptr;
+    }
+    count = header_index_fill(index, size);
+    qsort(index, count, sizeof(index[0]), [](const void *v1, const void *v2) {
+        const auto *e1 = (const HeaderIndexEntry *)v1;
+        const auto *e2 = (const HeaderIndexEntry *)v2;
+        if (e1->header != e2->header) {
+            return e1->header < e2->header ? -1 : 1;
+        }
+        return int(e1->seq) - int(e2->seq);
+    });
+    return index;
+}
+
+/*
+  find the variable for a storage header in the index, giving the
+  first match in var_info order. Returns nullptr if not found
+ */
+void *AP_Param::header_index_find(const HeaderIndexEntry *index, uint16_t count,
+                                  const struct Param_header &phdr)
+{
+    const uint32_t header = header_index_key(get_key(phdr), phdr.group_element, phdr.type);
+    uint16_t lo = 0;
+    uint16_t hi = count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (index[mid].header < header) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < count && index[lo].header == header) {
+        return index[lo].ptr;
+    }
+    return nullptr;
+}
+#endif  // AP_PARAM_LOAD_INDEX_ENABLED
+
 // Load all variables from EEPROM
 //
 bool AP_Param::load_all()
@@ -1579,29 +1903,56 @@ bool AP_Param::load_all()
         registered_save_handler = true;
         hal.scheduler->register_io_process(FUNCTOR_BIND((&save_dummy), &AP_Param::save_io_handler, void));
     }
-    
+
+    const uint32_t start_us = AP_HAL::micros();
+    uint16_t loaded = 0;
+    bool ret = false;
+
+#if AP_PARAM_LOAD_INDEX_ENABLED
+    uint16_t index_count = 0;
+    HeaderIndexEntry *index = header_index_build(index_count);
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
             sentinal_offset = ofs;
-            return true;
+            ret = true;
+            break;
         }
 
-        const struct AP_Param::Info *info;
-        void *ptr;
+        void *ptr = nullptr;
 
-        info = find_by_header(phdr, &ptr);
-        if (info != nullptr) {
+#if AP_PARAM_LOAD_INDEX_ENABLED
+        if (index != nullptr) {
+            ptr = header_index_find(index, index_count, phdr);
+        }
+#endif
+        if (ptr == nullptr) {
+            // not indexed, fall back to a search of var_info
+            find_by_header(phdr, &ptr);
+        }
+        if (ptr != nullptr) {
             _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+            loaded++;
         }
 
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
-    // we didn't find the sentinal
-    Debug("no sentinal in load_all");
-    return false;
+#if AP_PARAM_LOAD_INDEX_ENABLED
+    delete [] index;
+#endif
+
+    _load_all_us = AP_HAL::micros() - start_us;
+    _load_all_loaded = loaded;
+
+    if (!ret) {
+        // we didn't find the sentinal
+        Debug("no sentinal in load_all");
+    }
+    return ret;
 }
 
 /*
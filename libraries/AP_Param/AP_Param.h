@@ -441,6 +441,13 @@ public:
     // returns storage space :
     static uint16_t storage_size() { return _storage.size(); }
 
+    // returns time taken by the last load_all() and the number of
+    // stored values it loaded
+    static void load_all_stats(uint32_t &time_us, uint16_t &loaded) {
+        time_us = _load_all_us;
+        loaded = _load_all_loaded;
+    }
+
     /// reoad the hal.util defaults file. Called after pointer parameters have been allocated
     ///
     static void reload_defaults_file(bool last_pass);
@@ -819,6 +826,54 @@ private:
     static HAL_Semaphore        _count_sem;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    /*
+      index of scalar parameter names, sorted by hash. It is rebuilt
+      on demand whenever the parameter count is invalidated
+     */
+    struct NameIndexEntry {
+        uint32_t hash;
+        ParamToken token;
+        AP_Param *ap;
+        uint8_t type;
+    };
+    static NameIndexEntry *     _name_index;
+    static uint16_t             _name_index_count;
+    static uint16_t             _name_index_size;
+    static uint16_t             _name_index_marker;
+    static bool                 _name_index_built;
+    static uint8_t              _name_index_stale_lookups;
+    static HAL_Semaphore        _name_index_sem;
+    static uint32_t             name_hash(const char *name);
+    static bool                 name_index_update(void);
+    static const NameIndexEntry *name_index_lookup(const char *name, const struct GroupInfo *&ginfo, bool ignore_case);
+#endif
+
+    static uint32_t             _load_all_us;
+    static uint16_t             _load_all_loaded;
+
+#if AP_PARAM_LOAD_INDEX_ENABLED
+    /*
+      map from a storage header to the variable it is loaded into,
+      sorted by header. Built from var_info by load_all() and freed
+      when it is done
+     */
+    struct HeaderIndexEntry {
+        uint32_t header;
+        uint16_t seq;       // order in var_info, first match wins
+        void *ptr;
+    };
+    static uint32_t             header_index_key(uint16_t key, uint32_t group_element, uint8_t type);
+    static uint16_t             header_index_group(HeaderIndexEntry *index, uint16_t n, uint16_t size,
+                                                   uint16_t vindex, const struct GroupInfo *group_info,
+                                                   uint32_t group_base, uint8_t group_shift,
+                                                   ptrdiff_t group_offset);
+    static uint16_t             header_index_fill(HeaderIndexEntry *index, uint16_t size);
+    static HeaderIndexEntry *   header_index_build(uint16_t &count);
+    static void *               header_index_find(const HeaderIndexEntry *index, uint16_t count,
+                                                  const struct Param_header &phdr);
+#endif
+
 #if AP_PARAM_DYNAMIC_ENABLED
     // allow for a dynamically allocated var table
     static uint16_t             _num_vars_base;
@@ -11,3 +11,13 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+// hashed index of parameter names for fast lookup by name
+#ifndef AP_PARAM_NAME_INDEX_ENABLED
+#define AP_PARAM_NAME_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+// temporary index of storage headers used to speed up load_all()
+#ifndef AP_PARAM_LOAD_INDEX_ENABLED
+#define AP_PARAM_LOAD_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
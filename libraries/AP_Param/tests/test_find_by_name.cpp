@@ -13,12 +13,26 @@ public:
         k_param_a,
         k_param_b,
         k_param_c,
+        k_param_grp,
     };
     AP_Int8 a;
     AP_Int8 b;
     AP_Int8 c;
 };
 
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int8 p;
+    AP_Vector3f v;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] {
+    AP_GROUPINFO("P", 1, TestGroup, p, 0),
+    AP_GROUPINFO("V", 2, TestGroup, v, 0),
+    AP_GROUPEND
+};
+
 class TestVehicle : public AP_Vehicle {
 public:
     friend class Test;
@@ -60,6 +74,7 @@ public:
     static const AP_Param::Info var_info[];
 
     Parameters g;
+    TestGroup grp;
     // setup the var_info table
     AP_Param param_loader{var_info};
 
@@ -73,11 +88,15 @@ const AP_Param::Info TestVehicle::var_info[] {
     GSCALAR(b,         "AA", 0),
     GSCALAR(b,         "CC", 0),
     GSCALAR(b,         "BB", 0),
+    GOBJECT(grp,       "G_", TestGroup),
 };
 
 TEST(FindByName, Bob)
 {
     for (const auto &x : TestVehicle::var_info) {
+        if (x.type == AP_PARAM_GROUP) {
+            continue;
+        }
         enum ap_var_type ptype = (ap_var_type)-1;
         AP_Param::ParamToken token = AP_Param::ParamToken {};
         AP_Param *p = AP_Param::find_by_name(x.name, &ptype, &token);
@@ -85,4 +104,65 @@ TEST(FindByName, Bob)
     }
 }
 
+// enough lookups to use both the var_info search and the name index
+TEST(FindByName, Index)
+{
+    for (uint8_t pass=0; pass<3; pass++) {
+        for (uint8_t i=0; i<40; i++) {
+            for (const auto &x : TestVehicle::var_info) {
+                if (x.type == AP_PARAM_GROUP) {
+                    continue;
+                }
+                enum ap_var_type ptype = (ap_var_type)-1;
+                AP_Param::ParamToken token = AP_Param::ParamToken {};
+                AP_Param *p = AP_Param::find_by_name(x.name, &ptype, &token);
+                ASSERT_TRUE(p);
+                EXPECT_EQ(AP_PARAM_INT8, ptype);
+                char name[AP_MAX_NAME_SIZE+1] {};
+                p->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+                EXPECT_STREQ(x.name, name);
+
+                enum ap_var_type ptype2;
+                EXPECT_EQ(p, AP_Param::find(x.name, &ptype2));
+                EXPECT_EQ(ptype, ptype2);
+            }
+
+            // names are case insensitive
+            enum ap_var_type ptype;
+            AP_Param::ParamToken token {};
+            EXPECT_EQ(AP_Param::find("A", &ptype), AP_Param::find_by_name("a", &ptype, &token));
+
+            EXPECT_EQ(nullptr, AP_Param::find_by_name("AB", &ptype, &token));
+            EXPECT_EQ(nullptr, AP_Param::find("AB", &ptype));
+            EXPECT_EQ(nullptr, AP_Param::find_by_name("", &ptype, &token));
+        }
+        // force the index to be rebuilt
+        AP_Param::invalidate_count();
+    }
+}
+
+// find() matches the top level group prefix and vector element
+// suffixes with case, and the rest of the name without, whether or
+// not it uses the name index. find_by_name() ignores case throughout
+TEST(FindByName, GroupCase)
+{
+    for (uint8_t pass=0; pass<3; pass++) {
+        for (uint8_t i=0; i<40; i++) {
+            enum ap_var_type ptype;
+            AP_Param::ParamToken token {};
+            EXPECT_EQ(&testvehicle.grp.p, AP_Param::find("G_P", &ptype));
+            EXPECT_EQ(&testvehicle.grp.p, AP_Param::find("G_p", &ptype));
+            EXPECT_EQ(nullptr, AP_Param::find("g_P", &ptype));
+            EXPECT_EQ(nullptr, AP_Param::find("g_p", &ptype));
+            EXPECT_NE(nullptr, AP_Param::find("G_V_X", &ptype));
+            EXPECT_EQ(nullptr, AP_Param::find("G_V_x", &ptype));
+
+            EXPECT_EQ(&testvehicle.grp.p, AP_Param::find_by_name("g_p", &ptype, &token));
+            EXPECT_NE(nullptr, AP_Param::find_by_name("g_v_x", &ptype, &token));
+        }
+        // force the index to be rebuilt
+        AP_Param::invalidate_count();
+    }
+}
+
 AP_GTEST_MAIN()
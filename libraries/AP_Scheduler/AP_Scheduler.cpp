@@ -70,7 +70,7 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
     // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Bitmask: 0:Enable per-task perf info, 1:Enable profiler, 2:Enable adaptive scheduling
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
@@ -195,6 +195,11 @@ void AP_Scheduler::run(uint32_t time_available)
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // time held back for tasks about to slip
+    uint32_t urgent_us = _adaptive != nullptr ? adaptive_urgent_us() : 0;
+#endif
+
     for (uint8_t i=0; i<_num_tasks; i++) {
         // determine which of the common task / vehicle task to run
         bool run_vehicle_task = false;
@@ -227,6 +232,9 @@ void AP_Scheduler::run(uint32_t time_available)
             common_tasks_offset++;
         }
 
+        // ticks the task is late by that are kept when recording its run
+        uint16_t phase_ticks = 0;
+
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
             // we allow 0 to mean loop rate
@@ -251,7 +259,15 @@ void AP_Scheduler::run(uint32_t time_available)
                 task_not_achieved++;
             }
 
-            if (_task_time_allowed > time_available) {
+            bool fits = _task_time_allowed <= time_available;
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+            if (_adaptive != nullptr) {
+                // keep the task on the tick it was phased to
+                phase_ticks = adaptive_phase_ticks(dt, interval_ticks);
+                fits = adaptive_fits(i, dt, interval_ticks, time_available, urgent_us);
+            }
+#endif
+            if (!fits) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
                 continue;
@@ -265,13 +281,16 @@ void AP_Scheduler::run(uint32_t time_available)
         hal.util->persistent_data.scheduler_task = i;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         fill_nanf_stack();
+#endif
+#if AP_SCHEDULER_PROFILER_ENABLED
+        profiler.task_start(task.name);
 #endif
         task.function();
         hal.util->persistent_data.scheduler_task = -1;
 
         // record the tick counter when we ran. This drives
         // when we next run the event
-        _last_run[i] = _tick_counter;
+        _last_run[i] = _tick_counter - phase_ticks;
 
         // work out how long the event actually took
         now = AP_HAL::micros();
@@ -288,6 +307,9 @@ void AP_Scheduler::run(uint32_t time_available)
         }
 
         perf_info.update_task_info(i, time_taken, overrun);
+#if AP_SCHEDULER_PROFILER_ENABLED
+        profiler.task_end(time_taken);
+#endif
 
         if (time_taken >= time_available) {
             /*
@@ -394,6 +416,28 @@ void AP_Scheduler::loop()
     // add in extra loop time determined by not achieving scheduler tasks
     time_available += extra_loop_us;
 
+#if AP_SCHEDULER_PROFILER_ENABLED
+    // dynamically enable the profiler
+    if ((_options & uint8_t(Options::ENABLE_PROFILER)) && !profiler.enabled()) {
+        if (!profiler.enable()) {
+            _options.set(_options & ~uint8_t(Options::ENABLE_PROFILER));
+        }
+    } else if (!(_options & uint8_t(Options::ENABLE_PROFILER)) && profiler.enabled()) {
+        profiler.disable();
+    }
+#endif
+
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // dynamically enable adaptive scheduling
+    if ((_options & uint8_t(Options::ADAPTIVE)) && _adaptive == nullptr) {
+        if (!adaptive_init()) {
+            _options.set(_options & ~uint8_t(Options::ADAPTIVE));
+        }
+    } else if (!(_options & uint8_t(Options::ADAPTIVE)) && _adaptive != nullptr) {
+        adaptive_free();
+    }
+#endif
+
     // run the tasks
     run(time_available);
 
@@ -505,46 +549,237 @@ void AP_Scheduler::task_info(ExpandingString &str)
         }
     }
 
+    print_task_info(str, total_time, false);
+}
+
+#if AP_SCHEDULER_PROFILER_ENABLED
+// display task run time histograms as text buffer for @SYS/task_hist.txt
+void AP_Scheduler::task_histogram(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("TaskHistV1 <8us <16us <32us <64us <128us <256us <512us >=512us\n");
+
+    // dynamically enable statistics collection
+    if (!(_options & uint8_t(Options::RECORD_TASK_INFO))) {
+        _options.set(_options | uint8_t(Options::RECORD_TASK_INFO));
+        return;
+    }
+
+    if (perf_info.get_task_info(0) == nullptr) {
+        return;
+    }
+
+    print_task_info(str, 0, true);
+}
+
+// display the profiler results as collapsed stacks for @SYS/profile.txt and @SYS/profile_samples.txt
+void AP_Scheduler::profile_info(ExpandingString &str, bool samples)
+{
+    // dynamically enable the profiler, results are available on the next read
+    if (!(_options & uint8_t(Options::ENABLE_PROFILER))) {
+        _options.set(_options | uint8_t(Options::ENABLE_PROFILER));
+        str.printf("# profiler enabled\n");
+        return;
+    }
+
+    // always return something as an empty file can't be read
+    str.printf("# %s\n", samples ? "samples" : "self time us");
+    profiler.collapsed_stacks(str, samples);
+}
+#endif  // AP_SCHEDULER_PROFILER_ENABLED
+
+// print a line per task in the order they are run
+void AP_Scheduler::print_task_info(ExpandingString &str, float total_time, bool histogram)
+{
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
     for (uint8_t i = 0; i < _num_tasks; i++) {
         const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
-        const char *task_name;
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (ti == nullptr || task == nullptr) {
+            return;
+        }
 
-        // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
+#if AP_SCHEDULER_PROFILER_ENABLED
+        if (histogram) {
+            ti->print_histogram(task->name, str);
+            continue;
+        }
+#endif
+        ti->print(task->name, total_time, str);
+    }
+}
+
+// return the next task in run order, advancing the offsets into the task lists
+const AP_Scheduler::Task *AP_Scheduler::next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const
+{
+    // determine which of the common task / vehicle task to run
+    bool run_vehicle_task = false;
+    if (vehicle_tasks_offset < _num_vehicle_tasks &&
+        common_tasks_offset < _num_common_tasks) {
+        // still have entries on both lists; compare the
+        // priorities.  In case of a tie the vehicle-specific
+        // entry wins.
+        const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
+        const Task &common_task = _common_tasks[common_tasks_offset];
+        if (vehicle_task.priority <= common_task.priority) {
             run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
-            // this is an error; the outside loop should have terminated
-            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
-            return;
         }
+    } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
+        // out of common tasks to run
+        run_vehicle_task = true;
+    } else if (common_tasks_offset < _num_common_tasks) {
+        // out of vehicle tasks to run
+        run_vehicle_task = false;
+    } else {
+        // this is an error; the caller should have stopped
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return nullptr;
+    }
 
-        if (run_vehicle_task) {
-            task_name = _vehicle_tasks[vehicle_tasks_offset++].name;
-        } else {
-            task_name = _common_tasks[common_tasks_offset++].name;
+    if (run_vehicle_task) {
+        return &_vehicle_tasks[vehicle_tasks_offset++];
+    }
+    return &_common_tasks[common_tasks_offset++];
+}
+
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+/*
+  adaptive scheduling
+
+  Tasks are budgeted by the run time learnt by PerfInfo rather than
+  their static max_time_micros. Time is held back on each tick for
+  due tasks that would slip if not run on this tick, so tasks with
+  slack wait for a later tick instead of crowding them out. Low rate
+  tasks are spread across the ticks of their interval so that tasks
+  of the same rate don't all fall due together.
+ */
+
+// number of ticks over which the load is balanced when phasing tasks
+#define ADAPTIVE_PHASE_TICKS 256
+
+bool AP_Scheduler::adaptive_init()
+{
+    _adaptive = NEW_NOTHROW AdaptiveTask[_num_tasks];
+    if (_adaptive == nullptr) {
+        DEV_PRINTF("Unable to allocate adaptive scheduler\n");
+        return false;
+    }
+    if (!perf_info.allocate_task_runtime(_num_tasks)) {
+        adaptive_free();
+        return false;
+    }
+
+    // static budget on each tick of the tasks phased so far, phasing
+    // is skipped if there is not enough memory
+    uint32_t *load = NEW_NOTHROW uint32_t[ADAPTIVE_PHASE_TICKS];
+
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            break;
+        }
+        AdaptiveTask &a = _adaptive[i];
+        a.fast = task->priority <= MAX_FAST_TASK_PRIORITIES;
+        a.max_time_micros = task->max_time_micros;
+        // the same interval as run() uses
+        uint32_t interval_ticks = (is_zero(task->rate_hz) ? 1 : _loop_rate_hz / task->rate_hz);
+        a.interval_ticks = constrain_int32(interval_ticks, 1, UINT16_MAX);
+
+        if (a.fast || a.interval_ticks == 1 || load == nullptr) {
+            continue;
         }
 
-        ti->print(task_name, total_time, str);
+        // pick the phase whose busiest tick is the least loaded
+        const uint16_t num_phases = MIN(a.interval_ticks, ADAPTIVE_PHASE_TICKS);
+        uint16_t best_phase = 0;
+        uint32_t best_peak = UINT32_MAX;
+        for (uint16_t phase = 0; phase < num_phases; phase++) {
+            uint32_t peak = 0;
+            for (uint32_t t = phase; t < ADAPTIVE_PHASE_TICKS; t += a.interval_ticks) {
+                peak = MAX(peak, load[t]);
+            }
+            if (peak < best_peak) {
+                best_peak = peak;
+                best_phase = phase;
+            }
+        }
+        for (uint32_t t = best_phase; t < ADAPTIVE_PHASE_TICKS; t += a.interval_ticks) {
+            load[t] += a.max_time_micros;
+        }
+
+        // first due best_phase ticks from now
+        _last_run[i] = _tick_counter + best_phase - a.interval_ticks;
     }
+
+    delete[] load;
+    return true;
+}
+
+void AP_Scheduler::adaptive_free()
+{
+    delete[] _adaptive;
+    _adaptive = nullptr;
+    perf_info.free_task_runtime();
+}
+
+// expected run time of a task, capped so that it can always be run in an empty loop
+uint32_t AP_Scheduler::adaptive_budget_us(uint8_t task_index) const
+{
+    uint32_t budget_us = perf_info.get_task_runtime_us(task_index);
+    if (budget_us == 0) {
+        // not learnt yet
+        budget_us = _adaptive[task_index].max_time_micros;
+    }
+    return MIN(budget_us, uint32_t(_loop_period_us));
+}
+
+// total expected run time of the tasks that will slip if not run on this tick
+uint32_t AP_Scheduler::adaptive_urgent_us() const
+{
+    uint32_t urgent_us = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const AdaptiveTask &a = _adaptive[i];
+        if (a.fast) {
+            continue;
+        }
+        const uint16_t dt = _tick_counter - _last_run[i];
+        if (dt + 1U >= a.interval_ticks * 2U) {
+            urgent_us += adaptive_budget_us(i);
+        }
+    }
+    return urgent_us;
+}
+
+// whether a due task fits in the time available, leaving time for
+// the urgent tasks still to come
+bool AP_Scheduler::adaptive_fits(uint8_t task_index, uint16_t dt, uint32_t interval_ticks, uint32_t time_available, uint32_t &urgent_us) const
+{
+    const uint32_t budget_us = adaptive_budget_us(task_index);
+    if (dt + 1U >= interval_ticks * 2U) {
+        // this is an urgent task, release the time held for it
+        urgent_us -= MIN(urgent_us, budget_us);
+        return budget_us <= time_available;
+    }
+    return budget_us + urgent_us <= time_available;
+}
+
+/*
+  ticks late a due task is by that are kept when recording its run, so
+  it stays on the tick it was phased to. Keeping the phase of a task
+  more than half an interval late would make it due again within a
+  few ticks, so it is re-phased from now instead
+ */
+uint16_t AP_Scheduler::adaptive_phase_ticks(uint16_t dt, uint32_t interval_ticks)
+{
+    const uint32_t late_ticks = dt - interval_ticks;
+    return late_ticks <= interval_ticks / 2 ? late_ticks : 0;
 }
+#endif  // AP_SCHEDULER_ADAPTIVE_ENABLED
 
 namespace AP {
 
@@ -29,6 +29,7 @@
 #include <AP_HAL/Util.h>
 #include <AP_Math/AP_Math.h>
 #include "PerfInfo.h"       // loop perf monitoring
+#include "Profiler.h"       // task and scope profiling
 
 #if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_NAME_INITIALIZER(_clazz,_name) .name = #_clazz "::" #_name,
@@ -73,6 +74,8 @@
 
 class AP_Scheduler
 {
+    friend class AP_Scheduler_Test;
+
 public:
     AP_Scheduler();
 
@@ -93,7 +96,9 @@ public:
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        ENABLE_PROFILER = 1 << 1,
+        ADAPTIVE = 1 << 2,
     };
 
     enum FastTaskPriorities {
@@ -189,12 +194,21 @@ public:
     HAL_Semaphore &get_semaphore(void) { return _rsem; }
 
     void task_info(ExpandingString &str);
+#if AP_SCHEDULER_PROFILER_ENABLED
+    void task_histogram(ExpandingString &str);
+    void profile_info(ExpandingString &str, bool samples);
+#endif
 
     static const struct AP_Param::GroupInfo var_info[];
 
     // loop performance monitoring:
     AP::PerfInfo perf_info;
 
+#if AP_SCHEDULER_PROFILER_ENABLED
+    // task and scope profiling:
+    AP::Profiler profiler;
+#endif
+
 private:
     // used to enable scheduler debugging
     AP_Int8 _debug;
@@ -270,6 +284,33 @@ private:
     // the loop rate in case we are well over budget
     uint32_t extra_loop_us;
 
+    // print a line of task info or histogram per task for @SYS files
+    void print_task_info(ExpandingString &str, float total_time, bool histogram);
+
+    // return the next task in run order, advancing the offsets into the task lists
+    const Task *next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const;
+
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // per-task state for adaptive scheduling
+    struct AdaptiveTask {
+        uint16_t interval_ticks;
+        // static budget used until the run time has been learnt
+        uint16_t max_time_micros;
+        bool fast;
+    };
+    AdaptiveTask *_adaptive;
+
+    bool adaptive_init();
+    void adaptive_free();
+    // expected run time of a task
+    uint32_t adaptive_budget_us(uint8_t task_index) const;
+    // total expected run time of the tasks that will slip if not run on this tick
+    uint32_t adaptive_urgent_us() const;
+    // whether a due task fits in the time available
+    bool adaptive_fits(uint8_t task_index, uint16_t dt, uint32_t interval_ticks, uint32_t time_available, uint32_t &urgent_us) const;
+    // ticks late a due task is by that are kept when recording its run
+    static uint16_t adaptive_phase_ticks(uint16_t dt, uint32_t interval_ticks);
+#endif
 
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
@@ -9,3 +9,11 @@
 #ifndef AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED 1
 #endif
+
+#ifndef AP_SCHEDULER_ADAPTIVE_ENABLED
+#define AP_SCHEDULER_ADAPTIVE_ENABLED (AP_SCHEDULER_ENABLED && HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif
+
+#ifndef AP_SCHEDULER_PROFILER_ENABLED
+#define AP_SCHEDULER_PROFILER_ENABLED (AP_SCHEDULER_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || HAL_PROGRAM_SIZE_LIMIT_KB > 1024))
+#endif
@@ -61,9 +61,62 @@ void AP::PerfInfo::free_task_info()
     _num_tasks = 0;
 }
 
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+// allocate the array of learnt task run times for adaptive scheduling
+bool AP::PerfInfo::allocate_task_runtime(uint8_t num_tasks)
+{
+    _task_runtime = NEW_NOTHROW TaskRuntime[num_tasks];
+    if (_task_runtime == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler TaskRuntime\n");
+        _num_task_runtimes = 0;
+        return false;
+    }
+    _num_task_runtimes = num_tasks;
+    return true;
+}
+
+void AP::PerfInfo::free_task_runtime()
+{
+    delete[] _task_runtime;
+    _task_runtime = nullptr;
+    _num_task_runtimes = 0;
+}
+
+// moving average and mean deviation with a time constant of 16 runs
+void AP::PerfInfo::TaskRuntime::update(uint16_t task_time_us)
+{
+    const int32_t time_us_x16 = int32_t(task_time_us) * 16;
+    if (count == 0) {
+        avg_us_x16 = time_us_x16;
+        dev_us_x16 = 0;
+    }
+    const int32_t err = time_us_x16 - avg_us_x16;
+    avg_us_x16 += err / 16;
+    dev_us_x16 += ((err < 0 ? -err : err) - dev_us_x16) / 16;
+    if (count < UINT8_MAX) {
+        count++;
+    }
+}
+
+// the average plus four mean deviations covers all but the rarest runs
+uint16_t AP::PerfInfo::TaskRuntime::estimate_us() const
+{
+    if (count < 16) {
+        return 0;
+    }
+    return MIN((avg_us_x16 + 4 * dev_us_x16) / 16 + 1, UINT16_MAX);
+}
+#endif  // AP_SCHEDULER_ADAPTIVE_ENABLED
+
 // called after each run of a task to update its statistics based on measurements taken by the scheduler
 void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun)
 {
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    if (_task_runtime != nullptr && task_index < _num_task_runtimes) {
+        _task_runtime[task_index].update(task_time_us);
+    }
+#endif
+
     if (_task_info == nullptr) {
         return;
     }
@@ -89,6 +142,13 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     if (overrun) {
         overrun_count++;
     }
+#if AP_SCHEDULER_PROFILER_ENABLED
+    uint8_t bin = 0;
+    for (uint16_t t = task_time_us >> 3; t != 0 && bin < HISTOGRAM_BINS - 1; t >>= 1) {
+        bin++;
+    }
+    histogram[bin]++;
+#endif
 }
 
 void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
@@ -109,6 +169,21 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
                 unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
 }
 
+#if AP_SCHEDULER_PROFILER_ENABLED
+void AP::PerfInfo::TaskInfo::print_histogram(const char* task_name, ExpandingString& str) const
+{
+#if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
+    str.printf("%-32.32s", task_name);
+#else
+    str.printf("%-16.16s", task_name);
+#endif
+    for (uint8_t i = 0; i < HISTOGRAM_BINS; i++) {
+        str.printf(" %5lu", (unsigned long)histogram[i]);
+    }
+    str.printf("\n");
+}
+#endif
+
 // check_loop_time - check latest loop time vs min, max and overtime threshold
 void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
 {
@@ -21,11 +21,31 @@ public:
         uint32_t tick_count;
         uint16_t slip_count;
         uint16_t overrun_count;
+#if AP_SCHEDULER_PROFILER_ENABLED
+        // runs taking under 8us, 16us, 32us ... 512us and longer
+        static const uint8_t HISTOGRAM_BINS = 8;
+        uint32_t histogram[HISTOGRAM_BINS];
+#endif
 
         void update(uint16_t task_time_us, bool overrun);
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
+#if AP_SCHEDULER_PROFILER_ENABLED
+        void print_histogram(const char* task_name, ExpandingString& str) const;
+#endif
     };
 
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // learnt run time of a task, a moving average and mean deviation
+    struct TaskRuntime {
+        int32_t avg_us_x16;
+        int32_t dev_us_x16;
+        uint8_t count;
+
+        void update(uint16_t task_time_us);
+        uint16_t estimate_us() const;
+    };
+#endif
+
     /* Do not allow copies */
     CLASS_NO_COPY(PerfInfo);
 
@@ -53,6 +73,15 @@ public:
     const TaskInfo* get_task_info(uint8_t task_index) const {
         return (_task_info && task_index < _num_tasks) ? &_task_info[task_index] : nullptr;
     }
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // allocate the array of learnt task run times for adaptive scheduling
+    bool allocate_task_runtime(uint8_t num_tasks);
+    void free_task_runtime();
+    // return the run time a task is expected to stay within, or zero if not yet known
+    uint16_t get_task_runtime_us(uint8_t task_index) const {
+        return (_task_runtime && task_index < _num_task_runtimes) ? _task_runtime[task_index].estimate_us() : 0;
+    }
+#endif
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
     void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
     // record that a task slipped
@@ -77,6 +106,11 @@ private:
     // performance monitoring
     uint8_t _num_tasks;
     TaskInfo* _task_info;
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+    // learnt run times, not cleared by reset()
+    uint8_t _num_task_runtimes;
+    TaskRuntime* _task_runtime;
+#endif
 };
 
 };
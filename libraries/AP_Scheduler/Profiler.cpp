@@ -0,0 +1,176 @@
+#include "AP_Scheduler_config.h"
+
+#if AP_SCHEDULER_PROFILER_ENABLED
+
+#include "Profiler.h"
+#include "AP_Scheduler.h"
+
+#include <AP_HAL/AP_HAL.h>
+
+extern const AP_HAL::HAL& hal;
+
+// start recording, allocating the node table the first time
+bool AP::Profiler::enable()
+{
+    if (_nodes == nullptr) {
+        _nodes = NEW_NOTHROW Node[MAX_NODES];
+        if (_nodes == nullptr) {
+            DEV_PRINTF("Unable to allocate scheduler profiler\n");
+            return false;
+        }
+    }
+    // the node table is never freed as the timer may be sampling it
+    if (!_timer_registered) {
+        hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP::Profiler::sample, void));
+        _timer_registered = true;
+    }
+    _current = NONE;
+    _enabled = true;
+    return true;
+}
+
+// called by the scheduler before running a task
+void AP::Profiler::task_start(const char* task_name)
+{
+    if (!_enabled) {
+        return;
+    }
+    _current = find_or_add(NONE, task_name);
+}
+
+// called by the scheduler after running a task, using its measurement of the task time
+void AP::Profiler::task_end(uint32_t time_taken_us)
+{
+    const uint8_t node = _current;
+    if (node != NONE) {
+        _nodes[node].time_us += time_taken_us;
+    }
+    _current = NONE;
+}
+
+// enter the scope called name below the current one
+uint8_t AP::Profiler::scope_enter(const char* name, uint8_t& node)
+{
+    const uint8_t parent = _current;
+    // a calling site is almost always reached from the same parent
+    if (node >= _num_nodes || _nodes[node].parent != parent || _nodes[node].name != name) {
+        node = find_or_add(parent, name);
+        if (node == NONE) {
+            return NONE;
+        }
+    }
+    _current = node;
+    return node;
+}
+
+// leave a scope, adding the time spent in it
+void AP::Profiler::scope_exit(uint8_t node, uint32_t time_taken_us)
+{
+    _nodes[node].time_us += time_taken_us;
+    _current = _nodes[node].parent;
+}
+
+// find the child of parent called name, adding it if there is room
+uint8_t AP::Profiler::find_or_add(uint8_t parent, const char* name)
+{
+    for (uint8_t i = 0; i < _num_nodes; i++) {
+        if (_nodes[i].parent == parent && _nodes[i].name == name) {
+            return i;
+        }
+    }
+
+    const uint8_t depth = parent == NONE ? 1 : _nodes[parent].depth + 1;
+    if (_num_nodes >= MAX_NODES || depth > MAX_DEPTH) {
+        return NONE;
+    }
+
+    Node& n = _nodes[_num_nodes];
+    n.name = name;
+    n.time_us = 0;
+    n.samples = 0;
+    n.parent = parent;
+    n.depth = depth;
+    // only count the node once it is complete as it is read from other threads
+    return _num_nodes++;
+}
+
+// sample the innermost scope, called from the timer thread
+void AP::Profiler::sample()
+{
+    if (!_enabled) {
+        return;
+    }
+    const uint8_t node = _current;
+    if (node == NONE) {
+        _loop_samples++;
+    } else {
+        _nodes[node].samples++;
+    }
+}
+
+// write the self time of each node in microseconds, or the number of times it was sampled,
+// as collapsed stacks for flamegraph.pl
+void AP::Profiler::collapsed_stacks(ExpandingString& str, bool samples) const
+{
+    if (_nodes == nullptr) {
+        return;
+    }
+
+    const uint8_t num_nodes = _num_nodes;
+    for (uint8_t i = 0; i < num_nodes; i++) {
+        uint64_t value;
+        if (samples) {
+            value = _nodes[i].samples;
+        } else {
+            // self time excludes the time spent in children
+            uint64_t child_time_us = 0;
+            for (uint8_t j = 0; j < num_nodes; j++) {
+                if (_nodes[j].parent == i) {
+                    child_time_us += _nodes[j].time_us;
+                }
+            }
+            value = _nodes[i].time_us > child_time_us ? _nodes[i].time_us - child_time_us : 0;
+        }
+        if (value == 0) {
+            continue;
+        }
+
+        // walk up to the task to build the stack
+        uint8_t stack[MAX_DEPTH];
+        uint8_t depth = 0;
+        for (uint8_t n = i; n != NONE && depth < MAX_DEPTH; n = _nodes[n].parent) {
+            stack[depth++] = n;
+        }
+        while (depth > 0) {
+            depth--;
+            str.printf(depth > 0 ? "%s;" : "%s", _nodes[stack[depth]].name);
+        }
+        str.printf(" %llu\n", (unsigned long long)value);
+    }
+
+    if (samples && _loop_samples > 0) {
+        str.printf("[loop] %u\n", unsigned(_loop_samples));
+    }
+}
+
+AP::Profiler::Scope::Scope(const char* name, uint8_t& node) :
+    _node(NONE)
+{
+    // only the main thread runs scheduler tasks, and some programs
+    // using the instrumented libraries have no scheduler at all
+    AP_Scheduler* scheduler = AP_Scheduler::get_singleton();
+    if (scheduler == nullptr || !scheduler->profiler.enabled() || !hal.scheduler->in_main_thread()) {
+        return;
+    }
+    _node = scheduler->profiler.scope_enter(name, node);
+    _start_us = AP_HAL::micros();
+}
+
+AP::Profiler::Scope::~Scope()
+{
+    if (_node != NONE) {
+        AP::scheduler().profiler.scope_exit(_node, AP_HAL::micros() - _start_us);
+    }
+}
+
+#endif  // AP_SCHEDULER_PROFILER_ENABLED
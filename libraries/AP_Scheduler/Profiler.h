@@ -0,0 +1,102 @@
+#pragma once
+
+#include "AP_Scheduler_config.h"
+
+#if AP_SCHEDULER_PROFILER_ENABLED
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
+
+/*
+  profiler for the scheduler tasks and the code they call
+
+  Each scheduler task is the root of a tree of named scopes. Code marks
+  a scope with AP_PROFILE_SCOPE("name") and the time spent in it is
+  added to the node for that position in the tree. A timer also samples
+  the innermost node, which catches the time spent outside of any task.
+
+  Results are written as collapsed stacks, a line of
+  "task;scope;scope value" per node, as read by flamegraph.pl
+ */
+namespace AP {
+
+class Profiler {
+public:
+    Profiler() {}
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(Profiler);
+
+    static const uint8_t MAX_NODES = 128;
+    static const uint8_t MAX_DEPTH = 8;
+    static const uint8_t NONE = 0xFF;
+
+    // start recording, allocating the node table the first time
+    bool enable();
+    void disable() { _enabled = false; }
+    bool enabled() const { return _enabled; }
+
+    // called by the scheduler on the main thread around each task
+    void task_start(const char* task_name);
+    void task_end(uint32_t time_taken_us);
+
+    // enter the scope called name below the current one, node
+    // caches the result for the calling site
+    uint8_t scope_enter(const char* name, uint8_t& node);
+    // leave a scope, adding the time spent in it
+    void scope_exit(uint8_t node, uint32_t time_taken_us);
+
+    // write the self time of each node in microseconds, or the
+    // number of times it was sampled, as collapsed stacks
+    void collapsed_stacks(ExpandingString& str, bool samples) const;
+
+    // times a scope for the lifetime of the object, use via AP_PROFILE_SCOPE()
+    class Scope {
+    public:
+        Scope(const char* name, uint8_t& node);
+        ~Scope();
+
+        /* Do not allow copies */
+        CLASS_NO_COPY(Scope);
+
+    private:
+        uint8_t _node;
+        uint32_t _start_us;
+    };
+
+private:
+    struct Node {
+        const char* name;
+        // total time spent in the scope including its children
+        uint64_t time_us;
+        // timer samples taken while this was the innermost scope
+        uint32_t samples;
+        uint8_t parent;
+        uint8_t depth;
+    };
+
+    uint8_t find_or_add(uint8_t parent, const char* name);
+    // called from the timer thread
+    void sample();
+
+    Node* _nodes;
+    uint8_t _num_nodes;
+    // innermost scope on the main thread
+    volatile uint8_t _current = NONE;
+    // samples taken outside of any task
+    uint32_t _loop_samples;
+    bool _enabled;
+    bool _timer_registered;
+};
+
+};
+
+// time the rest of the enclosing block as a scope of the current task
+#define AP_PROFILE_SCOPE(name) static uint8_t ap_profile_node = AP::Profiler::NONE; AP::Profiler::Scope ap_profile_scope(name, ap_profile_node)
+
+#else
+
+#define AP_PROFILE_SCOPE(name)
+
+#endif  // AP_SCHEDULER_PROFILER_ENABLED
@@ -0,0 +1,190 @@
+#include <AP_gtest.h>
+#include <AP_Scheduler/AP_Scheduler.h>
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SCHEDULER_ADAPTIVE_ENABLED
+
+class AP_Scheduler_Test
+{
+public:
+    // set up the task table and loop rate as init() does, without
+    // starting the scheduler
+    static void setup(AP_Scheduler &s, const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint16_t loop_rate_hz)
+    {
+        s.adaptive_free();
+        delete[] s._last_run;
+        s._loop_rate_hz.set(loop_rate_hz);
+        s._loop_period_us = 1000000UL / loop_rate_hz;
+        s._vehicle_tasks = tasks;
+        s._num_vehicle_tasks = num_tasks;
+        s._common_tasks = nullptr;
+        s._num_common_tasks = 0;
+        s._num_tasks = num_tasks;
+        s._last_run = NEW_NOTHROW uint16_t[num_tasks];
+        s._tick_counter = 100;
+    }
+    static bool adaptive_init(AP_Scheduler &s)
+    {
+        return s.adaptive_init();
+    }
+    // tick a task is first due on
+    static uint16_t first_due(const AP_Scheduler &s, uint8_t task_index)
+    {
+        return s._last_run[task_index] + s._adaptive[task_index].interval_ticks;
+    }
+    static uint16_t interval_ticks(const AP_Scheduler &s, uint8_t task_index)
+    {
+        return s._adaptive[task_index].interval_ticks;
+    }
+    static bool fits(const AP_Scheduler &s, uint8_t task_index, uint16_t dt, uint32_t time_available, uint32_t &urgent_us)
+    {
+        return s.adaptive_fits(task_index, dt, s._adaptive[task_index].interval_ticks, time_available, urgent_us);
+    }
+    static uint32_t urgent_us(AP_Scheduler &s, uint16_t ticks_since_run)
+    {
+        for (uint8_t i = 0; i < s._num_tasks; i++) {
+            s._last_run[i] = s._tick_counter - ticks_since_run;
+        }
+        return s.adaptive_urgent_us();
+    }
+    static uint16_t phase_ticks(uint16_t dt, uint32_t interval_ticks)
+    {
+        return AP_Scheduler::adaptive_phase_ticks(dt, interval_ticks);
+    }
+};
+
+// only one scheduler may be constructed
+static AP_Scheduler scheduler;
+
+#define TEST_TASK(rate_hz, max_time_micros, priority) { AP_Scheduler::task_fn_t(), "test", rate_hz, max_time_micros, priority }
+
+TEST(AP_Scheduler_Adaptive, TaskRuntime)
+{
+    AP::PerfInfo::TaskRuntime runtime {};
+
+    // nothing is known until 16 runs have been seen
+    for (uint8_t i = 0; i < 15; i++) {
+        runtime.update(100);
+        EXPECT_EQ(0U, runtime.estimate_us());
+    }
+    runtime.update(100);
+    EXPECT_EQ(101U, runtime.estimate_us());
+
+    // a task whose run time varies gets a budget above its longer runs
+    for (uint16_t i = 0; i < 500; i++) {
+        runtime.update(i % 2 ? 200 : 100);
+    }
+    EXPECT_GE(runtime.estimate_us(), 200U);
+    EXPECT_LE(runtime.estimate_us(), 400U);
+
+    // and settles back once it stops varying, to within the rounding
+    // of the filter
+    for (uint16_t i = 0; i < 500; i++) {
+        runtime.update(150);
+    }
+    EXPECT_GE(runtime.estimate_us(), 151U);
+    EXPECT_LE(runtime.estimate_us(), 160U);
+
+    // the estimate can't overflow
+    for (uint16_t i = 0; i < 100; i++) {
+        runtime.update(UINT16_MAX);
+    }
+    EXPECT_EQ(UINT16_MAX, runtime.estimate_us());
+}
+
+// tasks of the same rate are put on different ticks of their interval
+TEST(AP_Scheduler_Adaptive, PhaseSpreading)
+{
+    static const AP_Scheduler::Task tasks[] = {
+        TEST_TASK(400, 50, 0),      // fast task
+        TEST_TASK(100, 100, 4),
+        TEST_TASK(100, 100, 6),
+        TEST_TASK(100, 100, 9),
+        TEST_TASK(100, 100, 12),
+        TEST_TASK(50, 100, 15),
+        TEST_TASK(50, 100, 18),
+        TEST_TASK(400, 100, 21),    // runs every tick
+    };
+    AP_Scheduler_Test::setup(scheduler, tasks, ARRAY_SIZE(tasks), 400);
+    ASSERT_TRUE(AP_Scheduler_Test::adaptive_init(scheduler));
+
+    // the 100Hz tasks take one tick each out of every four
+    bool used[4] {};
+    for (uint8_t i = 1; i <= 4; i++) {
+        ASSERT_EQ(4U, AP_Scheduler_Test::interval_ticks(scheduler, i));
+        const uint16_t phase = AP_Scheduler_Test::first_due(scheduler, i) % 4U;
+        EXPECT_FALSE(used[phase]);
+        used[phase] = true;
+    }
+
+    // the 50Hz tasks don't share a tick
+    ASSERT_EQ(8U, AP_Scheduler_Test::interval_ticks(scheduler, 5));
+    EXPECT_NE(AP_Scheduler_Test::first_due(scheduler, 5) % 8U,
+              AP_Scheduler_Test::first_due(scheduler, 6) % 8U);
+
+    // all are first due within their interval
+    for (uint8_t i = 1; i <= 6; i++) {
+        const uint16_t ticks_until_due = AP_Scheduler_Test::first_due(scheduler, i) - 100U;
+        EXPECT_LT(ticks_until_due, AP_Scheduler_Test::interval_ticks(scheduler, i));
+    }
+}
+
+TEST(AP_Scheduler_Adaptive, Fits)
+{
+    static const AP_Scheduler::Task tasks[] = {
+        TEST_TASK(100, 500, 4),
+        TEST_TASK(100, 5000, 6),
+    };
+    AP_Scheduler_Test::setup(scheduler, tasks, ARRAY_SIZE(tasks), 400);
+    ASSERT_TRUE(AP_Scheduler_Test::adaptive_init(scheduler));
+
+    // a task which is on time must leave room for the urgent ones
+    uint32_t urgent_us = 0;
+    EXPECT_TRUE(AP_Scheduler_Test::fits(scheduler, 0, 4, 500, urgent_us));
+    EXPECT_FALSE(AP_Scheduler_Test::fits(scheduler, 0, 4, 499, urgent_us));
+    urgent_us = 300;
+    EXPECT_FALSE(AP_Scheduler_Test::fits(scheduler, 0, 4, 700, urgent_us));
+    EXPECT_TRUE(AP_Scheduler_Test::fits(scheduler, 0, 4, 800, urgent_us));
+    EXPECT_EQ(300U, urgent_us);
+
+    // an urgent task releases the time held back for it
+    urgent_us = 600;
+    EXPECT_TRUE(AP_Scheduler_Test::fits(scheduler, 0, 7, 500, urgent_us));
+    EXPECT_EQ(100U, urgent_us);
+
+    // budgets are capped at the loop period
+    urgent_us = 0;
+    EXPECT_TRUE(AP_Scheduler_Test::fits(scheduler, 1, 4, 2500, urgent_us));
+
+    // tasks become urgent a tick before they would slip
+    EXPECT_EQ(0U, AP_Scheduler_Test::urgent_us(scheduler, 6));
+    EXPECT_EQ(500U + 2500U, AP_Scheduler_Test::urgent_us(scheduler, 7));
+
+    // once learnt, the run time replaces max_time_micros
+    for (uint8_t i = 0; i < 16; i++) {
+        scheduler.perf_info.update_task_info(0, 200, false);
+    }
+    urgent_us = 0;
+    EXPECT_TRUE(AP_Scheduler_Test::fits(scheduler, 0, 4, 201, urgent_us));
+    EXPECT_FALSE(AP_Scheduler_Test::fits(scheduler, 0, 4, 200, urgent_us));
+}
+
+// a late task keeps its phase unless that would make it due again too soon
+TEST(AP_Scheduler_Adaptive, PhaseTicks)
+{
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(1, 1));
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(3, 1));
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(4, 4));
+    EXPECT_EQ(1U, AP_Scheduler_Test::phase_ticks(5, 4));
+    EXPECT_EQ(2U, AP_Scheduler_Test::phase_ticks(6, 4));
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(7, 4));
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(9, 4));
+    EXPECT_EQ(20U, AP_Scheduler_Test::phase_ticks(60, 40));
+    EXPECT_EQ(0U, AP_Scheduler_Test::phase_ticks(61, 40));
+}
+
+#endif  // AP_SCHEDULER_ADAPTIVE_ENABLED
+
+AP_GTEST_MAIN()
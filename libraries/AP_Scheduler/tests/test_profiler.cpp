@@ -0,0 +1,110 @@
+#include <AP_gtest.h>
+#include <AP_Scheduler/Profiler.h>
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SCHEDULER_PROFILER_ENABLED
+
+// nodes are matched on the name pointer, as AP_PROFILE_SCOPE() passes a literal
+static const char* TASK = "task";
+static const char* OTHER_TASK = "other";
+static const char* OUTER = "outer";
+static const char* INNER = "inner";
+
+static const uint8_t NONE = AP::Profiler::NONE;
+
+// enter and leave a scope of the current task or scope, taking time_us
+static void scope(AP::Profiler& profiler, const char* name, uint8_t& node, uint32_t time_us)
+{
+    const uint8_t n = profiler.scope_enter(name, node);
+    ASSERT_NE(n, NONE);
+    profiler.scope_exit(n, time_us);
+}
+
+// the self time of a node excludes the time spent in its children
+TEST(Profiler, SelfTime)
+{
+    // static like the scheduler's, as the timer keeps a pointer to it
+    static AP::Profiler profiler;
+    ASSERT_TRUE(profiler.enable());
+
+    uint8_t outer_node = NONE;
+    uint8_t inner_node = NONE;
+    for (uint8_t i = 0; i < 2; i++) {
+        profiler.task_start(TASK);
+        const uint8_t outer = profiler.scope_enter(OUTER, outer_node);
+        scope(profiler, INNER, inner_node, 10);
+        profiler.scope_exit(outer, 30);
+        profiler.task_end(100);
+    }
+
+    ExpandingString str;
+    profiler.collapsed_stacks(str, false);
+    EXPECT_STREQ("task 140\n"
+                 "task;outer 40\n"
+                 "task;outer;inner 20\n", str.get_string());
+}
+
+// a scope reached from different tasks or scopes gets a stack for each
+TEST(Profiler, Stacks)
+{
+    static AP::Profiler profiler;
+    ASSERT_TRUE(profiler.enable());
+
+    // the calling site caches its node, which must not be reused for another parent
+    uint8_t inner_node = NONE;
+    uint8_t outer_node = NONE;
+
+    profiler.task_start(TASK);
+    scope(profiler, INNER, inner_node, 5);
+    profiler.task_end(5);
+
+    profiler.task_start(OTHER_TASK);
+    const uint8_t outer = profiler.scope_enter(OUTER, outer_node);
+    scope(profiler, INNER, inner_node, 7);
+    profiler.scope_exit(outer, 10);
+    profiler.task_end(12);
+
+    // nodes without any self time are left out
+    ExpandingString str;
+    profiler.collapsed_stacks(str, false);
+    EXPECT_STREQ("task;inner 5\n"
+                 "other 2\n"
+                 "other;outer 3\n"
+                 "other;outer;inner 7\n", str.get_string());
+
+    // nothing has been sampled by the timer
+    ExpandingString samples;
+    profiler.collapsed_stacks(samples, true);
+    EXPECT_EQ(0u, samples.get_length());
+}
+
+// scopes nested deeper than MAX_DEPTH are not recorded and count towards their parent
+TEST(Profiler, MaxDepth)
+{
+    static AP::Profiler profiler;
+    ASSERT_TRUE(profiler.enable());
+
+    uint8_t nodes[AP::Profiler::MAX_DEPTH];
+    uint8_t entered[AP::Profiler::MAX_DEPTH];
+    profiler.task_start(TASK);
+    for (uint8_t i = 0; i < AP::Profiler::MAX_DEPTH; i++) {
+        nodes[i] = NONE;
+        entered[i] = profiler.scope_enter(OUTER, nodes[i]);
+    }
+    EXPECT_NE(entered[AP::Profiler::MAX_DEPTH - 2], NONE);
+    EXPECT_EQ(entered[AP::Profiler::MAX_DEPTH - 1], NONE);
+    for (int8_t i = AP::Profiler::MAX_DEPTH - 2; i >= 0; i--) {
+        profiler.scope_exit(entered[i], 1);
+    }
+    profiler.task_end(1);
+
+    ExpandingString str;
+    profiler.collapsed_stacks(str, false);
+    EXPECT_STREQ("task;outer;outer;outer;outer;outer;outer;outer 1\n", str.get_string());
+}
+
+#endif  // AP_SCHEDULER_PROFILER_ENABLED
+
+AP_GTEST_MAIN()
@@ -58,7 +58,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Terrain options
     // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download
+    // @Bitmask: 0:Disable Download,1:Memory map terrain files (Linux and SITL only)
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -85,6 +85,16 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+    // @Param: PF_TIME
+    // @DisplayName: Terrain prefetch time
+    // @Description: How many seconds of flight ahead of the vehicle to load terrain blocks from the SD card into memory. Blocks are read along the current mission leg when flying a mission, otherwise along the ground track. Prefetching only happens when TERRAIN_CACHE_SZ is more than 10. A value of zero disables prefetching.
+    // @Units: s
+    // @Range: 0 600
+    // @User: Advanced
+    AP_GROUPINFO("PF_TIME",  6, AP_Terrain, prefetch_time, 120),
+#endif
+
     AP_GROUPEND
 };
 
@@ -135,8 +145,54 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     calculate_grid_info(loc, info);
 
     // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
+    bool found = false;
+    bool have_height = false;
+#if AP_TERRAIN_MMAP_ENABLED
+    if (options.get() & uint16_t(Options::MemoryMap)) {
+        // keep the mapping in place till we are done with the block
+        WITH_SEMAPHORE(mmap_sem);
+        const struct grid_block *gridp = mmap_find_block(info);
+        if (gridp != nullptr) {
+            lookup_hits++;
+            found = true;
+            have_height = interpolate_height(*gridp, info, height);
+        }
+    }
+#endif
+    if (!found) {
+        const struct grid_cache &gcache = find_grid_cache(info);
+        if (gcache.state == GRID_CACHE_DISKWAIT) {
+            lookup_misses++;
+        } else {
+            lookup_hits++;
+        }
+        have_height = interpolate_height(gcache.grid, info, height);
+    }
+    if (!have_height) {
+        return false;
+    }
+
+    if (loc.lat == ahrs.get_home().lat &&
+        loc.lng == ahrs.get_home().lng) {
+        // remember home altitude as a special case
+        home_height = height;
+        home_loc = loc;
+        have_home_height = true;
+    }
+
+    if (corrected && have_reference_offset) {
+        height += reference_offset;
+    }
+    
+    return true;
+}
 
+/*
+  interpolate the height at a position within a grid block, returning
+  false if the block doesn't have all 4 surrounding heights
+ */
+bool AP_Terrain::interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -168,18 +224,6 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 
     height = avg;
 
-    if (loc.lat == ahrs.get_home().lat &&
-        loc.lng == ahrs.get_home().lng) {
-        // remember home altitude as a special case
-        home_height = height;
-        home_loc = loc;
-        have_home_height = true;
-    }
-
-    if (corrected && have_reference_offset) {
-        height += reference_offset;
-    }
-    
     return true;
 }
 
@@ -390,6 +434,9 @@ void AP_Terrain::update(void)
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
+#if AP_TERRAIN_PREFETCH_ENABLED
+        update_prefetch(loc);
+#endif
     } else {
         have_surrounding_tiles = false;
     }
@@ -480,6 +527,9 @@ void AP_Terrain::log_terrain_data()
         pending        : pending,
         loaded         : loaded,
         reference_offset : have_reference_offset?reference_offset:0,
+        hits           : lookup_hits,
+        misses         : lookup_misses,
+        prefetched     : prefetch_count,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
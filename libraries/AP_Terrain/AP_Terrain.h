@@ -23,6 +23,7 @@
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Logger/AP_Logger_config.h>
+#include <AP_HAL/Semaphores.h>
 
 #define TERRAIN_DEBUG 0
 
@@ -47,8 +48,26 @@
 
 // number of grid_blocks in the LRU memory cache
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// companion computers can afford to keep much more in memory
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
+#endif
+
+// number of degree files which can be memory mapped at once
+#ifndef TERRAIN_MMAP_FILES
+#define TERRAIN_MMAP_FILES 4
+#endif
+
+// number of cache blocks kept for the area around the vehicle and
+// home which are not used for prefetching
+#define TERRAIN_PREFETCH_RESERVED 10
+
+// interval between prefetches. Blocks used within this time are not
+// replaced by prefetched blocks
+#define TERRAIN_PREFETCH_INTERVAL_MS 1000
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -318,6 +337,11 @@ private:
     */
     bool check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint8_t idx_y);
 
+    /*
+      interpolate the height at a position within a grid block
+    */
+    bool interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height);
+
 #if HAL_GCS_ENABLED
     /*
       request any missing 4x4 grids from a block
@@ -344,9 +368,10 @@ private:
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
+    bool set_file_path(int8_t lat_degrees, int16_t lon_degrees);
     void open_file(void);
     void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t east_blocks(int8_t lat_degrees, int16_t lon_degrees) const;
     void write_block(void);
     void read_block(void);
 
@@ -368,6 +393,25 @@ private:
      */
     void update_reference_offset(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      find a complete block in the memory mapped degree files. Must
+      be called with mmap_sem held
+     */
+    const struct grid_block *mmap_find_block(const struct grid_info &info);
+    void mmap_update(void);
+    void mmap_file(uint8_t idx, int8_t lat_degrees, int16_t lon_degrees);
+    void mmap_block_written(const struct grid_block &block);
+#endif
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+    /*
+      queue disk reads for blocks ahead of the vehicle
+     */
+    void update_prefetch(const Location &loc);
+    bool prefetch_grid(const struct grid_info &info);
+#endif
+
 
     // parameters
     AP_Int8  enable;
@@ -376,9 +420,13 @@ private:
     AP_Int16 options; // option bits
     AP_Float offset_max;
     AP_Int16 config_cache_size;
+#if AP_TERRAIN_PREFETCH_ENABLED
+    AP_Int16 prefetch_time;
+#endif
 
     enum class Options {
         DisableDownload = (1U<<0),
+        MemoryMap       = (1U<<1),
     };
 
     // cache of grids in memory, LRU
@@ -473,6 +521,44 @@ private:
     // memory allocation status
     bool memory_alloc_failed;
 
+    // height lookups which found their block in memory, and which
+    // had to wait for it to be read
+    uint32_t lookup_hits;
+    uint32_t lookup_misses;
+
+    // number of blocks read ahead of need
+    uint16_t prefetch_count;
+    uint32_t last_prefetch_ms;
+
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      degree files mapped into memory. Complete blocks are used
+      straight from the mapping, anything else goes through the
+      cache. Files are mapped by the IO thread, and mmap_sem protects
+      this from being changed while in use
+     */
+    struct mmap_state {
+        bool in_use;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        const uint8_t *data;    // nullptr if there is no file yet
+        uint32_t length;
+        uint32_t *checked;      // bitmask of blocks with a good CRC
+        uint32_t east_blocks;
+        uint16_t spacing;       // grid_spacing used for east_blocks
+        uint32_t last_access_ms;
+    } mmap_files[TERRAIN_MMAP_FILES];
+    HAL_Semaphore mmap_sem;
+
+    // degree file needed by the main thread
+    bool mmap_want;
+    int8_t mmap_want_lat;
+    int16_t mmap_want_lon;
+
+    // last time the IO thread looked for files changing size
+    uint32_t mmap_check_ms;
+#endif
+
     static AP_Terrain *singleton;
 };
 
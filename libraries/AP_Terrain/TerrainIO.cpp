@@ -131,17 +131,10 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  set file_path to the name of a degree file
  */
-void AP_Terrain::open_file(void)
+bool AP_Terrain::set_file_path(int8_t lat_degrees, int16_t lon_degrees)
 {
-    struct grid_block &block = disk_block.block;
-    if (fd != -1 && 
-        block.lat_degrees == file_lat_degrees &&
-        block.lon_degrees == file_lon_degrees) {
-        // already open on right file
-        return;
-    }
     if (file_path == nullptr) {
         const char* terrain_dir = hal.util->get_custom_terrain_directory();
         if (terrain_dir == nullptr) {
@@ -150,34 +143,53 @@ void AP_Terrain::open_file(void)
         if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
             io_failure = true;
             file_path = nullptr;
-            return;
+            return false;
         }
     }
     if (file_path == nullptr) {
         io_failure = true;
-        return;
+        return false;
     }
     char *p = &file_path[strlen(file_path)-12];
     if (*p != '/') {
         io_failure = true;
-        return;        
+        return false;
     }
     // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
     // thinks there are more digits than there can be so says there's
     // a buffer overflow in the snprintf.  Constrain it long-form:
-    uint32_t lat_tmp = abs((int32_t)block.lat_degrees);
+    uint32_t lat_tmp = abs((int32_t)lat_degrees);
     if (lat_tmp > 99U) {
         lat_tmp = 99U;
     }
-    uint32_t lon_tmp = abs((int32_t)block.lon_degrees);
+    uint32_t lon_tmp = abs((int32_t)lon_degrees);
     if (lon_tmp > 999U) {
         lon_tmp = 999;
     }
     hal.util->snprintf(p, 13, "/%c%02u%c%03u.DAT",
-             block.lat_degrees<0?'S':'N',
+             lat_degrees<0?'S':'N',
              (unsigned)lat_tmp,
-             block.lon_degrees<0?'W':'E',
+             lon_degrees<0?'W':'E',
              (unsigned)lon_tmp);
+    return true;
+}
+
+/*
+  open the current degree file
+ */
+void AP_Terrain::open_file(void)
+{
+    struct grid_block &block = disk_block.block;
+    if (fd != -1 && 
+        block.lat_degrees == file_lat_degrees &&
+        block.lon_degrees == file_lon_degrees) {
+        // already open on right file
+        return;
+    }
+    if (!set_file_path(block.lat_degrees, block.lon_degrees)) {
+        return;
+    }
+    char *p = &file_path[strlen(file_path)-12];
 
     // create directory if need be
     if (!directory_created) {
@@ -217,13 +229,13 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(int8_t lat_degrees, int16_t lon_degrees) const
 {
     Location loc1, loc2;
-    loc1.lat = block.lat_degrees*10*1000*1000L;
-    loc1.lng = block.lon_degrees*10*1000*1000L;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
     loc2.lat = loc1.lat;
-    loc2.lng = (block.lon_degrees+1)*10*1000*1000L;
+    loc2.lng = (lon_degrees+1)*10*1000*1000L;
 
     // shift another two blocks east to ensure room is available
     loc2.offset(0, 2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
@@ -238,7 +250,7 @@ void AP_Terrain::seek_offset(void)
 {
     struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
-    uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
+    uint32_t blocknum = east_blocks(block.lat_degrees, block.lon_degrees) * block.grid_idx_x + block.grid_idx_y;
     uint32_t file_offset = blocknum * sizeof(union grid_io_block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
@@ -263,7 +275,16 @@ void AP_Terrain::write_block(void)
 
     disk_block.block.crc = get_block_crc(disk_block.block);
 
-    ssize_t ret = AP::FS().write(fd, &disk_block, sizeof(disk_block));
+    ssize_t ret;
+    {
+#if AP_TERRAIN_MMAP_ENABLED
+        // lookups hold mmap_sem while using a block from a mapping of
+        // this file, so the block can't change under them
+        WITH_SEMAPHORE(mmap_sem);
+        mmap_block_written(disk_block.block);
+#endif
+        ret = AP::FS().write(fd, &disk_block, sizeof(disk_block));
+    }
     if (ret  != sizeof(disk_block)) {
 #if TERRAIN_DEBUG
         hal.console->printf("write failed - %s\n", strerror(errno));
@@ -351,6 +372,10 @@ void AP_Terrain::io_timer(void)
 
     update_reference_offset();
 
+#if AP_TERRAIN_MMAP_ENABLED
+    mmap_update();
+#endif
+
     switch (disk_io_state) {
     case DiskIoIdle:
     case DiskIoDoneRead:
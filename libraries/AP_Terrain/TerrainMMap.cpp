@@ -0,0 +1,276 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped access to terrain degree files on Linux and SITL
+
+  Complete grid blocks are used straight from the page cache, so a
+  vehicle flying over terrain that is already on disk doesn't need
+  the disk IO state machine or the LRU cache. Blocks which are
+  incomplete or missing still go through the cache so they can be
+  filled in from the GCS and written out as normal. A block written
+  to a mapped file is written with mmap_sem held, so it can't change
+  while in use, and has its CRC checked again before its next use
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  find a complete grid block in a mapped file, asking the IO thread
+  to map the file if needed. Returns nullptr if the block has to come
+  from the cache
+ */
+const AP_Terrain::grid_block *AP_Terrain::mmap_find_block(const struct grid_info &info)
+{
+    if (!(options.get() & uint16_t(Options::MemoryMap))) {
+        return nullptr;
+    }
+
+    struct mmap_state *m = nullptr;
+    for (auto &f : mmap_files) {
+        if (f.in_use &&
+            f.lat_degrees == info.lat_degrees &&
+            f.lon_degrees == info.lon_degrees) {
+            m = &f;
+            break;
+        }
+    }
+    if (m == nullptr) {
+        if (!mmap_want) {
+            mmap_want_lat = info.lat_degrees;
+            mmap_want_lon = info.lon_degrees;
+            mmap_want = true;
+        }
+        return nullptr;
+    }
+    m->last_access_ms = AP_HAL::millis();
+    if (m->data == nullptr) {
+        // no file yet
+        return nullptr;
+    }
+
+    if (m->spacing != grid_spacing) {
+        m->east_blocks = east_blocks(info.lat_degrees, info.lon_degrees);
+        m->spacing = grid_spacing;
+        // block numbers depend on the spacing, so the checks were of other blocks
+        const uint32_t nblocks = m->length / sizeof(union grid_io_block);
+        memset(m->checked, 0, ((nblocks+31)/32) * sizeof(uint32_t));
+    }
+    const uint32_t blocknum = m->east_blocks * info.grid_idx_x + info.grid_idx_y;
+    const uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    if (file_offset + sizeof(union grid_io_block) > m->length) {
+        // past the end of the file when it was mapped
+        return nullptr;
+    }
+
+    const struct grid_block *block = (const struct grid_block *)&m->data[file_offset];
+    if (!TERRAIN_LATLON_EQUAL(block->lat, info.grid_lat) ||
+        !TERRAIN_LATLON_EQUAL(block->lon, info.grid_lon) ||
+        block->spacing != grid_spacing ||
+        block->version != TERRAIN_GRID_FORMAT_VERSION ||
+        (block->bitmap & bitmap_mask) != bitmap_mask) {
+        return nullptr;
+    }
+
+    // check the CRC the first time the block is used
+    const uint32_t word = blocknum / 32;
+    const uint32_t bit = 1U << (blocknum % 32);
+    if (!(m->checked[word] & bit)) {
+        const uint16_t zero = 0;
+        const uint8_t *b = (const uint8_t *)block;
+        const size_t crc_ofs = offsetof(struct grid_block, crc);
+        uint16_t crc = crc16_ccitt(b, crc_ofs, 0);
+        crc = crc16_ccitt((const uint8_t *)&zero, sizeof(zero), crc);
+        crc = crc16_ccitt(&b[crc_ofs+sizeof(zero)], sizeof(struct grid_block)-(crc_ofs+sizeof(zero)), crc);
+        if (crc != block->crc) {
+            return nullptr;
+        }
+        m->checked[word] |= bit;
+    }
+
+    return block;
+}
+
+/*
+  forget the CRC check of a block about to be written by the IO
+  thread, so it is checked again before it is next used from a
+  mapping. Must be called with mmap_sem held
+ */
+void AP_Terrain::mmap_block_written(const struct grid_block &block)
+{
+    const uint32_t blocknum = east_blocks(block.lat_degrees, block.lon_degrees) * block.grid_idx_x + block.grid_idx_y;
+    for (auto &m : mmap_files) {
+        if (m.in_use &&
+            m.checked != nullptr &&
+            m.lat_degrees == block.lat_degrees &&
+            m.lon_degrees == block.lon_degrees &&
+            blocknum < m.length / sizeof(union grid_io_block)) {
+            m.checked[blocknum / 32] &= ~(1U << (blocknum % 32));
+        }
+    }
+}
+
+/*
+  map a degree file into slot idx, replacing what was there. Called
+  from the IO thread
+ */
+void AP_Terrain::mmap_file(uint8_t idx, int8_t lat_degrees, int16_t lon_degrees)
+{
+    const uint8_t *data = nullptr;
+    uint32_t length = 0;
+    uint32_t *checked = nullptr;
+
+    struct stat st;
+    if (set_file_path(lat_degrees, lon_degrees) &&
+        AP::FS().stat(file_path, &st) == 0 &&
+        st.st_size >= (off_t)sizeof(union grid_io_block)) {
+        // on Linux and SITL the local filesystem hands back the
+        // operating system file descriptor
+        const int mfd = AP::FS().open(file_path, O_RDONLY);
+        if (mfd != -1) {
+            length = st.st_size;
+            // read the file in now on the IO thread, rather than
+            // faulting pages in on lookups from the main thread
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            flags |= MAP_POPULATE;
+#endif
+            void *p = mmap(nullptr, length, PROT_READ, flags, mfd, 0);
+            AP::FS().close(mfd);
+#ifndef MAP_POPULATE
+            if (p != MAP_FAILED) {
+                madvise(p, length, MADV_WILLNEED);
+            }
+#endif
+            const uint32_t nblocks = length / sizeof(union grid_io_block);
+            checked = NEW_NOTHROW uint32_t[(nblocks+31)/32]{};
+            if (p == MAP_FAILED || checked == nullptr) {
+                if (p != MAP_FAILED) {
+                    munmap(p, length);
+                }
+                delete[] checked;
+                checked = nullptr;
+                length = 0;
+            } else {
+                data = (const uint8_t *)p;
+            }
+        }
+    }
+
+    struct mmap_state &m = mmap_files[idx];
+    const uint8_t *old_data;
+    uint32_t old_length;
+    uint32_t *old_checked;
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        old_data = m.data;
+        old_length = m.length;
+        old_checked = m.checked;
+        m.in_use = true;
+        m.lat_degrees = lat_degrees;
+        m.lon_degrees = lon_degrees;
+        m.data = data;
+        m.length = length;
+        m.checked = checked;
+        m.spacing = 0;
+        m.last_access_ms = AP_HAL::millis();
+    }
+
+    // nothing can be using the old mapping now
+    if (old_data != nullptr) {
+        munmap(const_cast<uint8_t *>(old_data), old_length);
+    }
+    delete[] old_checked;
+}
+
+/*
+  map files wanted by the main thread, and remap files which have
+  grown as blocks were written. Called from the IO thread
+ */
+void AP_Terrain::mmap_update(void)
+{
+    if (!(options.get() & uint16_t(Options::MemoryMap))) {
+        return;
+    }
+
+    bool want;
+    int8_t want_lat;
+    int16_t want_lon;
+    uint8_t idx = 0;
+    {
+        // last_access_ms is updated by lookups on the main thread
+        WITH_SEMAPHORE(mmap_sem);
+        want = mmap_want;
+        want_lat = mmap_want_lat;
+        want_lon = mmap_want_lon;
+        // use a free slot, or the one used least recently
+        for (uint8_t i=0; i<ARRAY_SIZE(mmap_files); i++) {
+            if (!mmap_files[i].in_use) {
+                idx = i;
+                break;
+            }
+            if (mmap_files[i].last_access_ms < mmap_files[idx].last_access_ms) {
+                idx = i;
+            }
+        }
+    }
+
+    if (want) {
+        mmap_file(idx, want_lat, want_lon);
+        WITH_SEMAPHORE(mmap_sem);
+        mmap_want = false;
+        return;
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - mmap_check_ms < 5000) {
+        return;
+    }
+    mmap_check_ms = now_ms;
+    for (uint8_t i=0; i<ARRAY_SIZE(mmap_files); i++) {
+        bool in_use;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint32_t length;
+        {
+            WITH_SEMAPHORE(mmap_sem);
+            const struct mmap_state &m = mmap_files[i];
+            in_use = m.in_use;
+            lat_degrees = m.lat_degrees;
+            lon_degrees = m.lon_degrees;
+            length = m.length;
+        }
+        struct stat st;
+        if (in_use &&
+            set_file_path(lat_degrees, lon_degrees) &&
+            AP::FS().stat(file_path, &st) == 0 &&
+            uint32_t(st.st_size) != length) {
+            mmap_file(i, lat_degrees, lon_degrees);
+        }
+    }
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
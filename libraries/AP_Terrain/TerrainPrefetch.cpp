@@ -0,0 +1,139 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  read grid blocks from disk ahead of the vehicle, so fast vehicles
+  don't fly into blocks which are still waiting for a disk read
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Mission/AP_Mission.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  make sure a grid block is in the cache, queueing a disk read if it
+  isn't. Returns false if there is no block to replace which hasn't
+  been used since the last prefetch
+ */
+bool AP_Terrain::prefetch_grid(const struct grid_info &info)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    uint16_t oldest_i = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
+            TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
+            cache[i].grid.spacing == grid_spacing) {
+            // already have it, keep it from being the next to go
+            cache[i].last_access_ms = now_ms;
+            return true;
+        }
+        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
+            oldest_i = i;
+        }
+    }
+    if (now_ms - cache[oldest_i].last_access_ms < TERRAIN_PREFETCH_INTERVAL_MS) {
+        // find_grid_cache() would replace a block used by
+        // update_surrounding_tiles(), a home lookup or this prefetch
+        return false;
+    }
+    // this replaces the least recently used block and marks it as
+    // waiting for a disk read
+    find_grid_cache(info);
+    prefetch_count++;
+    return true;
+}
+
+/*
+  once a second, queue disk reads for the blocks the vehicle will
+  reach within TERRAIN_PF_TIME seconds. This follows the leg to the
+  current mission waypoint when flying a mission, otherwise the
+  ground track
+ */
+void AP_Terrain::update_prefetch(const Location &loc)
+{
+    if (prefetch_time <= 0 || grid_spacing <= 0 ||
+        cache_size <= TERRAIN_PREFETCH_RESERVED) {
+        return;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < TERRAIN_PREFETCH_INTERVAL_MS) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+    // the rest of the cache is for the blocks around the vehicle and
+    // home, so only use what is left over
+    const uint8_t max_blocks = cache_size - TERRAIN_PREFETCH_RESERVED;
+
+    const Vector2f &vel = AP::ahrs().groundspeed_vector();
+    const float speed = vel.length();
+    float distance = speed * prefetch_time;
+    Vector2f dir;
+    if (is_positive(speed)) {
+        dir = vel / speed;
+    }
+
+#if AP_MISSION_ENABLED
+    const AP_Mission *mission = AP::mission();
+    if (mission != nullptr && mission->state() == AP_Mission::MISSION_RUNNING) {
+        const Location &target = mission->get_current_nav_cmd().content.location;
+        if (target.lat != 0 || target.lng != 0) {
+            const Vector2f ofs = loc.get_distance_NE(target);
+            const float leg_length = ofs.length();
+            if (is_positive(leg_length)) {
+                // blocks beyond the waypoint are fetched by
+                // update_mission_data()
+                dir = ofs / leg_length;
+                distance = MIN(distance, leg_length);
+            }
+        }
+    }
+#endif
+
+    if (dir.is_zero()) {
+        return;
+    }
+
+    // step at half the size of a block so none are skipped
+    const float step = 0.5 * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+
+    struct grid_info last_info {};
+    uint8_t blocks = 0;
+    Location loc2 = loc;
+    for (float d = step; d <= distance && blocks < max_blocks; d += step) {
+        loc2.offset(dir.x * step, dir.y * step);
+        struct grid_info info;
+        calculate_grid_info(loc2, info);
+        if (info.grid_lat == last_info.grid_lat &&
+            info.grid_lon == last_info.grid_lon) {
+            // still in the same block
+            continue;
+        }
+        last_info = info;
+        blocks++;
+        if (!prefetch_grid(info)) {
+            // the rest of the cache is in use
+            break;
+        }
+    }
+}
+
+#endif // AP_TERRAIN_PREFETCH_ENABLED
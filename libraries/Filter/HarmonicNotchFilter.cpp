@@ -154,6 +154,7 @@ const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
 template <class T>
 HarmonicNotchFilter<T>::~HarmonicNotchFilter() {
     delete[] _filters;
+    delete[] _blocks;
     _num_filters = 0;
     _num_enabled_filters = 0;
 }
@@ -219,8 +220,14 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint32_t harm
 
     if (_num_filters > 0) {
         _filters = NEW_NOTHROW NotchFilter<T>[_num_filters];
-        if (_filters == nullptr) {
-            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
+        _blocks = NEW_NOTHROW FilterBlock[num_blocks(_num_filters)];
+        if (_filters == nullptr || _blocks == nullptr) {
+            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter",
+                          (unsigned int)(_num_filters * sizeof(NotchFilter<T>) + num_blocks(_num_filters) * sizeof(FilterBlock)));
+            delete[] _filters;
+            _filters = nullptr;
+            delete[] _blocks;
+            _blocks = nullptr;
             _num_filters = 0;
         }
     }
@@ -245,15 +252,22 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
       AP_InertialSensor_Backend.cpp to make this thread safe
      */
     auto filters = NEW_NOTHROW NotchFilter<T>[total_notches];
-    if (filters == nullptr) {
+    auto blocks = NEW_NOTHROW FilterBlock[num_blocks(total_notches)];
+    if (filters == nullptr || blocks == nullptr) {
+        delete[] filters;
+        delete[] blocks;
         _alloc_has_failed = true;
         return;
     }
     memcpy(filters, _filters, sizeof(filters[0])*_num_filters);
+    memcpy(blocks, _blocks, sizeof(blocks[0])*num_blocks(_num_filters));
     auto _old_filters = _filters;
+    auto _old_blocks = _blocks;
     _filters = filters;
+    _blocks = blocks;
     _num_filters = total_notches;
     delete[] _old_filters;
+    delete[] _old_blocks;
 }
 
 /*
@@ -387,6 +401,38 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
             set_center_frequency(_num_enabled_filters++, notch_center, 1.0 + _notch_spread, harmonic_mul);
         }
     }
+
+    update_blocks();
+}
+
+/*
+  copy the coefficients of the enabled filters into the blocks used by
+  apply(). Disabled filters, and the unused end of the last block,
+  are given coefficients that pass the input through unchanged. Their
+  delay lines still follow the signal so that there is no glitch when
+  they are enabled
+ */
+template <class T>
+void HarmonicNotchFilter<T>::update_blocks()
+{
+    for (uint16_t i = 0; i < num_blocks(_num_enabled_filters) * _block_filters; i++) {
+        auto &block = _blocks[i / _block_filters];
+        const uint8_t j = i % _block_filters;
+        if (i < _num_enabled_filters && _filters[i].initialised) {
+            const auto &notch = _filters[i];
+            block.b0[j] = notch.b0;
+            block.b1[j] = notch.b1;
+            block.b2[j] = notch.b2;
+            block.a1[j] = notch.a1;
+            block.a2[j] = notch.a2;
+        } else {
+            block.b0[j] = 1;
+            block.b1[j] = 0;
+            block.b2[j] = 0;
+            block.a1[j] = 0;
+            block.a2[j] = 0;
+        }
+    }
 }
 
 /*
@@ -404,25 +450,80 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
     if (dfd == -1) {
         dfd = ::open("notch.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
     }
-#endif
-
-    T output = sample;
     for (uint16_t i = 0; i < _num_enabled_filters; i++) {
-#if NOTCH_DEBUG_LOGGING
         if (!_filters[i].initialised) {
             ::dprintf(dfd, "------- ");
         } else {
             ::dprintf(dfd, "%.4f ", _filters[i]._center_freq_hz);
         }
-#endif
-        output = _filters[i].apply(output);
     }
-#if NOTCH_DEBUG_LOGGING
     if (_num_enabled_filters > 0) {
         ::dprintf(dfd, "\n");
     }
 #endif
-    return output;
+
+    static_assert(sizeof(T) == _num_axes * sizeof(float), "sample must be an array of floats");
+    float output[_num_axes];
+    memcpy(output, &sample, sizeof(output));
+
+    const uint16_t blocks = num_blocks(_num_enabled_filters);
+
+    if (_need_reset) {
+        // pass the sample through, setting every delay line to it so
+        // the following samples are filtered without a glitch
+        for (uint16_t b = 0; b < blocks; b++) {
+            auto &block = _blocks[b];
+            for (uint8_t d = 0; d < 2; d++) {
+                for (uint8_t ax = 0; ax < _num_axes; ax++) {
+                    for (uint8_t j = 0; j < _block_filters; j++) {
+                        block.x[d][ax][j] = output[ax];
+                        block.y[d][ax][j] = output[ax];
+                    }
+                }
+            }
+        }
+        for (uint16_t i = 0; i < _num_filters; i++) {
+            _filters[i].need_reset = false;
+        }
+        _need_reset = false;
+        return sample;
+    }
+
+    // the most recent input and output of each filter is at index n1
+    // and the one before at n2, which is replaced by the new sample
+    const uint8_t n1 = _delay_idx;
+    const uint8_t n2 = n1 ^ 1;
+
+    for (uint16_t b = 0; b < blocks; b++) {
+        auto &block = _blocks[b];
+
+        /*
+          the filters are applied in series, so each has to wait for
+          the output of the one before. Only the b0 term of each
+          output depends on the filter's input, so calculate the rest
+          for the whole block first
+         */
+        float feedback[_num_axes][_block_filters];
+        for (uint8_t ax = 0; ax < _num_axes; ax++) {
+            for (uint8_t j = 0; j < _block_filters; j++) {
+                feedback[ax][j] = block.x[n1][ax][j]*block.b1[j] + block.x[n2][ax][j]*block.b2[j]
+                                - block.y[n1][ax][j]*block.a1[j] - block.y[n2][ax][j]*block.a2[j];
+            }
+        }
+
+        for (uint8_t j = 0; j < _block_filters; j++) {
+            for (uint8_t ax = 0; ax < _num_axes; ax++) {
+                block.x[n2][ax][j] = output[ax];
+                output[ax] = output[ax]*block.b0[j] + feedback[ax][j];
+                block.y[n2][ax][j] = output[ax];
+            }
+        }
+    }
+    _delay_idx = n2;
+
+    T ret;
+    memcpy(&ret, output, sizeof(output));
+    return ret;
 }
 
 /*
@@ -438,6 +539,7 @@ void HarmonicNotchFilter<T>::reset()
     for (uint16_t i = 0; i < _num_filters; i++) {
         _filters[i].reset();
     }
+    _need_reset = true;
 }
 
 #if HAL_LOGGING_ENABLED
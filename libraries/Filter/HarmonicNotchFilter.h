@@ -60,8 +60,46 @@ public:
     void log_notch_centers(uint8_t instance, uint64_t now_us) const;
 
 private:
-    // underlying bank of notch filters
+    // number of floats in a sample, 1 for float and 3 for Vector3f
+    static constexpr uint8_t _num_axes = sizeof(T) / sizeof(float);
+
+    // number of filters in a FilterBlock
+    static constexpr uint8_t _block_filters = 4;
+
+    /*
+      coefficients and delay lines of a block of consecutive filters
+      from _filters, with each coefficient and axis stored as an array
+      across the block so apply() can work on the block with SIMD
+      instructions. The delay lines hold the last two inputs and
+      outputs, _delay_idx selecting the most recent
+     */
+    struct FilterBlock {
+        float b0[_block_filters];
+        float b1[_block_filters];
+        float b2[_block_filters];
+        float a1[_block_filters];
+        float a2[_block_filters];
+        float x[2][_num_axes][_block_filters];
+        float y[2][_num_axes][_block_filters];
+    };
+
+    // number of blocks needed for num_filters filters
+    static uint16_t num_blocks(uint16_t num_filters) {
+        return (num_filters + _block_filters - 1) / _block_filters;
+    }
+
+    // copy filter coefficients into the blocks used by apply()
+    void update_blocks();
+
+    // underlying bank of notch filters, used to calculate the
+    // coefficients for _blocks
     NotchFilter<T>*  _filters;
+    // the filters as applied by apply()
+    FilterBlock* _blocks;
+    // index of the most recent sample in the FilterBlock delay lines
+    uint8_t _delay_idx;
+    // fill the delay lines from the next sample
+    bool _need_reset;
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
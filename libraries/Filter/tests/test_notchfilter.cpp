@@ -363,4 +363,61 @@ TEST(NotchFilterTest, HarmonicNotchTest5)
     fclose(f);
 }
 
+/*
+  setup a harmonic notch with several blocks of filters, the last one
+  partly used
+ */
+template <class T>
+static void setup_multi_notch(HarmonicNotchFilter<T> &f, HarmonicNotchFilterParams &notch_params)
+{
+    const float freqs[] { 60, 73 };
+    notch_params.set_options(uint16_t(HarmonicNotchFilterParams::Options::TripleNotch));
+    notch_params.set_attenuation(40);
+    notch_params.set_bandwidth_hz(30);
+    notch_params.set_center_freq_hz(50);
+    notch_params.set_freq_min_ratio(1.0);
+    f.allocate_filters(ARRAY_SIZE(freqs), 7, notch_params.num_composite_notches());
+    f.init(2000, notch_params);
+    f.update(ARRAY_SIZE(freqs), freqs);
+}
+
+/*
+  test a reset of a harmonic notch gives no glitch with constant input
+ */
+TEST(NotchFilterTest, HarmonicNotchResetTest)
+{
+    HarmonicNotchFilter<float> f {};
+    HarmonicNotchFilterParams notch_params {};
+    setup_multi_notch(f, notch_params);
+    for (uint32_t i=0; i<100; i++) {
+        f.apply(sinf(i * 0.3));
+    }
+    const float const_sample = -0.512;
+    f.reset();
+    for (uint32_t i=0; i<100; i++) {
+        EXPECT_NEAR(f.apply(const_sample), const_sample, 1.0e-5);
+    }
+}
+
+/*
+  test each axis of a Vector3f harmonic notch matches a float harmonic notch
+ */
+TEST(NotchFilterTest, HarmonicNotchVector3fTest)
+{
+    HarmonicNotchFilter<Vector3f> fv {};
+    HarmonicNotchFilter<float> ff[3] {};
+    HarmonicNotchFilterParams notch_params {};
+    setup_multi_notch(fv, notch_params);
+    for (auto &f : ff) {
+        setup_multi_notch(f, notch_params);
+    }
+    for (uint32_t i=0; i<2000; i++) {
+        const Vector3f sample { sinf(i * 0.19), cosf(i * 0.23), 0.3f + sinf(i * 0.41) };
+        const Vector3f v = fv.apply(sample);
+        for (uint8_t axis=0; axis<3; axis++) {
+            EXPECT_FLOAT_EQ(v[axis], ff[axis].apply(sample[axis]));
+        }
+    }
+}
+
 AP_GTEST_MAIN()
@@ -525,6 +525,7 @@ protected:
         // first bit is reserved for: MAVLINK2_SIGNING_DISABLED = (1U << 0),
         NO_FORWARD                = (1U << 1),  // don't forward MAVLink data to or from this device
         NOSTREAMOVERRIDE          = (1U << 2),  // ignore REQUEST_DATA_STREAM messages (eg. from GCSs)
+        STREAM_SCHEDULING         = (1U << 3),  // stretch stream intervals to fit the link bandwidth, and pick buckets from a heap of due times
     };
     bool option_enabled(Option option) const {
         return options & static_cast<uint16_t>(option);
@@ -804,6 +805,7 @@ private:
         LOCKED = (1<<4),
     };
     void log_mavlink_stats();
+    void log_stream_stats();
 
     MAV_RESULT _set_mode_common(const uint8_t base_mode, const uint32_t custom_mode);
 
@@ -874,17 +876,66 @@ private:
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
         uint16_t last_sent_ms; // from AP_HAL::millis16()
+        uint16_t bytes; // bytes written the last time the bucket was sent
     };
-    deferred_message_bucket_t deferred_message_bucket[10];
+    static const uint8_t num_deferred_message_buckets = 10;
+    deferred_message_bucket_t deferred_message_bucket[num_deferred_message_buckets];
     static const uint8_t no_bucket_to_send = -1;
     static const ap_message no_message_to_send = (ap_message)-1;
     uint8_t sending_bucket_id = no_bucket_to_send;
     Bitmask<MSG_LAST> bucket_message_ids_to_send;
+    uint16_t sending_bucket_bytes; // bytes written so far for sending_bucket_id
 
     ap_message next_deferred_bucket_message_to_send(uint16_t now16_ms);
-    void find_next_bucket_to_send(uint16_t now16_ms);
+    void find_next_bucket_to_send(uint32_t now_ms);
     void remove_message_from_bucket(int8_t bucket, ap_message id);
 
+    // with the STREAM_SCHEDULING option, the buckets which have
+    // messages in them, as a binary min-heap ordered by the time each
+    // is next due to be sent. Due times depend on
+    // get_reschedule_interval_ms(), so the heap is rebuilt when the
+    // slowdown it applies changes, and when buckets are allocated or
+    // freed
+    struct {
+        uint32_t due_ms[num_deferred_message_buckets]; // from AP_HAL::millis()
+        uint8_t heap[num_deferred_message_buckets];    // bucket ids
+        uint8_t pos[num_deferred_message_buckets];     // heap position of each bucket
+        uint8_t count;
+        bool valid;
+        // slowdown in use when the due times were calculated:
+        uint16_t stream_slowdown_ms;
+        uint8_t penalty;
+        uint16_t bandwidth_scale;
+    } bucket_schedule;
+    bool bucket_due_before(uint8_t a, uint8_t b) const;
+    void bucket_schedule_swap(uint8_t i, uint8_t j);
+    void bucket_schedule_sift(uint8_t i);
+    void bucket_schedule_set_due(uint8_t bucket, uint32_t now_ms);
+    void bucket_schedule_rebuild(uint32_t now_ms);
+    bool bucket_schedule_current() const;
+
+    // model of the bytes per second this link can carry. With the
+    // STREAM_SCHEDULING option, when the streams would need more than
+    // that their intervals are stretched in proportion so that they
+    // all keep flowing at a lower rate, rather than whichever are due
+    // when the transmit buffer has space getting through
+    struct {
+        uint32_t budget;          // bytes per second available to streams
+        uint32_t demand;          // bytes per second streams need at their requested intervals
+        uint16_t scale = 256;     // stream interval scale factor, 256 is no stretching
+        uint32_t last_update_ms;
+        uint32_t radio_status_ms; // time RADIO_STATUS last received on this link
+    } link_bandwidth;
+    void update_link_bandwidth(uint32_t now_ms);
+
+    // scheduler statistics, reset each time they are logged
+    struct {
+        uint16_t bucket_sends;    // messages sent from buckets
+        uint16_t max_late_ms;     // latest a bucket was sent after it was due
+        uint16_t max_update_us;   // longest time spent in update_send()
+        uint32_t tx_bytes;        // comm_get_tx_bytes() when last logged
+    } stream_stats;
+
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
     Bitmask<MSG_LAST> pushed_ap_message_ids;
@@ -929,6 +980,9 @@ private:
     // When sending parameters and waypoints this may be longer than
     // the interval specified in "deferred"
     uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
+    // factor get_reschedule_interval_ms() multiplies intervals by
+    // while sending parameters, waypoints and ftp replies
+    uint8_t get_reschedule_penalty() const;
 
     bool do_try_send_message(const ap_message id);
 
@@ -1133,6 +1187,7 @@ private:
 #endif
 
     uint32_t last_mavlink_stats_logged;
+    uint32_t last_routes_logged_ms;
 
     uint8_t last_battery_status_idx;
 
@@ -899,6 +899,7 @@ void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
     const uint32_t now = AP_HAL::millis();
 
     last_radio_status.received_ms = now;
+    link_bandwidth.radio_status_ms = now;
     last_radio_status.rssi = packet.rssi;
 
     // record if the GCS has been receiving radio messages from
@@ -1235,29 +1236,39 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
     return false;
 }
 
-uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
+uint8_t GCS_MAVLINK::get_reschedule_penalty() const
 {
-    uint32_t interval_ms = deferred.interval_ms;
-
-    interval_ms += stream_slowdown_ms;
+    uint8_t penalty = 1;
 
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
         // we are sending parameters, penalize streams:
-        interval_ms *= 4;
+        penalty *= 4;
     }
     if (requesting_mission_items()) {
         // we are sending requests for waypoints, penalize streams:
-        interval_ms *= 4;
+        penalty *= 4;
     }
 #if AP_MAVLINK_FTP_ENABLED
     if (AP_HAL::millis() - ftp.last_send_ms < 1000) {
         // we are sending ftp replies
-        interval_ms *= 4;
+        penalty *= 4;
     }
 #endif
 
+    return penalty;
+}
+
+uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
+{
+    // stretch the interval if the streams don't fit in the link:
+    uint32_t interval_ms = uint32_t(deferred.interval_ms) * link_bandwidth.scale / 256;
+
+    interval_ms += stream_slowdown_ms;
+
+    interval_ms *= get_reschedule_penalty();
+
     if (interval_ms > 60000) {
         return 60000;
     }
@@ -1265,8 +1276,134 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
-// typical runtime on fmuv3: 5 microseconds for 3 buckets
-void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
+/*
+  work out the bytes per second this link can give to streams and the
+  bytes per second the streams need, and stretch the stream intervals
+  by the ratio if they need more
+ */
+void GCS_MAVLINK::update_link_bandwidth(uint32_t now_ms)
+{
+    if (now_ms - link_bandwidth.last_update_ms < 100) {
+        return;
+    }
+    link_bandwidth.last_update_ms = now_ms;
+
+    uint32_t budget = _port->bw_in_bytes_per_second();
+    if (link_bandwidth.radio_status_ms != 0 &&
+        now_ms - link_bandwidth.radio_status_ms < 5000) {
+        // there is a telemetry radio on this link
+        budget = budget * (100 - AP_MAVLINK_RADIO_OVERHEAD_PCT) / 100;
+    }
+    budget = budget * AP_MAVLINK_STREAM_BANDWIDTH_PCT / 100;
+    link_bandwidth.budget = budget;
+
+    // the demand is from the requested intervals, not the stretched
+    // ones, so stretching doesn't feed back into it
+    uint32_t demand = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.interval_ms != 0) {
+            demand += uint32_t(bucket.bytes) * 1000U / bucket.interval_ms;
+        }
+    }
+    link_bandwidth.demand = demand;
+
+    uint32_t scale = 256;
+    if (option_enabled(Option::STREAM_SCHEDULING) &&
+        budget > 0 && demand > budget) {
+        // round up to a multiple of 1/8 so small changes in demand
+        // don't keep moving the schedule
+        scale = MIN((demand * 256U / budget + 31U) & ~31U, 256U * 16U);
+    }
+    link_bandwidth.scale = scale;
+}
+
+bool GCS_MAVLINK::bucket_due_before(uint8_t a, uint8_t b) const
+{
+    const int32_t diff = int32_t(bucket_schedule.due_ms[a] - bucket_schedule.due_ms[b]);
+    return diff < 0 || (diff == 0 && a < b);
+}
+
+void GCS_MAVLINK::bucket_schedule_swap(uint8_t i, uint8_t j)
+{
+    const uint8_t bucket_i = bucket_schedule.heap[i];
+    const uint8_t bucket_j = bucket_schedule.heap[j];
+    bucket_schedule.heap[i] = bucket_j;
+    bucket_schedule.heap[j] = bucket_i;
+    bucket_schedule.pos[bucket_j] = i;
+    bucket_schedule.pos[bucket_i] = j;
+}
+
+// move the bucket at heap position i up or down to where its due
+// time belongs
+void GCS_MAVLINK::bucket_schedule_sift(uint8_t i)
+{
+    while (i > 0 && bucket_due_before(bucket_schedule.heap[i], bucket_schedule.heap[(i-1)/2])) {
+        bucket_schedule_swap(i, (i-1)/2);
+        i = (i-1)/2;
+    }
+    while (true) {
+        uint8_t first = i;
+        const uint8_t left = 2*i + 1;
+        const uint8_t right = left + 1;
+        if (left < bucket_schedule.count &&
+            bucket_due_before(bucket_schedule.heap[left], bucket_schedule.heap[first])) {
+            first = left;
+        }
+        if (right < bucket_schedule.count &&
+            bucket_due_before(bucket_schedule.heap[right], bucket_schedule.heap[first])) {
+            first = right;
+        }
+        if (first == i) {
+            break;
+        }
+        bucket_schedule_swap(i, first);
+        i = first;
+    }
+}
+
+void GCS_MAVLINK::bucket_schedule_set_due(uint8_t bucket, uint32_t now_ms)
+{
+    const deferred_message_bucket_t &deferred = deferred_message_bucket[bucket];
+    const uint16_t ms_since_last_sent = uint16_t(now_ms) - deferred.last_sent_ms;
+    bucket_schedule.due_ms[bucket] = now_ms - ms_since_last_sent + get_reschedule_interval_ms(deferred);
+}
+
+bool GCS_MAVLINK::bucket_schedule_current() const
+{
+    return bucket_schedule.valid &&
+        bucket_schedule.stream_slowdown_ms == stream_slowdown_ms &&
+        bucket_schedule.penalty == get_reschedule_penalty() &&
+        bucket_schedule.bandwidth_scale == link_bandwidth.scale;
+}
+
+void GCS_MAVLINK::bucket_schedule_rebuild(uint32_t now_ms)
+{
+    bucket_schedule.count = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        bucket_schedule.pos[i] = no_bucket_to_send;
+        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
+            // no entries
+            continue;
+        }
+        bucket_schedule_set_due(i, now_ms);
+        bucket_schedule.pos[i] = bucket_schedule.count;
+        bucket_schedule.heap[bucket_schedule.count++] = i;
+    }
+    for (int8_t i=bucket_schedule.count/2 - 1; i>=0; i--) {
+        bucket_schedule_sift(i);
+    }
+
+    bucket_schedule.stream_slowdown_ms = stream_slowdown_ms;
+    bucket_schedule.penalty = get_reschedule_penalty();
+    bucket_schedule.bandwidth_scale = link_bandwidth.scale;
+    bucket_schedule.valid = true;
+}
+
+// with the STREAM_SCHEDULING option the bucket due soonest is at the
+// top of bucket_schedule; this only rebuilds the heap if the bucket
+// intervals have changed
+void GCS_MAVLINK::find_next_bucket_to_send(uint32_t now_ms)
 {
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     void *data = hal.scheduler->disable_interrupts_save();
@@ -1275,24 +1412,36 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 
     // all done sending this bucket... find another bucket...
     sending_bucket_id = no_bucket_to_send;
-    uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
-            continue;
+    sending_bucket_bytes = 0;
+    if (option_enabled(Option::STREAM_SCHEDULING)) {
+        if (!bucket_schedule_current()) {
+            bucket_schedule_rebuild(now_ms);
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
-        const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
-        uint16_t ms_before_send_this_bucket;
-        if (ms_since_last_sent > interval) {
-            // should already have sent this bucket!
-            ms_before_send_this_bucket = 0;
-        } else {
-            ms_before_send_this_bucket = interval - ms_since_last_sent;
+        if (bucket_schedule.count > 0) {
+            sending_bucket_id = bucket_schedule.heap[0];
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
-            sending_bucket_id = i;
-            ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+    } else {
+        bucket_schedule.valid = false;
+        const uint16_t now16_ms = now_ms;
+        uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
+        for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+            if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
+                // no entries
+                continue;
+            }
+            const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
+            const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
+            uint16_t ms_before_send_this_bucket;
+            if (ms_since_last_sent > interval) {
+                // should already have sent this bucket!
+                ms_before_send_this_bucket = 0;
+            } else {
+                ms_before_send_this_bucket = interval - ms_since_last_sent;
+            }
+            if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
+                sending_bucket_id = i;
+                ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+            }
         }
     }
     if (sending_bucket_id != no_bucket_to_send) {
@@ -1329,7 +1478,7 @@ ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         AP_HAL::panic("next_deferred_bucket_message_to_send called on empty bucket");
 #endif
-        find_next_bucket_to_send(now16_ms);
+        find_next_bucket_to_send(AP_HAL::millis());
         return no_message_to_send;
     }
     return (ap_message)next;
@@ -1551,6 +1700,8 @@ void GCS_MAVLINK_InProgress::check_tasks()
 
 void GCS_MAVLINK::update_send()
 {
+    const uint32_t update_start_us = AP_HAL::micros();
+
 #if HAL_LOGGING_ENABLED
     if (!hal.scheduler->in_delay_callback()) {
         // AP_Logger will not send log data if we are armed.
@@ -1574,6 +1725,7 @@ void GCS_MAVLINK::update_send()
 
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
+    update_link_bandwidth(start);
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
         if (gcs().out_of_time()) {
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1636,21 +1788,35 @@ void GCS_MAVLINK::update_send()
 
         ap_message next = next_deferred_bucket_message_to_send(start16);
         if (next != no_message_to_send) {
+            const uint32_t tx_bytes = comm_get_tx_bytes(chan);
             if (!do_try_send_message(next)) {
                 break;
             }
+            sending_bucket_bytes += comm_get_tx_bytes(chan) - tx_bytes;
+            stream_stats.bucket_sends++;
             bucket_message_ids_to_send.clear(next);
             if (bucket_message_ids_to_send.count() == 0) {
                 // we sent everything in the bucket.  Reschedule it.
+                deferred_message_bucket_t &bucket = deferred_message_bucket[sending_bucket_id];
+                bucket.bytes = sending_bucket_bytes;
+                const uint16_t interval_ms = get_reschedule_interval_ms(bucket);
+                const uint16_t ms_since_last_sent = start16 - bucket.last_sent_ms;
+                if (ms_since_last_sent > interval_ms) {
+                    stream_stats.max_late_ms = MAX(stream_stats.max_late_ms, ms_since_last_sent - interval_ms);
+                }
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
-                const uint16_t interval_ms = get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
-                deferred_message_bucket[sending_bucket_id].last_sent_ms += interval_ms;
+                bucket.last_sent_ms += interval_ms;
                 // but we do not want to try to catch up too much:
-                if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
-                    deferred_message_bucket[sending_bucket_id].last_sent_ms = start16;
+                if (uint16_t(start16 - bucket.last_sent_ms) > interval_ms) {
+                    bucket.last_sent_ms = start16;
+                }
+                const uint8_t pos = bucket_schedule.pos[sending_bucket_id];
+                if (bucket_schedule_current() && pos < bucket_schedule.count) {
+                    bucket_schedule_set_due(sending_bucket_id, start);
+                    bucket_schedule_sift(pos);
                 }
-                find_next_bucket_to_send(start16);
+                find_next_bucket_to_send(start);
             }
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
                 const uint32_t stop = AP_HAL::micros();
@@ -1678,6 +1844,9 @@ void GCS_MAVLINK::update_send()
     // between the last pass through here
     send_packet_count += uint8_t(_channel_status.current_tx_seq - last_tx_seq);
     last_tx_seq = _channel_status.current_tx_seq;
+
+    const uint32_t update_us = AP_HAL::micros() - update_start_us;
+    stream_stats.max_update_us = MAX(stream_stats.max_update_us, MIN(update_us, UINT16_MAX));
 }
 
 void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
@@ -1687,12 +1856,14 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
         // bucket empty.  Free it:
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
+        deferred_message_bucket[bucket].bytes = 0;
+        bucket_schedule.valid = false;
     }
 
     if (bucket == sending_bucket_id) {
         bucket_message_ids_to_send.clear(id);
         if (bucket_message_ids_to_send.count() == 0) {
-            find_next_bucket_to_send(AP_HAL::millis16());
+            find_next_bucket_to_send(AP_HAL::millis());
         } else {
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
             if (deferred_message_bucket[bucket].interval_ms == 0 &&
@@ -1803,10 +1974,12 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
     }
 
     deferred_message_bucket[closest_bucket].ap_message_ids.set(id);
+    bucket_schedule.valid = false;
 
     if (sending_bucket_id == no_bucket_to_send) {
         sending_bucket_id = closest_bucket;
         bucket_message_ids_to_send = deferred_message_bucket[closest_bucket].ap_message_ids;
+        sending_bucket_bytes = 0;
     }
 
     return true;
@@ -1992,8 +2165,13 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
     if (is_active() || is_streaming()) {
         if (tnow - last_mavlink_stats_logged > 1000) {
             log_mavlink_stats();
+            log_stream_stats();
             last_mavlink_stats_logged = tnow;
         }
+        if (tnow - last_routes_logged_ms > 10000) {
+            routing.log_routes(chan);
+            last_routes_logged_ms = tnow;
+        }
     }
 #endif
 
@@ -2110,6 +2288,41 @@ void GCS_MAVLINK::log_mavlink_stats()
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
+
+/*
+  record stats about the stream scheduler on this link to logger
+*/
+void GCS_MAVLINK::log_stream_stats()
+{
+    const uint32_t tx_bytes = comm_get_tx_bytes(chan);
+    const uint32_t elapsed_ms = MAX(AP_HAL::millis() - last_mavlink_stats_logged, 1U);
+
+    uint8_t buckets = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        if (deferred_message_bucket[i].interval_ms != 0) {
+            buckets++;
+        }
+    }
+
+    const struct log_MAVS pkt{
+        LOG_PACKET_HEADER_INIT(LOG_MAVS_MSG),
+        time_us       : AP_HAL::micros64(),
+        chan          : (uint8_t)chan,
+        budget        : link_bandwidth.budget,
+        demand        : link_bandwidth.demand,
+        tx_rate       : uint32_t(uint64_t(tx_bytes - stream_stats.tx_bytes) * 1000U / elapsed_ms),
+        scale         : uint16_t(link_bandwidth.scale * 100U / 256U),
+        buckets       : buckets,
+        bucket_sends  : stream_stats.bucket_sends,
+        max_late_ms   : stream_stats.max_late_ms,
+        max_update_us : stream_stats.max_update_us,
+    };
+
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    stream_stats = {};
+    stream_stats.tx_bytes = tx_bytes;
+}
 #endif
 
 /*
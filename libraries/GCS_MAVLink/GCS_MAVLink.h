@@ -69,6 +69,10 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len);
 /// @returns		Number of bytes available
 uint16_t comm_get_txspace(mavlink_channel_t chan);
 
+/// Count of bytes written to the nominated MAVLink channel. This
+/// wraps, so callers should only look at differences between calls
+uint32_t comm_get_tx_bytes(mavlink_channel_t chan);
+
 #define MAVLINK_USE_CONVENIENCE_FUNCTIONS
 #include "include/mavlink/v2.0/all/mavlink.h"
 
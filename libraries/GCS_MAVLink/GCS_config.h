@@ -136,3 +136,17 @@
 #ifndef AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED
 #define AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED (HAL_GCS_ENABLED && AP_AHRS_ENABLED)
 #endif  // AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED
+
+// percentage of a link's bandwidth which streamed messages may use
+// before their intervals are stretched to fit, leaving the rest for
+// parameters, mission items, command replies and text
+#ifndef AP_MAVLINK_STREAM_BANDWIDTH_PCT
+#define AP_MAVLINK_STREAM_BANDWIDTH_PCT 80
+#endif
+
+// percentage of a link's serial bandwidth taken up by a telemetry
+// radio's own framing and retransmissions when it is sending
+// RADIO_STATUS
+#ifndef AP_MAVLINK_RADIO_OVERHEAD_PCT
+#define AP_MAVLINK_RADIO_OVERHEAD_PCT 25
+#endif
@@ -27,6 +27,7 @@
 #include "MAVLink_routing.h"
 
 #include <AP_ADSB/AP_ADSB.h>
+#include <AP_Logger/AP_Logger.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -171,11 +172,20 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
+    // forward on any channels matching the targets. A broadcast
+    // looks at every route, otherwise only the routes in the target
+    // system's probe sequence can match
     bool forwarded = false;
     bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
     memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    uint16_t i = broadcast_system ? 0 : route_slot(target_system);
+    for (uint16_t n=0; n<num_route_slots; n++, i=next_route_slot(i)) {
+        if (routes[i].sysid == 0) {
+            if (!broadcast_system) {
+                break;
+            }
+            continue;
+        }
 
         // Skip if channel is private and the target system or component IDs do not match
         GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
@@ -204,7 +214,8 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
                              (int)target_system,
                              (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
+                    _mavlink_resend_uart((mavlink_channel_t)routes[i].channel, &msg);
+                    routes[i].fwd_count++;
                 }
                 sent_to_chan[routes[i].channel] = true;
                 forwarded = true;
@@ -238,18 +249,19 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
 {
     bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
+    // check learned routes to our system ID
+    for (uint16_t i=route_slot(mavlink_system.sysid); routes[i].sysid != 0; i=next_route_slot(i)) {
         if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
+            // another system in the same probe sequence
             continue;
         }
-        if (sent_to_chan[routes[i].channel]) {
+        const mavlink_channel_t channel = (mavlink_channel_t)routes[i].channel;
+        if (sent_to_chan[channel]) {
             // we've already send it on this link
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
@@ -266,13 +278,14 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
+        sent_to_chan[channel] = true;
+        routes[i].fwd_count++;
     }
 }
 
@@ -283,11 +296,11 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
 bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel)
 {
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].mavtype == mavtype) {
+    for (uint16_t i=0; i<num_route_slots; i++) {
+        if (routes[i].sysid != 0 && routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)routes[i].channel;
             return true;
         }
     }
@@ -302,10 +315,10 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
  */
 bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const
 {
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].mavtype == mavtype) && (routes[i].compid == compid)) {
+    for (uint16_t i=0; i<num_route_slots; i++) {
+        if (routes[i].sysid != 0 && (routes[i].mavtype == mavtype) && (routes[i].compid == compid)) {
             sysid = routes[i].sysid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)routes[i].channel;
             return true;
         }
     }
@@ -317,7 +330,6 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -334,32 +346,92 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         // should also process them locally.
         return;
     }
+    const uint32_t now_ms = AP_HAL::millis();
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    uint16_t i = route_slot(msg.sysid);
+    for (; routes[i].sysid != 0; i=next_route_slot(i)) {
+        route &r = routes[i];
+        if (r.sysid == msg.sysid &&
+            r.compid == msg.compid &&
+            r.channel == in_channel) {
+            if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
             }
-            break;
+            r.last_seen_ms = now_ms;
+            r.rx_count++;
+            return;
         }
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    if (num_routes >= MAVLINK_MAX_ROUTES) {
+        if (!expire_route(now_ms)) {
+            return;
+        }
+        // removing a route can move others into the empty slot
+        for (i=route_slot(msg.sysid); routes[i].sysid != 0; i=next_route_slot(i)) {
         }
-        num_routes++;
+    }
+    route &r = routes[i];
+    r.sysid = msg.sysid;
+    r.compid = msg.compid;
+    r.channel = in_channel;
+    r.mavtype = 0;
+    if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    r.last_seen_ms = now_ms;
+    r.rx_count = 1;
+    r.fwd_count = 0;
+    num_routes++;
 #if ROUTING_DEBUG
-        ::printf("learned route %u %u via %u\n",
-                 (unsigned)msg.sysid,
-                 (unsigned)msg.compid,
-                 (unsigned)in_channel);
+    ::printf("learned route %u %u via %u\n",
+             (unsigned)msg.sysid,
+             (unsigned)msg.compid,
+             (unsigned)in_channel);
 #endif
+}
+
+void MAVLink_routing::remove_route(uint16_t slot)
+{
+    // a route further along the probe sequence can move into the
+    // empty slot unless its own slot lies after the empty one
+    uint16_t i = next_route_slot(slot);
+    for (; routes[i].sysid != 0; i=next_route_slot(i)) {
+        const uint16_t home = route_slot(routes[i].sysid);
+        const bool stays = (slot <= i) ? (slot < home && home <= i) : (slot < home || home <= i);
+        if (stays) {
+            continue;
+        }
+        routes[slot] = routes[i];
+        slot = i;
     }
+    routes[slot].sysid = 0;
+    num_routes--;
+}
+
+bool MAVLink_routing::expire_route(uint32_t now_ms)
+{
+    uint16_t oldest = num_route_slots;
+    for (uint16_t i=0; i<num_route_slots; i++) {
+        if (routes[i].sysid == 0) {
+            continue;
+        }
+        if (oldest == num_route_slots ||
+            now_ms - routes[i].last_seen_ms > now_ms - routes[oldest].last_seen_ms) {
+            oldest = i;
+        }
+    }
+    if (oldest == num_route_slots ||
+        now_ms - routes[oldest].last_seen_ms < MAVLINK_ROUTE_TIMEOUT_MS) {
+        return false;
+    }
+#if ROUTING_DEBUG
+    ::printf("expired route %u %u via %u\n",
+             (unsigned)routes[oldest].sysid,
+             (unsigned)routes[oldest].compid,
+             (unsigned)routes[oldest].channel);
+#endif
+    remove_route(oldest);
+    return true;
 }
 
 
@@ -382,7 +454,7 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
+    for (uint16_t i=route_slot(msg.sysid); routes[i].sysid != 0; i=next_route_slot(i)) {
         if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
             mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
         }
@@ -413,6 +485,34 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
 }
 
 
+#if HAL_LOGGING_ENABLED
+/*
+  write the routes learned on a channel to the log
+*/
+void MAVLink_routing::log_routes(mavlink_channel_t channel) const
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint16_t i=0; i<num_route_slots; i++) {
+        const route &r = routes[i];
+        if (r.sysid == 0 || r.channel != channel) {
+            continue;
+        }
+        const struct log_MAVR pkt{
+            LOG_PACKET_HEADER_INIT(LOG_MAVR_MSG),
+            time_us      : AP_HAL::micros64(),
+            chan         : (uint8_t)channel,
+            sysid        : r.sysid,
+            compid       : r.compid,
+            mavtype      : r.mavtype,
+            last_seen_ms : now_ms - r.last_seen_ms,
+            rx_count     : r.rx_count,
+            fwd_count    : r.fwd_count,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+#endif
+
 /*
   extract target sysid and compid from a message. int16_t is used so
   that the caller can set them to -1 and know when a sysid or compid
@@ -5,9 +5,28 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
+// boards with room for it get enough routes for a companion computer
+// with several components or a small swarm
+#ifndef MAVLINK_MAX_ROUTES
+#if HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#define MAVLINK_MAX_ROUTES 64
+#else
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// when the routing table is full, a route which hasn't been seen for
+// this long is replaced by a new one
+#ifndef MAVLINK_ROUTE_TIMEOUT_MS
+#define MAVLINK_ROUTE_TIMEOUT_MS 30000
+#endif
+
+// smallest power of two at least 1.5 times the number of routes,
+// keeping the probe sequences in the routing table short
+static constexpr uint16_t mavlink_route_table_size(uint16_t size=1)
+{
+    return size >= MAVLINK_MAX_ROUTES + MAVLINK_MAX_ROUTES/2 ? size : mavlink_route_table_size(size*2);
+}
 
 /*
   object to handle MAVLink packet routing
@@ -49,16 +68,41 @@ public:
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
+    // write the routes learned on a channel to the log
+    void log_routes(mavlink_channel_t channel) const;
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // open-addressed hash table of routes, using linear probing from
+    // a slot chosen by sysid. All the routes to a sysid are between
+    // its slot and the next empty slot, so forwarding to a system
+    // only looks at those. A sysid of zero marks an empty slot
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
+        uint8_t channel;
         uint8_t mavtype;
-    } routes[MAVLINK_MAX_ROUTES];
+        uint32_t last_seen_ms;
+        uint32_t rx_count;  // packets received from this sysid/compid on this channel
+        uint32_t fwd_count; // packets forwarded on this channel to reach this sysid/compid
+    };
+    static const uint16_t num_route_slots = mavlink_route_table_size();
+    route routes[num_route_slots];
+
+    static uint16_t route_slot(uint8_t sysid) {
+        return (sysid * 157U) & (num_route_slots - 1);
+    }
+    static uint16_t next_route_slot(uint16_t slot) {
+        return (slot + 1) & (num_route_slots - 1);
+    }
+
+    // remove the route in slot, moving later routes in its probe
+    // sequence up to fill the gap
+    void remove_route(uint16_t slot);
+
+    // remove the least recently seen route if it has timed out,
+    // returns true if a route was removed
+    bool expire_route(uint32_t now_ms);
     
     // a channel mask to block routing as required
     uint8_t no_route_mask;